@@ -32,6 +32,15 @@ var vbatBufFloat32 = new Float32Array(vbatBuf);
 var vbatBufPrevFloat32 = new Float32Array(vbatBufPrev);
 var axisWidth;
 var axisHeight;
+var telemBuf = []; // Received bytes not decoded yet
+var telemPayloadSize = [14,28,16,16,32,12,16,4]; // Bytes per telemetry channel (4 motor outputs)
+var telemFields = [7,7,4,8,8,3,4,1]; // Fields per channel
+var telemType = ['int16','float','float','uint16','float','float','uint32','float'];
+var telemScale = [[1], [16,16,16,1000,1000,1000,100], [100], [1], [1000], [16], [1], [1000]]; // Quantisation of the float fields (delta frames)
+var telemLast = [[],[],[],[],[],[],[],[]]; // Last values of the delta frames
+var telemCount = [-1,-1,-1,-1,-1,-1,-1,-1]; // Count of the last payload, -1 to wait for a keyframe
+var telemChannel = 0;
+var telemPlot;
 
 onload = function(){
 	document.getElementById('readcfg').onclick = readConfig;
@@ -178,8 +187,7 @@ function startPlot(){
 		ctx.moveTo(axisWidth,      canvas.height*3/4);
 		ctx.lineTo(canvas.width-1, canvas.height*3/4);
 		ctx.stroke();
-		chrome.serial.onReceive.addListener(updatePlotSensor);
-		regUint32Write(3,2+(31<<8));
+		telemetryStart(1, updatePlotSensor);
 	} else if (document.getElementById('plotselin').value == 'Receiver'){
 		axisWidth = 12;
 		ctx.beginPath();
@@ -194,8 +202,7 @@ function startPlot(){
 		ctx.moveTo(axisWidth,      (2.1/2.2)*canvas.height);
 		ctx.lineTo(canvas.width-1, (2.1/2.2)*canvas.height);
 		ctx.stroke();
-		chrome.serial.onReceive.addListener(updatePlotReceiver);
-		regUint32Write(3,5+(31<<8));
+		telemetryStart(4, updatePlotReceiver);
 	} else if (document.getElementById('plotselin').value == 'Motors'){
 		axisWidth = 26;
 		ctx.beginPath();
@@ -225,8 +232,7 @@ function startPlot(){
 		ctx.moveTo(axisWidth,      (9750/10000)*canvas.height);
 		ctx.lineTo(canvas.width-1, (9750/10000)*canvas.height);
 		ctx.stroke();
-		chrome.serial.onReceive.addListener(updatePlotMotor);
-		regUint32Write(3,8+(31<<8));
+		telemetryStart(6, updatePlotMotor);
 	} else if (document.getElementById('plotselin').value == 'Vbat'){
 		axisWidth = 20;
 		ctx.beginPath();
@@ -244,17 +250,13 @@ function startPlot(){
 		ctx.moveTo(axisWidth,      (7  /8)*canvas.height);
 		ctx.lineTo(canvas.width-1, (7  /8)*canvas.height);
 		ctx.stroke();
-		chrome.serial.onReceive.addListener(updatePlotVbat);
-		regUint32Write(3,3+(3<<8));
+		telemetryStart(7, updatePlotVbat);
 	}
 }
 
 function stopPlot(){
 	regUint32Write(3,0);
-	chrome.serial.onReceive.removeListener(updatePlotSensor);
-	chrome.serial.onReceive.removeListener(updatePlotReceiver);
-	chrome.serial.onReceive.removeListener(updatePlotMotor);
-	chrome.serial.onReceive.removeListener(updatePlotVbat);
+	chrome.serial.onReceive.removeListener(telemetryDecode);
 	chrome.serial.onReceive.addListener(serRead);
 	
 	document.getElementById('plotstart').value = 'Plot';
@@ -656,6 +658,121 @@ function setTxBufValFloat32(data){
 	txBufUint8[5] = txBufValUint8[3];
 }
 
+// Select one telemetry channel (bit of the DEBUG register) and plot its payloads
+function telemetryStart(channel, plot){
+	telemBuf = [];
+	telemCount = [-1,-1,-1,-1,-1,-1,-1,-1];
+	telemChannel = channel;
+	telemPlot = plot;
+	chrome.serial.onReceive.addListener(telemetryDecode);
+	regUint32Write(3, 1 << channel);
+}
+
+// Frame: sync (A5 5A, or A5 5B for delta frames), payload size, channels, sequence, time (us), payloads by increasing channel, CRC16
+function telemetryDecode(info){
+	var x = new Uint8Array(info.data);
+	var i, k, n, m, len, payload, delta;
+	
+	for (i=0; i<x.length; i++)
+		telemBuf.push(x[i]);
+	
+	k = 0;
+	while (telemBuf.length - k >= 11) {
+		if ((telemBuf[k] != 0xA5) || ((telemBuf[k+1] != 0x5A) && (telemBuf[k+1] != 0x5B))) {
+			k++;
+			continue;
+		}
+		len = telemBuf[k+2];
+		if (telemBuf.length - k < 11 + len)
+			break;
+		if (crc16(telemBuf.slice(k+2, k+9+len)) != (telemBuf[k+9+len] | (telemBuf[k+10+len] << 8))) {
+			k++;
+			continue;
+		}
+		m = k + 9;
+		for (n=0; n<8; n++) {
+			if ((telemBuf[k+3] & (1 << n)) == 0)
+				continue;
+			if (telemBuf[k+1] == 0x5B) {
+				delta = telemetryDelta(n, telemBuf, m);
+				m = delta.next;
+				if ((n == telemChannel) && delta.payload)
+					telemPlot({data: delta.payload});
+				continue;
+			}
+			if (n == telemChannel) {
+				payload = new Uint8Array(telemBuf.slice(m, m + telemPayloadSize[n]));
+				telemPlot({data: payload.buffer});
+			}
+			m += telemPayloadSize[n];
+		}
+		k += 11 + len;
+	}
+	telemBuf = telemBuf.slice(k);
+}
+
+// Decode the payload of channel n at buf[m] in a delta frame: count byte (bit 7: keyframe) and zig-zag varints
+// Return the raw payload (null after a lost payload, until the next keyframe) and the index of the next payload
+function telemetryDelta(n, buf, m){
+	var i, z, s, value;
+	var count = buf[m] & 0x7F;
+	var key = (buf[m] & 0x80) != 0;
+	var x = [];
+	var payload = new ArrayBuffer(telemPayloadSize[n]);
+	var view = new DataView(payload);
+	
+	m++;
+	for (i=0; i<telemFields[n]; i++) {
+		z = 0;
+		s = 1;
+		while (buf[m] >= 0x80) {
+			z += (buf[m] & 0x7F) * s;
+			s *= 128;
+			m++;
+		}
+		z += buf[m] * s;
+		m++;
+		x.push((z % 2) ? -(z + 1) / 2 : z / 2);
+	}
+	
+	if (!key) {
+		if ((telemCount[n] < 0) || (((count - telemCount[n]) & 0x7F) != 1)) {
+			telemCount[n] = -1;
+			return {payload: null, next: m};
+		}
+		for (i=0; i<x.length; i++)
+			x[i] += telemLast[n][i];
+	}
+	telemLast[n] = x;
+	telemCount[n] = count;
+	
+	for (i=0; i<x.length; i++) {
+		value = x[i];
+		if (telemType[n] == 'int16')
+			view.setInt16(2*i, value, true);
+		else if (telemType[n] == 'uint16')
+			view.setUint16(2*i, value, true);
+		else if (telemType[n] == 'uint32')
+			view.setUint32(4*i, value, true);
+		else
+			view.setFloat32(4*i, value / telemScale[n][Math.min(i, telemScale[n].length - 1)], true);
+	}
+	return {payload: payload, next: m};
+}
+
+// CRC-16/CCITT (polynomial 0x1021, initial value 0xFFFF), as crc16() in the firmware
+function crc16(data){
+	var crc = 0xFFFF;
+	var i, j;
+	
+	for (i=0; i<data.length; i++) {
+		crc ^= data[i] << 8;
+		for (j=0; j<8; j++)
+			crc = (crc & 0x8000) ? (((crc << 1) ^ 0x1021) & 0xFFFF) : ((crc << 1) & 0xFFFF);
+	}
+	return crc;
+}
+
 function changeEndianness(bufIn, bufOut) {
 	var reorderView = new Uint8Array(bufOut);
 	var orderView = new Uint8Array(bufIn);
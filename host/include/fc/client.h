@@ -0,0 +1,61 @@
+#ifndef __FC_CLIENT_H
+#define __FC_CLIENT_H
+
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <string>
+#include <vector>
+
+#include "fc/protocol.h"
+#include "fc/registers.h"
+#include "fc/serial.h"
+
+namespace fc {
+
+// Register access over the host link, the same requests as fc_reg.m
+// The link must be quiet: stop the telemetry (DEBUG = 0) before using it with the other requests
+class client {
+public:
+	explicit client(serial & port, std::chrono::milliseconds timeout = std::chrono::milliseconds(500));
+	
+	uint32_t read(uint8_t addr, target t = target::ram);
+	void write(uint8_t addr, uint32_t data, target t = target::ram);
+	
+	// Split in REG_BLOCK_MAX transfers, each checked with its CRC
+	std::vector<uint32_t> read_block(uint8_t addr, size_t count, target t = target::ram);
+	void write_block(uint8_t addr, const std::vector<uint32_t> & data, target t = target::ram);
+	
+	// Whole map
+	std::vector<uint32_t> read_config(target t = target::ram);
+	
+	// Read-modify-write of fields, the registers written are grouped in as few blocks as possible
+	void write_config(const std::map<std::string, double> & values);
+	
+	// Erase the flash page of the registers and copy the RAM registers to it (save_config.m)
+	void save_config();
+	
+	// Read the blackbox log (BLACKBOX_STATUS__PAGES pages), progress gets the bytes read so far
+	std::vector<uint8_t> blackbox_dump(const std::function<void(size_t, size_t)> & progress = {});
+	
+	// Words of the latency trace (LATENCY_SIZE), in REG_BLOCK_MAX transfers: the firmware may update it in between
+	std::vector<uint32_t> read_latency();
+	
+	// DEBUG = 0 and drop the telemetry still in flight
+	void stop_telemetry();
+	
+	serial & port() { return link; }
+	
+private:
+	void command(uint8_t instr, uint8_t addr, uint32_t data);
+	void receive(uint8_t * data, size_t size, const char * what);
+	std::vector<uint32_t> read_words(uint8_t instr, uint8_t addr, size_t count, const char * what);
+	
+	serial & link;
+	std::chrono::milliseconds timeout;
+};
+
+}
+
+#endif
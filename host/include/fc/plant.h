@@ -0,0 +1,79 @@
+#ifndef __FC_PLANT_H
+#define __FC_PLANT_H
+
+#include <array>
+#include <cstdint>
+#include <random>
+#include <vector>
+
+namespace fc {
+
+// Multirotor model for the SIL build (fcsil): rigid body with 6 degrees of freedom, rotors with a first order lag and
+// a thrust curve, and the MPU6000 measures with noise and rotor vibration.
+// Body frame x forward, y left, z up. The firmware frame (struct sensor_s) has gyro_x = -wy (pitch), gyro_y = wx (roll),
+// gyro_z = wz (yaw) and the specific force on x, y and z, so accel_x = sin(pitch) and accel_y = sin(roll).
+struct plant_params {
+	double mass = 0.5; // kg
+	double arm = 0.08; // m, lever of a mixer coefficient of 1
+	std::array<double, 3> inertia = {{2.5e-3, 2.5e-3, 4.5e-3}}; // kg m2 about x, y and z
+	double thrust_max = 8.0; // N per rotor at full command
+	double thrust_linear = 0.2; // Part of the thrust linear in the rotor speed, the rest is quadratic
+	double torque_ratio = 0.015; // m, reaction torque of a rotor per N of thrust
+	double motor_tau = 0.02; // s, time constant of the rotor speed
+	double drag = 0.2; // N per m/s
+	double rot_drag = 2e-4; // Nm per rad/s
+	double gyro_noise = 0.1; // deg/s RMS
+	double accel_noise = 0.005; // g RMS
+	double gyro_vibration = 5.0; // deg/s at full rotor speed
+	double accel_vibration = 0.5; // g at full rotor speed
+	double rotor_hz = 400.0; // Rotor frequency at full speed
+	double temperature = 35.0; // C
+	uint32_t seed = 1;
+	
+	// Mixer of the firmware for each output (sil_airframe), zero without rotor. The torque of the rotors opposes
+	// the PID output: pitch and roll -arm * coef * thrust, yaw -torque_ratio * coef * thrust
+	std::vector<std::array<double, 3>> mixer;
+	bool dshot = true; // Motor commands: DShot throttle (48 to 2047, 0 stops) or OneShot (0 to 2000)
+};
+
+class plant {
+public:
+	explicit plant(const plant_params & params);
+	
+	// On the ground, level, rotors stopped
+	void reset();
+	
+	// Advance by dt (s) with the motor commands of set_motors, one per output
+	void step(double dt, const uint32_t * motor_raw);
+	
+	// Sample of the sensor in the firmware frame: deg/s, g and C
+	void measure(float gyro[3], float accel[3], float & temperature);
+	
+	// True state: rates in the firmware frame (deg/s), pitch and roll like angle_estimate (deg), world position (m)
+	std::array<double, 3> rate() const;
+	std::array<double, 2> attitude() const;
+	std::array<double, 3> up() const; // World z in the body frame
+	const std::array<double, 3> & position() const { return p; }
+	const std::array<double, 3> & velocity() const { return v; }
+	bool on_ground() const { return ground; }
+	double rotor_speed(size_t i) const { return n[i]; } // 0 to 1
+
+private:
+	double command(uint32_t raw) const;
+	
+	plant_params prm;
+	std::array<double, 3> p;
+	std::array<double, 3> v;
+	std::array<double, 4> q; // Body to world, w x y z
+	std::array<double, 3> w; // rad/s, body frame
+	std::array<double, 3> f; // Specific force, m/s2 body frame
+	std::vector<double> n; // Rotor speeds
+	std::vector<double> phase; // Rotor angles for the vibration
+	bool ground;
+	std::mt19937 rng;
+	std::normal_distribution<double> normal;
+};
+
+}
+
+#endif
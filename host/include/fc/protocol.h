@@ -0,0 +1,63 @@
+#ifndef __FC_PROTOCOL_H
+#define __FC_PROTOCOL_H
+
+#include <cstddef>
+#include <cstdint>
+#include <stdexcept>
+
+namespace fc {
+
+// Host instructions, see reg_access() in sw/src/reg.c
+// Command: instruction, address, data (4 bytes, little endian), the register instructions add 4 for the flash
+enum instr : uint8_t {
+	INSTR_REG_READ = 0,
+	INSTR_REG_WRITE = 1,
+	INSTR_MPU_READ = 2,
+	INSTR_MPU_WRITE = 3,
+	INSTR_FLASH_ERASE = 6,
+	INSTR_REG_BLOCK_READ = 9,
+	INSTR_REG_BLOCK_WRITE = 10,
+	INSTR_BLACKBOX_DUMP = 11,
+	INSTR_LATENCY_READ = 12
+};
+
+enum class target : uint8_t {
+	ram = 0,
+	flash = 1
+};
+
+constexpr size_t HOST_CMD_SIZE = 6;
+constexpr size_t REG_BLOCK_MAX = 14; // Registers per block transfer (one USB packet)
+constexpr size_t BLACKBOX_PAGE_SIZE = 256;
+constexpr size_t BLACKBOX_DUMP_SIZE = 128; // Bytes per dump answer
+
+// Latency trace, struct latency_s in sw/inc/latency.h: ticks per us, us per bin, samples, dropped samples, a histogram
+// per point after the data ready interrupt, then the worst samples (sample number and ticks of each point)
+constexpr size_t LATENCY_NB_POINT = 5;
+constexpr size_t LATENCY_NB_BIN = 32;
+constexpr size_t LATENCY_NB_WORST = 8;
+constexpr size_t LATENCY_HIST = 4; // Word of the first histogram
+constexpr size_t LATENCY_WORST = LATENCY_HIST + (LATENCY_NB_POINT - 1) * LATENCY_NB_BIN;
+constexpr size_t LATENCY_SIZE = LATENCY_WORST + LATENCY_NB_WORST * LATENCY_NB_POINT;
+
+// Link or protocol failure (timeout, CRC, rejected block)
+class error : public std::runtime_error {
+public:
+	using std::runtime_error::runtime_error;
+};
+
+// CRC-16/CCITT (0x1021, init 0xFFFF), as crc16() in sw/src/utils.c
+uint16_t crc16(const uint8_t * data, size_t size);
+
+uint32_t zigzag_encode(int32_t x);
+int32_t zigzag_decode(uint32_t x);
+
+// LEB128: 7 bits per byte, bit 7 set when more bytes follow
+size_t varint_encode(uint8_t * code, uint32_t x);
+
+// Return the bytes used, 0 if the code is truncated
+size_t varint_decode(const uint8_t * code, size_t size, uint32_t & x);
+
+}
+
+#endif
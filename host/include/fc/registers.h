@@ -0,0 +1,63 @@
+#ifndef __FC_REGISTERS_H
+#define __FC_REGISTERS_H
+
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <vector>
+
+namespace fc {
+
+// Register map, generated from matlab/reg/define_fc_reg.m like reg.h and fc_reg.m
+
+enum class field_type {
+	uint8,
+	uint16,
+	uint32,
+	int8,
+	int16,
+	int32,
+	single
+};
+
+struct reg_subf {
+	const char * name;
+	uint8_t msb;
+	uint8_t lsb;
+	field_type type;
+};
+
+struct reg_info {
+	const char * name;
+	uint8_t addr;
+	bool read_only;
+	bool flash;
+	uint32_t dflt;
+	std::vector<reg_subf> subf;
+};
+
+// A register with a single field is named after it (P_PITCH), the fields of the others are REG__SUBF (CTRL__ARM_TEST)
+struct reg_field {
+	std::string name;
+	const reg_info * reg;
+	const reg_subf * subf;
+	bool whole; // Register with several fields, accessed as a whole
+};
+
+const std::vector<reg_info> & reg_map();
+size_t nb_reg();
+
+// Names in the order of fc_reg.info: each register, then its fields
+const std::vector<reg_field> & reg_fields();
+std::optional<reg_field> reg_find(const std::string & name);
+
+// Value of the field in the register word, and the word with the field replaced
+double reg_get(const reg_field & field, uint32_t word);
+uint32_t reg_set(const reg_field & field, uint32_t word, double value);
+
+// %f for float fields, %d otherwise (like read_config.m)
+std::string reg_format(const reg_field & field, uint32_t word);
+
+}
+
+#endif
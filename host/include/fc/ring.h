@@ -0,0 +1,81 @@
+#ifndef __FC_RING_H
+#define __FC_RING_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace fc {
+
+// Lock-free byte ring, one producer thread (serial reader) and one consumer thread (decoder)
+// The capacity is rounded up to a power of 2, one byte is kept free to tell full from empty
+class ring {
+public:
+	explicit ring(size_t capacity)
+	{
+		size_t n = 2;
+		while (n < capacity + 1)
+			n <<= 1;
+		buf.resize(n);
+		mask = n - 1;
+	}
+	
+	// Producer side, return the bytes written (the rest does not fit)
+	size_t push(const uint8_t * data, size_t size)
+	{
+		size_t head = head_.load(std::memory_order_relaxed);
+		size_t tail = tail_.load(std::memory_order_acquire);
+		size_t free = mask - ((head - tail) & mask);
+		size_t i;
+		
+		if (size > free)
+			size = free;
+		for (i=0; i<size; i++)
+			buf[(head + i) & mask] = data[i];
+		head_.store((head + size) & mask, std::memory_order_release);
+		return size;
+	}
+	
+	// Consumer side, return the bytes read
+	size_t pop(uint8_t * data, size_t size)
+	{
+		size_t tail = tail_.load(std::memory_order_relaxed);
+		size_t head = head_.load(std::memory_order_acquire);
+		size_t used = (head - tail) & mask;
+		size_t i;
+		
+		if (size > used)
+			size = used;
+		for (i=0; i<size; i++)
+			data[i] = buf[(tail + i) & mask];
+		tail_.store((tail + size) & mask, std::memory_order_release);
+		return size;
+	}
+	
+	size_t size() const
+	{
+		return (head_.load(std::memory_order_acquire) - tail_.load(std::memory_order_acquire)) & mask;
+	}
+	
+	size_t capacity() const
+	{
+		return mask;
+	}
+	
+	// Consumer side, drop everything received so far
+	void clear()
+	{
+		tail_.store(head_.load(std::memory_order_acquire), std::memory_order_release);
+	}
+	
+private:
+	std::vector<uint8_t> buf;
+	size_t mask;
+	std::atomic<size_t> head_{0}; // Written by the producer
+	std::atomic<size_t> tail_{0}; // Written by the consumer
+};
+
+}
+
+#endif
@@ -0,0 +1,57 @@
+#ifndef __FC_SERIAL_H
+#define __FC_SERIAL_H
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <thread>
+
+#include "fc/ring.h"
+
+namespace fc {
+
+// Serial port (USB CDC or UART), raw 8N1, termios or Win32 (for the Matlab/Octave MEX)
+// A reader thread moves the received bytes to a lock-free ring, so that the capture keeps up while the
+// consumer is busy decoding or writing to disk. Bytes that do not fit in the ring are counted and dropped.
+class serial {
+public:
+	serial(const std::string & path, int baud = 115200, size_t rx_size = 1 << 20);
+	~serial();
+	serial(const serial &) = delete;
+	serial & operator=(const serial &) = delete;
+	
+	void write(const uint8_t * data, size_t size);
+	
+	// Wait for size bytes, return the bytes read before the timeout
+	size_t read(uint8_t * data, size_t size, std::chrono::milliseconds timeout);
+	
+	// Read whatever is available, waiting up to timeout for the first byte
+	size_t read_some(uint8_t * data, size_t size, std::chrono::milliseconds timeout);
+	
+	// Drop the received bytes until the line has been quiet for the given time
+	void drain(std::chrono::milliseconds quiet);
+	
+	uint64_t dropped() const { return rx_dropped.load(); }
+	
+private:
+	void reader();
+	
+#ifdef _WIN32
+	void * handle;
+#else
+	int fd;
+#endif
+	ring rx;
+	std::atomic<bool> running;
+	std::atomic<uint64_t> rx_dropped;
+	std::mutex mutex; // Only for the wake up of read()
+	std::condition_variable cv;
+	std::thread thread;
+};
+
+}
+
+#endif
@@ -0,0 +1,88 @@
+#ifndef __FC_TELEMETRY_H
+#define __FC_TELEMETRY_H
+
+#include <array>
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+#include "fc/registers.h" // field_type
+
+namespace fc {
+
+// Frames of sw/inc/telemetry.h: sync (A5 5A raw, A5 5B delta), payload size, channels, sequence, time (us),
+// payloads by increasing channel, CRC16 of everything after the sync word
+constexpr uint8_t TELEMETRY_SYNC_0 = 0xA5;
+constexpr uint8_t TELEMETRY_SYNC_1 = 0x5A;
+constexpr uint8_t TELEMETRY_SYNC_1_DELTA = 0x5B;
+constexpr uint8_t TELEMETRY_KEYFRAME = 0x80;
+constexpr size_t TELEMETRY_HEADER_SIZE = 9;
+constexpr size_t TELEMETRY_FIELD_MAX = 8;
+constexpr size_t TELEMETRY_NB_CHANNEL = 8;
+
+// Channel n is bit n of DEBUG, the sizes and scales match telemetry_coding in sw/src/telemetry.c (4 motors)
+struct telemetry_channel {
+	const char * name;
+	uint8_t size; // Raw payload
+	uint8_t nb; // Fields
+	field_type type; // int16, uint16, uint32 or single
+	float scale[TELEMETRY_FIELD_MAX]; // Quantisation of the float fields in delta frames
+};
+
+extern const telemetry_channel telemetry_channels[TELEMETRY_NB_CHANNEL];
+
+// The payloads are given as in the raw frames, whatever the frame type
+struct telemetry_frame {
+	uint8_t channels;
+	uint8_t seq;
+	uint32_t time;
+	bool delta;
+	std::array<std::vector<uint8_t>, TELEMETRY_NB_CHANNEL> payload; // Empty if not sent or not decoded
+};
+
+// Fields of a raw payload
+std::vector<double> telemetry_values(uint8_t channel, const std::vector<uint8_t> & payload);
+
+// Stream decoder, keeps the bytes of an incomplete frame and the last values of the delta channels
+// A lost delta payload blanks the channel until its next keyframe
+class telemetry_decoder {
+public:
+	telemetry_decoder();
+	
+	void feed(const uint8_t * data, size_t size, const std::function<void(const telemetry_frame &)> & on_frame);
+	void reset();
+	
+	uint64_t frames() const { return nb_frame; }
+	uint64_t crc_errors() const { return nb_crc; }
+	uint64_t lost() const { return nb_lost; } // Delta payloads not decoded
+	
+private:
+	bool decode_delta(uint8_t channel, const uint8_t * code, size_t size, size_t & used, std::vector<uint8_t> & payload);
+	
+	std::vector<uint8_t> buf;
+	std::array<std::array<int32_t, TELEMETRY_FIELD_MAX>, TELEMETRY_NB_CHANNEL> z; // Last values
+	std::array<int, TELEMETRY_NB_CHANNEL> count; // Last count byte, -1 until a keyframe
+	uint64_t nb_frame;
+	uint64_t nb_crc;
+	uint64_t nb_lost;
+};
+
+// Frame encoder, the same coding as telemetry_add() (used by fcsim)
+class telemetry_encoder {
+public:
+	telemetry_encoder();
+	
+	void start(uint32_t time, bool delta);
+	void add(uint8_t channel, const std::vector<uint8_t> & payload, uint8_t keyframe);
+	std::vector<uint8_t> finish();
+	
+private:
+	std::vector<uint8_t> buf;
+	std::array<std::array<int32_t, TELEMETRY_FIELD_MAX>, TELEMETRY_NB_CHANNEL> z;
+	std::array<uint8_t, TELEMETRY_NB_CHANNEL> count;
+	uint8_t seq;
+};
+
+}
+
+#endif
@@ -0,0 +1,190 @@
+#include "fc/client.h"
+
+#include <algorithm>
+#include <thread>
+
+namespace fc {
+
+client::client(serial & port, std::chrono::milliseconds timeout) :
+	link(port), timeout(timeout)
+{
+}
+
+void client::command(uint8_t instr, uint8_t addr, uint32_t data)
+{
+	uint8_t cmd[HOST_CMD_SIZE] = {instr, addr, (uint8_t)data, (uint8_t)(data >> 8), (uint8_t)(data >> 16), (uint8_t)(data >> 24)};
+	
+	link.write(cmd, HOST_CMD_SIZE);
+}
+
+void client::receive(uint8_t * data, size_t size, const char * what)
+{
+	size_t n = link.read(data, size, timeout);
+	
+	if (n != size)
+		throw error(std::string("fc: ") + what + ": timeout (" + std::to_string(n) + "/" + std::to_string(size) + " bytes)");
+}
+
+uint32_t client::read(uint8_t addr, target t)
+{
+	uint8_t r[4];
+	
+	command((uint8_t)t * 4 + INSTR_REG_READ, addr, 0);
+	receive(r, 4, "read");
+	
+	return r[0] | (r[1] << 8) | (r[2] << 16) | ((uint32_t)r[3] << 24);
+}
+
+void client::write(uint8_t addr, uint32_t data, target t)
+{
+	command((uint8_t)t * 4 + INSTR_REG_WRITE, addr, data);
+}
+
+std::vector<uint32_t> client::read_block(uint8_t addr, size_t count, target t)
+{
+	return read_words((uint8_t)t * 4 + INSTR_REG_BLOCK_READ, addr, count, "block read");
+}
+
+// Blocks of words followed by their CRC
+std::vector<uint32_t> client::read_words(uint8_t instr, uint8_t addr, size_t count, const char * what)
+{
+	std::vector<uint32_t> data(count);
+	uint8_t r[REG_BLOCK_MAX * 4 + 2];
+	size_t k;
+	size_t n;
+	size_t i;
+	
+	for (k=0; k<count; k+=n) {
+		n = std::min(REG_BLOCK_MAX, count - k);
+		command(instr, (uint8_t)(addr + k), (uint32_t)n);
+		receive(r, n * 4 + 2, what);
+		if (crc16(r, n * 4) != (r[n * 4] | (r[n * 4 + 1] << 8)))
+			throw error(std::string("fc: ") + what + " failed at address " + std::to_string(addr + k));
+		for (i=0; i<n; i++)
+			data[k + i] = r[4 * i] | (r[4 * i + 1] << 8) | (r[4 * i + 2] << 16) | ((uint32_t)r[4 * i + 3] << 24);
+	}
+	
+	return data;
+}
+
+void client::write_block(uint8_t addr, const std::vector<uint32_t> & data, target t)
+{
+	uint8_t cmd[HOST_CMD_SIZE + REG_BLOCK_MAX * 4];
+	uint8_t status;
+	uint16_t crc;
+	size_t k;
+	size_t n;
+	size_t i;
+	
+	for (k=0; k<data.size(); k+=n) {
+		n = std::min(REG_BLOCK_MAX, data.size() - k);
+		for (i=0; i<n; i++) {
+			cmd[HOST_CMD_SIZE + 4 * i] = (uint8_t)data[k + i];
+			cmd[HOST_CMD_SIZE + 4 * i + 1] = (uint8_t)(data[k + i] >> 8);
+			cmd[HOST_CMD_SIZE + 4 * i + 2] = (uint8_t)(data[k + i] >> 16);
+			cmd[HOST_CMD_SIZE + 4 * i + 3] = (uint8_t)(data[k + i] >> 24);
+		}
+		crc = crc16(&cmd[HOST_CMD_SIZE], n * 4);
+		cmd[0] = (uint8_t)t * 4 + INSTR_REG_BLOCK_WRITE;
+		cmd[1] = (uint8_t)(addr + k);
+		cmd[2] = (uint8_t)n;
+		cmd[3] = 0;
+		cmd[4] = (uint8_t)crc;
+		cmd[5] = (uint8_t)(crc >> 8);
+		link.write(cmd, HOST_CMD_SIZE + n * 4);
+		receive(&status, 1, "block write");
+		if (status != 0)
+			throw error("fc: block write rejected at address " + std::to_string(addr + k));
+	}
+}
+
+std::vector<uint32_t> client::read_config(target t)
+{
+	return read_block(0, nb_reg(), t);
+}
+
+void client::write_config(const std::map<std::string, double> & values)
+{
+	std::vector<uint32_t> cfg = read_config();
+	std::vector<bool> dirty(cfg.size(), false);
+	size_t a;
+	size_t b;
+	
+	for (const auto & v : values) {
+		std::optional<reg_field> f = reg_find(v.first);
+		if (!f)
+			throw error("fc: unknown register " + v.first);
+		if (f->reg->read_only)
+			throw error("fc: " + v.first + " is read-only");
+		cfg[f->reg->addr] = reg_set(*f, cfg[f->reg->addr], v.second);
+		dirty[f->reg->addr] = true;
+	}
+	
+	// One block per run of consecutive registers, the others are not written back (the firmware may change them)
+	for (a=0; a<cfg.size(); a=b) {
+		if (!dirty[a]) {
+			b = a + 1;
+			continue;
+		}
+		for (b=a+1; (b<cfg.size()) && dirty[b]; b++) {}
+		write_block((uint8_t)a, std::vector<uint32_t>(cfg.begin() + a, cfg.begin() + b));
+	}
+}
+
+void client::save_config()
+{
+	std::vector<uint32_t> cfg = read_config();
+	
+	// The F4 erases a whole sector
+	command(INSTR_FLASH_ERASE, 0, 0);
+	std::this_thread::sleep_for(std::chrono::seconds(3));
+	
+	// The non-flash registers are copied too, reg_init ignores them
+	write_block(0, cfg, target::flash);
+}
+
+std::vector<uint8_t> client::blackbox_dump(const std::function<void(size_t, size_t)> & progress)
+{
+	std::optional<reg_field> status = reg_find("BLACKBOX_STATUS__PAGES");
+	std::vector<uint8_t> log;
+	uint8_t r[1 + BLACKBOX_DUMP_SIZE + 2];
+	size_t size;
+	size_t addr;
+	int retry;
+	
+	size = (size_t)reg_get(*status, read(status->reg->addr)) * BLACKBOX_PAGE_SIZE;
+	log.reserve(size);
+	
+	for (addr=0; addr<size; addr+=BLACKBOX_DUMP_SIZE) {
+		for (retry=0; ; retry++) {
+			command(INSTR_BLACKBOX_DUMP, 0, (uint32_t)addr);
+			receive(r, sizeof(r), "blackbox dump");
+			if ((crc16(r, 1 + BLACKBOX_DUMP_SIZE) == (r[1 + BLACKBOX_DUMP_SIZE] | (r[2 + BLACKBOX_DUMP_SIZE] << 8))) && (r[0] == 0))
+				break;
+			// Busy while a session is being written or the flash is erased
+			if (retry == 10)
+				throw error("fc: blackbox dump failed at " + std::to_string(addr));
+			std::this_thread::sleep_for(std::chrono::milliseconds(100));
+		}
+		log.insert(log.end(), &r[1], &r[1 + BLACKBOX_DUMP_SIZE]);
+		if (progress)
+			progress(log.size(), size);
+	}
+	
+	return log;
+}
+
+std::vector<uint32_t> client::read_latency()
+{
+	return read_words(INSTR_LATENCY_READ, 0, LATENCY_SIZE, "latency read");
+}
+
+void client::stop_telemetry()
+{
+	std::optional<reg_field> debug = reg_find("DEBUG");
+	
+	write(debug->reg->addr, 0);
+	link.drain(std::chrono::milliseconds(100));
+}
+
+}
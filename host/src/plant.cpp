@@ -0,0 +1,196 @@
+#include "fc/plant.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace fc {
+
+constexpr double G = 9.81;
+constexpr double PI = 3.14159265358979323846;
+constexpr double DEG = 180.0 / PI;
+constexpr int SUBSTEPS = 4; // Integration steps per call of step, rotor lag and rates at 4 kHz for 1 kHz samples
+
+plant::plant(const plant_params & params) :
+	prm(params),
+	n(params.mixer.size()),
+	phase(params.mixer.size()),
+	rng(params.seed),
+	normal(0.0, 1.0)
+{
+	reset();
+}
+
+void plant::reset()
+{
+	size_t i;
+	
+	p = {0.0, 0.0, 0.0};
+	v = {0.0, 0.0, 0.0};
+	q = {1.0, 0.0, 0.0, 0.0};
+	w = {0.0, 0.0, 0.0};
+	f = {0.0, 0.0, G};
+	ground = true;
+	// Random rotor angles, evenly spaced ones would cancel their vibrations at the same speed
+	for (i=0; i<n.size(); i++) {
+		n[i] = 0.0;
+		phase[i] = std::uniform_real_distribution<double>(0.0, 2.0 * PI)(rng);
+	}
+}
+
+// Normalised rotor speed requested by a motor command
+double plant::command(uint32_t raw) const
+{
+	if (prm.dshot)
+		return (raw < 48) ? 0.0 : std::min((double)(raw - 48) / 1999.0, 1.0);
+	return std::min((double)raw / 2000.0, 1.0);
+}
+
+std::array<double, 3> plant::up() const
+{
+	return {
+		2.0 * (q[1] * q[3] - q[0] * q[2]),
+		2.0 * (q[2] * q[3] + q[0] * q[1]),
+		1.0 - 2.0 * (q[1] * q[1] + q[2] * q[2])
+	};
+}
+
+void plant::step(double dt, const uint32_t * motor_raw)
+{
+	double h = dt / SUBSTEPS;
+	double lag = 1.0 - std::exp(-h / prm.motor_tau);
+	double r[3][3];
+	double thrust;
+	double t;
+	double yaw;
+	std::array<double, 3> tau_fc; // Firmware axes: pitch, roll and yaw
+	std::array<double, 3> tau;
+	std::array<double, 3> a;
+	std::array<double, 3> dw;
+	std::array<double, 4> dq;
+	size_t i;
+	int j;
+	int k;
+	
+	for (k=0; k<SUBSTEPS; k++) {
+		// Rotors
+		thrust = 0.0;
+		tau_fc = {0.0, 0.0, 0.0};
+		for (i=0; i<n.size(); i++) {
+			const std::array<double, 3> & c = prm.mixer[i];
+			if ((c[0] == 0.0) && (c[1] == 0.0) && (c[2] == 0.0))
+				continue;
+			n[i] += (command(motor_raw[i]) - n[i]) * lag;
+			t = prm.thrust_max * (prm.thrust_linear * n[i] + (1.0 - prm.thrust_linear) * n[i] * n[i]);
+			thrust += t;
+			tau_fc[0] -= prm.arm * c[0] * t;
+			tau_fc[1] -= prm.arm * c[1] * t;
+			tau_fc[2] -= prm.torque_ratio * c[2] * t;
+			phase[i] = std::fmod(phase[i] + 2.0 * PI * prm.rotor_hz * n[i] * h, 2.0 * PI);
+		}
+		tau = {tau_fc[1] - prm.rot_drag * w[0], -tau_fc[0] - prm.rot_drag * w[1], tau_fc[2] - prm.rot_drag * w[2]};
+		
+		// Rotation body to world
+		r[0][0] = 1.0 - 2.0 * (q[2] * q[2] + q[3] * q[3]);
+		r[0][1] = 2.0 * (q[1] * q[2] - q[0] * q[3]);
+		r[0][2] = 2.0 * (q[1] * q[3] + q[0] * q[2]);
+		r[1][0] = 2.0 * (q[1] * q[2] + q[0] * q[3]);
+		r[1][1] = 1.0 - 2.0 * (q[1] * q[1] + q[3] * q[3]);
+		r[1][2] = 2.0 * (q[2] * q[3] - q[0] * q[1]);
+		r[2][0] = 2.0 * (q[1] * q[3] - q[0] * q[2]);
+		r[2][1] = 2.0 * (q[2] * q[3] + q[0] * q[1]);
+		r[2][2] = 1.0 - 2.0 * (q[1] * q[1] + q[2] * q[2]);
+		for (j=0; j<3; j++)
+			a[j] = (r[j][2] * thrust - prm.drag * v[j]) / prm.mass;
+		a[2] -= G;
+		
+		// Held by the ground until the thrust lifts the weight
+		if (ground) {
+			if (a[2] <= 0.0) {
+				f = up();
+				for (j=0; j<3; j++)
+					f[j] *= G;
+				continue;
+			}
+			ground = false;
+		}
+		
+		// Euler equations, then the attitude and the position
+		for (j=0; j<3; j++)
+			dw[j] = tau[j] - (w[(j+1)%3] * prm.inertia[(j+2)%3] * w[(j+2)%3] - w[(j+2)%3] * prm.inertia[(j+1)%3] * w[(j+1)%3]);
+		for (j=0; j<3; j++)
+			w[j] += dw[j] / prm.inertia[j] * h;
+		dq[0] = -q[1] * w[0] - q[2] * w[1] - q[3] * w[2];
+		dq[1] =  q[0] * w[0] + q[2] * w[2] - q[3] * w[1];
+		dq[2] =  q[0] * w[1] + q[3] * w[0] - q[1] * w[2];
+		dq[3] =  q[0] * w[2] + q[1] * w[1] - q[2] * w[0];
+		t = 0.0;
+		for (j=0; j<4; j++) {
+			q[j] += 0.5 * dq[j] * h;
+			t += q[j] * q[j];
+		}
+		t = 1.0 / std::sqrt(t);
+		for (j=0; j<4; j++)
+			q[j] *= t;
+		for (j=0; j<3; j++) {
+			v[j] += a[j] * h;
+			p[j] += v[j] * h;
+		}
+		
+		// Specific force: acceleration without gravity, in the body frame
+		a[2] += G;
+		for (j=0; j<3; j++)
+			f[j] = r[0][j] * a[0] + r[1][j] * a[1] + r[2][j] * a[2];
+		
+		// Landing, level with the same heading
+		if (p[2] < 0.0) {
+			yaw = std::atan2(2.0 * (q[0] * q[3] + q[1] * q[2]), 1.0 - 2.0 * (q[2] * q[2] + q[3] * q[3]));
+			q = {std::cos(yaw / 2.0), 0.0, 0.0, std::sin(yaw / 2.0)};
+			p[2] = 0.0;
+			v = {0.0, 0.0, 0.0};
+			w = {0.0, 0.0, 0.0};
+			f = {0.0, 0.0, G};
+			ground = true;
+		}
+	}
+}
+
+// Vibration of each rotor at its frequency, in proportion to its speed squared (unbalance)
+void plant::measure(float gyro[3], float accel[3], float & temperature)
+{
+	std::array<double, 3> g = rate();
+	std::array<double, 3> x;
+	double s;
+	size_t i;
+	int j;
+	
+	for (j=0; j<3; j++)
+		x[j] = f[j] / G;
+	for (i=0; i<n.size(); i++) {
+		s = n[i] * n[i];
+		g[0] += prm.gyro_vibration * s * std::sin(phase[i]);
+		g[1] += prm.gyro_vibration * s * std::cos(phase[i]);
+		g[2] += 0.3 * prm.gyro_vibration * s * std::sin(phase[i]);
+		x[0] += prm.accel_vibration * s * std::cos(phase[i]);
+		x[1] += prm.accel_vibration * s * std::sin(phase[i]);
+		x[2] += prm.accel_vibration * s * std::sin(phase[i]);
+	}
+	for (j=0; j<3; j++) {
+		gyro[j] = (float)(g[j] + prm.gyro_noise * normal(rng));
+		accel[j] = (float)(x[j] + prm.accel_noise * normal(rng));
+	}
+	temperature = (float)prm.temperature;
+}
+
+std::array<double, 3> plant::rate() const
+{
+	return {-w[1] * DEG, w[0] * DEG, w[2] * DEG};
+}
+
+std::array<double, 2> plant::attitude() const
+{
+	std::array<double, 3> u = up();
+	
+	return {std::asin(std::clamp(u[0], -1.0, 1.0)) * DEG, std::asin(std::clamp(u[1], -1.0, 1.0)) * DEG};
+}
+
+}
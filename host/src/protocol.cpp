@@ -0,0 +1,57 @@
+#include "fc/protocol.h"
+
+namespace fc {
+
+uint16_t crc16(const uint8_t * data, size_t size)
+{
+	uint16_t crc = 0xFFFF;
+	size_t i;
+	int j;
+	
+	for (i=0; i<size; i++) {
+		crc ^= (uint16_t)data[i] << 8;
+		for (j=0; j<8; j++)
+			crc = (crc & 0x8000) ? (uint16_t)((crc << 1) ^ 0x1021) : (uint16_t)(crc << 1);
+	}
+	
+	return crc;
+}
+
+uint32_t zigzag_encode(int32_t x)
+{
+	return ((uint32_t)x << 1) ^ (uint32_t)(x >> 31);
+}
+
+int32_t zigzag_decode(uint32_t x)
+{
+	return (int32_t)(x >> 1) ^ -(int32_t)(x & 1);
+}
+
+size_t varint_encode(uint8_t * code, uint32_t x)
+{
+	size_t n = 0;
+	
+	while (x >= 0x80) {
+		code[n++] = (uint8_t)(x | 0x80);
+		x >>= 7;
+	}
+	code[n++] = (uint8_t)x;
+	
+	return n;
+}
+
+size_t varint_decode(const uint8_t * code, size_t size, uint32_t & x)
+{
+	size_t n;
+	
+	x = 0;
+	for (n=0; (n<size) && (n<5); n++) {
+		x |= (uint32_t)(code[n] & 0x7F) << (7 * n);
+		if ((code[n] & 0x80) == 0)
+			return n + 1;
+	}
+	
+	return 0;
+}
+
+}
@@ -0,0 +1,119 @@
+#include "fc/registers.h"
+
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+
+namespace fc {
+
+const std::vector<reg_info> & reg_map()
+{
+	static const std::vector<reg_info> map =
+	{
+		#include "reg_map.inc"
+	};
+	
+	return map;
+}
+
+size_t nb_reg()
+{
+	return reg_map().size();
+}
+
+const std::vector<reg_field> & reg_fields()
+{
+	static const std::vector<reg_field> fields = []()
+	{
+		std::vector<reg_field> v;
+		
+		for (const reg_info & r : reg_map()) {
+			if (r.subf.size() == 1) {
+				v.push_back({r.subf[0].name, &r, &r.subf[0], false});
+				continue;
+			}
+			v.push_back({r.name, &r, nullptr, true});
+			for (const reg_subf & s : r.subf)
+				v.push_back({std::string(r.name) + "__" + s.name, &r, &s, false});
+		}
+		return v;
+	}();
+	
+	return fields;
+}
+
+std::optional<reg_field> reg_find(const std::string & name)
+{
+	for (const reg_field & f : reg_fields()) {
+		if (f.name == name)
+			return f;
+	}
+	
+	return std::nullopt;
+}
+
+// Mask of the field in the register word, the whole word for a register with several fields
+static uint32_t reg_mask(const reg_field & field)
+{
+	if (field.whole)
+		return 0xFFFFFFFF;
+	
+	uint8_t width = field.subf->msb - field.subf->lsb + 1;
+	return (width == 32) ? 0xFFFFFFFF : (((1U << width) - 1) << field.subf->lsb);
+}
+
+double reg_get(const reg_field & field, uint32_t word)
+{
+	if (field.whole)
+		return word;
+	
+	uint32_t x = (word & reg_mask(field)) >> field.subf->lsb;
+	float f;
+	
+	switch (field.subf->type) {
+		case field_type::int8:
+			return (int8_t)x;
+		case field_type::int16:
+			return (int16_t)x;
+		case field_type::int32:
+			return (int32_t)x;
+		case field_type::single:
+			std::memcpy(&f, &x, 4);
+			return f;
+		default:
+			return x;
+	}
+}
+
+uint32_t reg_set(const reg_field & field, uint32_t word, double value)
+{
+	uint32_t mask = reg_mask(field);
+	uint32_t x;
+	float f;
+	
+	if (field.whole)
+		return (uint32_t)(int64_t)std::llround(value);
+	
+	if (field.subf->type == field_type::single) {
+		f = (float)value;
+		std::memcpy(&x, &f, 4);
+	}
+	else
+		x = (uint32_t)(int64_t)std::llround(value); // Two's complement for the signed fields
+	
+	return (word & ~mask) | ((x << field.subf->lsb) & mask);
+}
+
+std::string reg_format(const reg_field & field, uint32_t word)
+{
+	char s[32];
+	
+	if (!field.whole && (field.subf->type == field_type::single))
+		std::snprintf(s, sizeof(s), "%f", reg_get(field, word));
+	else
+		std::snprintf(s, sizeof(s), "%.0f", reg_get(field, word));
+	
+	return s;
+}
+
+}
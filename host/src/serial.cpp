@@ -0,0 +1,247 @@
+#include "fc/serial.h"
+#include "fc/protocol.h" // error
+
+#include <cstring>
+
+#ifdef _WIN32
+	#include <windows.h>
+#else
+	#include <cerrno>
+	#include <fcntl.h>
+	#include <poll.h>
+	#include <termios.h>
+	#include <unistd.h>
+#endif
+
+namespace fc {
+
+#ifdef _WIN32
+
+serial::serial(const std::string & path, int baud, size_t rx_size) :
+	rx(rx_size), running(true), rx_dropped(0)
+{
+	std::string name = path;
+	DCB dcb;
+	COMMTIMEOUTS timeouts;
+	
+	// COM10 and above are only reachable with the device namespace prefix
+	if (name.compare(0, 4, "\\\\.\\") != 0)
+		name = "\\\\.\\" + name;
+	
+	handle = ::CreateFileA(name.c_str(), GENERIC_READ | GENERIC_WRITE, 0, NULL, OPEN_EXISTING, 0, NULL);
+	if (handle == INVALID_HANDLE_VALUE)
+		throw error("serial: cannot open " + path + " (error " + std::to_string(::GetLastError()) + ")");
+	
+	std::memset(&dcb, 0, sizeof(dcb));
+	dcb.DCBlength = sizeof(dcb);
+	if (::GetCommState(handle, &dcb)) {
+		dcb.BaudRate = (DWORD)baud;
+		dcb.ByteSize = 8;
+		dcb.Parity = NOPARITY;
+		dcb.StopBits = ONESTOPBIT;
+		dcb.fBinary = TRUE;
+		dcb.fOutxCtsFlow = FALSE;
+		dcb.fOutxDsrFlow = FALSE;
+		dcb.fOutX = FALSE;
+		dcb.fInX = FALSE;
+		dcb.fDtrControl = DTR_CONTROL_ENABLE;
+		dcb.fRtsControl = RTS_CONTROL_ENABLE;
+		::SetCommState(handle, &dcb);
+	}
+	
+	// ReadFile returns what has arrived after 50 ms at most, so that the reader sees the end request
+	timeouts.ReadIntervalTimeout = MAXDWORD;
+	timeouts.ReadTotalTimeoutMultiplier = MAXDWORD;
+	timeouts.ReadTotalTimeoutConstant = 50;
+	timeouts.WriteTotalTimeoutMultiplier = 0;
+	timeouts.WriteTotalTimeoutConstant = 1000;
+	::SetCommTimeouts(handle, &timeouts);
+	::PurgeComm(handle, PURGE_RXCLEAR);
+	
+	thread = std::thread(&serial::reader, this);
+}
+
+serial::~serial()
+{
+	running = false;
+	thread.join();
+	::CloseHandle(handle);
+}
+
+void serial::reader()
+{
+	uint8_t buf[4096];
+	DWORD n;
+	size_t pushed;
+	
+	while (running) {
+		if (!::ReadFile(handle, buf, sizeof(buf), &n, NULL)) {
+			// Board unplugged, wait for the destructor
+			std::this_thread::sleep_for(std::chrono::milliseconds(50));
+			continue;
+		}
+		if (n == 0)
+			continue;
+		
+		pushed = rx.push(buf, n);
+		if (pushed < n)
+			rx_dropped += n - pushed;
+		
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+		}
+		cv.notify_one();
+	}
+}
+
+void serial::write(const uint8_t * data, size_t size)
+{
+	DWORD n;
+	
+	while (size > 0) {
+		if (!::WriteFile(handle, data, (DWORD)size, &n, NULL) || (n == 0))
+			throw error("serial: write failed (error " + std::to_string(::GetLastError()) + ")");
+		data += n;
+		size -= n;
+	}
+}
+
+#else
+
+static speed_t serial_speed(int baud)
+{
+	switch (baud) {
+		case 9600: return B9600;
+		case 19200: return B19200;
+		case 38400: return B38400;
+		case 57600: return B57600;
+		case 115200: return B115200;
+		case 230400: return B230400;
+		case 460800: return B460800;
+		case 921600: return B921600;
+		case 1000000: return B1000000;
+		case 2000000: return B2000000;
+		default: throw error("serial: unsupported baud rate " + std::to_string(baud));
+	}
+}
+
+serial::serial(const std::string & path, int baud, size_t rx_size) :
+	rx(rx_size), running(true), rx_dropped(0)
+{
+	struct termios tio;
+	speed_t speed = serial_speed(baud);
+	
+	fd = ::open(path.c_str(), O_RDWR | O_NOCTTY | O_CLOEXEC);
+	if (fd < 0)
+		throw error("serial: cannot open " + path + ": " + std::strerror(errno));
+	
+	// The baud rate only matters for the UART boards (nucleo), USB CDC ignores it
+	if (::tcgetattr(fd, &tio) == 0) {
+		::cfmakeraw(&tio);
+		tio.c_cflag |= CLOCAL | CREAD;
+		tio.c_cc[VMIN] = 0;
+		tio.c_cc[VTIME] = 0;
+		::cfsetispeed(&tio, speed);
+		::cfsetospeed(&tio, speed);
+		::tcsetattr(fd, TCSANOW, &tio);
+		::tcflush(fd, TCIFLUSH);
+	}
+	
+	thread = std::thread(&serial::reader, this);
+}
+
+serial::~serial()
+{
+	running = false;
+	thread.join();
+	::close(fd);
+}
+
+void serial::reader()
+{
+	uint8_t buf[4096];
+	struct pollfd p = {fd, POLLIN, 0};
+	ssize_t n;
+	size_t pushed;
+	
+	while (running) {
+		if (::poll(&p, 1, 50) <= 0)
+			continue;
+		
+		n = ::read(fd, buf, sizeof(buf));
+		if (n <= 0) {
+			// Hang up (board unplugged or simulator closed), wait for the destructor
+			if ((n == 0) || ((errno != EAGAIN) && (errno != EINTR)))
+				std::this_thread::sleep_for(std::chrono::milliseconds(50));
+			continue;
+		}
+		
+		pushed = rx.push(buf, (size_t)n);
+		if (pushed < (size_t)n)
+			rx_dropped += (size_t)n - pushed;
+		
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+		}
+		cv.notify_one();
+	}
+}
+
+void serial::write(const uint8_t * data, size_t size)
+{
+	ssize_t n;
+	
+	while (size > 0) {
+		n = ::write(fd, data, size);
+		if (n < 0) {
+			if (errno == EINTR || errno == EAGAIN)
+				continue;
+			throw error(std::string("serial: write failed: ") + std::strerror(errno));
+		}
+		data += n;
+		size -= (size_t)n;
+	}
+}
+
+#endif
+
+size_t serial::read(uint8_t * data, size_t size, std::chrono::milliseconds timeout)
+{
+	auto deadline = std::chrono::steady_clock::now() + timeout;
+	size_t n = 0;
+	
+	while (n < size) {
+		n += rx.pop(data + n, size - n);
+		if (n == size)
+			break;
+		
+		std::unique_lock<std::mutex> lock(mutex);
+		if (!cv.wait_until(lock, deadline, [this]() { return rx.size() > 0; }))
+			break;
+	}
+	
+	return n;
+}
+
+size_t serial::read_some(uint8_t * data, size_t size, std::chrono::milliseconds timeout)
+{
+	size_t n = rx.pop(data, size);
+	
+	if (n > 0)
+		return n;
+	
+	std::unique_lock<std::mutex> lock(mutex);
+	cv.wait_for(lock, timeout, [this]() { return rx.size() > 0; });
+	lock.unlock();
+	
+	return rx.pop(data, size);
+}
+
+void serial::drain(std::chrono::milliseconds quiet)
+{
+	uint8_t buf[1024];
+	
+	while (read_some(buf, sizeof(buf), quiet) > 0) {}
+}
+
+}
@@ -0,0 +1,293 @@
+#include "fc/telemetry.h"
+#include "fc/protocol.h" // crc16, varint
+
+#include <cmath>
+#include <cstring>
+
+namespace fc {
+
+constexpr size_t TELEMETRY_SIZE_MAX = 128;
+
+const telemetry_channel telemetry_channels[TELEMETRY_NB_CHANNEL] =
+{
+	{"sensor_raw", 14, 7, field_type::int16,  {0}},
+	{"sensor",     28, 7, field_type::single, {16.0f, 16.0f, 16.0f, 1000.0f, 1000.0f, 1000.0f, 100.0f}}, // 1/16 deg/s, mg, 0.01 C
+	{"angle",      16, 4, field_type::single, {100.0f, 100.0f, 100.0f, 100.0f}}, // 0.01 deg
+	{"radio_raw",  16, 8, field_type::uint16, {0}},
+	{"radio",      32, 8, field_type::single, {1000.0f, 1000.0f, 1000.0f, 1000.0f, 1000.0f, 1000.0f, 1000.0f, 1000.0f}},
+	{"pid",        12, 3, field_type::single, {16.0f, 16.0f, 16.0f}},
+	{"motor",      16, 4, field_type::uint32, {0}},
+	{"vbat",        4, 1, field_type::single, {1000.0f}} // mV
+};
+
+// Quantised fields of a raw payload, as telemetry_encode() in sw/src/telemetry.c
+static void telemetry_quantise(uint8_t channel, const uint8_t * p, int32_t x[TELEMETRY_FIELD_MAX])
+{
+	const telemetry_channel & c = telemetry_channels[channel];
+	float f;
+	int i;
+	
+	for (i=0; i<c.nb; i++) {
+		switch (c.type) {
+			case field_type::int16:
+				x[i] = (int16_t)(p[2*i] | (p[2*i+1] << 8));
+				break;
+			case field_type::uint16:
+				x[i] = (int32_t)(p[2*i] | (p[2*i+1] << 8));
+				break;
+			case field_type::uint32:
+				x[i] = (int32_t)(p[4*i] | (p[4*i+1] << 8) | (p[4*i+2] << 16) | ((uint32_t)p[4*i+3] << 24));
+				break;
+			default:
+				std::memcpy(&f, &p[4*i], 4);
+				f *= c.scale[i];
+				x[i] = (int32_t)(f + ((f < 0) ? -0.5f : 0.5f));
+				break;
+		}
+	}
+}
+
+// Raw payload of quantised fields
+static void telemetry_dequantise(uint8_t channel, const int32_t x[TELEMETRY_FIELD_MAX], std::vector<uint8_t> & payload)
+{
+	const telemetry_channel & c = telemetry_channels[channel];
+	uint32_t u;
+	float f;
+	int i;
+	
+	payload.assign(c.size, 0);
+	for (i=0; i<c.nb; i++) {
+		switch (c.type) {
+			case field_type::int16:
+			case field_type::uint16:
+				payload[2*i] = (uint8_t)x[i];
+				payload[2*i+1] = (uint8_t)(x[i] >> 8);
+				break;
+			case field_type::uint32:
+				u = (uint32_t)x[i];
+				std::memcpy(&payload[4*i], &u, 4);
+				break;
+			default:
+				f = (float)x[i] / c.scale[i];
+				std::memcpy(&payload[4*i], &f, 4);
+				break;
+		}
+	}
+}
+
+std::vector<double> telemetry_values(uint8_t channel, const std::vector<uint8_t> & payload)
+{
+	const telemetry_channel & c = telemetry_channels[channel];
+	std::vector<double> v;
+	const uint8_t * p = payload.data();
+	uint32_t u;
+	float f;
+	int i;
+	
+	if (payload.size() != c.size)
+		return v;
+	
+	for (i=0; i<c.nb; i++) {
+		switch (c.type) {
+			case field_type::int16:
+				v.push_back((int16_t)(p[2*i] | (p[2*i+1] << 8)));
+				break;
+			case field_type::uint16:
+				v.push_back((uint16_t)(p[2*i] | (p[2*i+1] << 8)));
+				break;
+			case field_type::uint32:
+				std::memcpy(&u, &p[4*i], 4);
+				v.push_back(u);
+				break;
+			default:
+				std::memcpy(&f, &p[4*i], 4);
+				v.push_back(f);
+				break;
+		}
+	}
+	
+	return v;
+}
+
+telemetry_decoder::telemetry_decoder()
+{
+	reset();
+}
+
+void telemetry_decoder::reset()
+{
+	buf.clear();
+	for (auto & c : z)
+		c.fill(0);
+	count.fill(-1);
+	nb_frame = 0;
+	nb_crc = 0;
+	nb_lost = 0;
+}
+
+// Decode the count byte and the varints of a delta payload, return false if the code is truncated
+// The payload stays empty while the channel waits for a keyframe
+bool telemetry_decoder::decode_delta(uint8_t channel, const uint8_t * code, size_t size, size_t & used, std::vector<uint8_t> & payload)
+{
+	const telemetry_channel & ch = telemetry_channels[channel];
+	int32_t x[TELEMETRY_FIELD_MAX];
+	uint32_t u;
+	size_t n;
+	int c;
+	bool key;
+	int i;
+	
+	if (size < 1)
+		return false;
+	c = code[0] & 0x7F;
+	key = (code[0] & TELEMETRY_KEYFRAME) != 0;
+	used = 1;
+	
+	for (i=0; i<ch.nb; i++) {
+		n = varint_decode(&code[used], size - used, u);
+		if (n == 0)
+			return false;
+		used += n;
+		x[i] = zigzag_decode(u);
+	}
+	
+	if (!key) {
+		if ((count[channel] < 0) || (((c - count[channel]) & 0x7F) != 1)) {
+			count[channel] = -1; // Lost payload, wait for a keyframe
+			nb_lost++;
+			return true;
+		}
+		for (i=0; i<ch.nb; i++)
+			x[i] += z[channel][i];
+	}
+	
+	for (i=0; i<ch.nb; i++)
+		z[channel][i] = x[i];
+	count[channel] = c;
+	telemetry_dequantise(channel, x, payload);
+	
+	return true;
+}
+
+void telemetry_decoder::feed(const uint8_t * data, size_t size, const std::function<void(const telemetry_frame &)> & on_frame)
+{
+	telemetry_frame fr;
+	size_t k = 0;
+	size_t len;
+	size_t m;
+	size_t used;
+	const uint8_t * f;
+	uint8_t n;
+	
+	buf.insert(buf.end(), data, data + size);
+	
+	while (buf.size() - k >= TELEMETRY_HEADER_SIZE + 2) {
+		if ((buf[k] != TELEMETRY_SYNC_0) || ((buf[k+1] != TELEMETRY_SYNC_1) && (buf[k+1] != TELEMETRY_SYNC_1_DELTA))) {
+			k++;
+			continue;
+		}
+		len = buf[k+2];
+		if (buf.size() - k < TELEMETRY_HEADER_SIZE + 2 + len)
+			break;
+		
+		// Size, channels, seq, time, payloads
+		f = &buf[k+2];
+		if (crc16(f, TELEMETRY_HEADER_SIZE - 2 + len) != (buf[k+TELEMETRY_HEADER_SIZE+len] | (buf[k+TELEMETRY_HEADER_SIZE+len+1] << 8))) {
+			nb_crc++;
+			k++;
+			continue;
+		}
+		
+		fr.channels = f[1];
+		fr.seq = f[2];
+		fr.time = f[3] | (f[4] << 8) | (f[5] << 16) | ((uint32_t)f[6] << 24);
+		fr.delta = (buf[k+1] == TELEMETRY_SYNC_1_DELTA);
+		m = TELEMETRY_HEADER_SIZE - 2;
+		for (n=0; n<TELEMETRY_NB_CHANNEL; n++) {
+			fr.payload[n].clear();
+			if ((fr.channels & (1 << n)) == 0)
+				continue;
+			if (!fr.delta) {
+				if (m + telemetry_channels[n].size <= len + TELEMETRY_HEADER_SIZE - 2)
+					fr.payload[n].assign(&f[m], &f[m + telemetry_channels[n].size]);
+				m += telemetry_channels[n].size;
+			}
+			else {
+				if (!decode_delta(n, &f[m], len + TELEMETRY_HEADER_SIZE - 2 - m, used, fr.payload[n]))
+					break;
+				m += used;
+			}
+		}
+		
+		nb_frame++;
+		on_frame(fr);
+		k += TELEMETRY_HEADER_SIZE + 2 + len;
+	}
+	
+	buf.erase(buf.begin(), buf.begin() + k);
+}
+
+telemetry_encoder::telemetry_encoder()
+{
+	for (auto & c : z)
+		c.fill(0);
+	count.fill(0);
+	seq = 0;
+}
+
+void telemetry_encoder::start(uint32_t time, bool delta)
+{
+	buf.assign({TELEMETRY_SYNC_0, delta ? TELEMETRY_SYNC_1_DELTA : TELEMETRY_SYNC_1, 0, 0, seq,
+		(uint8_t)time, (uint8_t)(time >> 8), (uint8_t)(time >> 16), (uint8_t)(time >> 24)});
+}
+
+// Channels must be added by increasing number, a payload that does not fit is dropped
+void telemetry_encoder::add(uint8_t channel, const std::vector<uint8_t> & payload, uint8_t keyframe)
+{
+	std::vector<uint8_t> code;
+	int32_t x[TELEMETRY_FIELD_MAX];
+	uint8_t v[5];
+	bool key;
+	int i;
+	
+	if (buf[1] == TELEMETRY_SYNC_1_DELTA) {
+		telemetry_quantise(channel, payload.data(), x);
+		key = (count[channel] & ((1 << keyframe) - 1)) == 0;
+		code.push_back((count[channel] & 0x7F) | (key ? TELEMETRY_KEYFRAME : 0));
+		for (i=0; i<telemetry_channels[channel].nb; i++)
+			code.insert(code.end(), v, v + varint_encode(v, zigzag_encode(key ? x[i] : x[i] - z[channel][i])));
+	}
+	else
+		code = payload;
+	
+	if (buf.size() + code.size() + 2 > TELEMETRY_SIZE_MAX)
+		return;
+	
+	buf.insert(buf.end(), code.begin(), code.end());
+	buf[2] += (uint8_t)code.size();
+	buf[3] |= 1 << channel;
+	
+	if (buf[1] == TELEMETRY_SYNC_1_DELTA) {
+		for (i=0; i<telemetry_channels[channel].nb; i++)
+			z[channel][i] = x[i];
+		count[channel]++;
+	}
+}
+
+// Return the frame to send, empty if it has no payload
+std::vector<uint8_t> telemetry_encoder::finish()
+{
+	uint16_t crc;
+	
+	if (buf[3] == 0)
+		return {};
+	
+	crc = crc16(&buf[2], buf.size() - 2);
+	buf.push_back((uint8_t)crc);
+	buf.push_back((uint8_t)(crc >> 8));
+	seq++;
+	
+	return buf;
+}
+
+}
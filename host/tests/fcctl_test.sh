@@ -0,0 +1,56 @@
+#!/bin/sh
+# fcctl get/set/dump/stream against fcsim on a pseudo-terminal
+# usage: fcctl_test.sh FCSIM FCCTL, exit with 1 if a check fails
+
+FCSIM=$1
+FCCTL=$2
+DIR=$(mktemp -d)
+PORT=$DIR/fc
+FAILED=0
+
+"$FCSIM" -l "$PORT" > /dev/null &
+SIM=$!
+trap 'kill $SIM 2> /dev/null; rm -rf "$DIR"' EXIT
+
+i=0
+while [ ! -e "$PORT" ] && [ $i -lt 50 ]; do
+	sleep 0.1
+	i=$((i + 1))
+done
+
+fcctl()
+{
+	"$FCCTL" -p "$PORT" "$@"
+}
+
+# Output of a command, then the expected one
+check()
+{
+	if [ "$2" != "$3" ]; then
+		echo "$1: '$2', expected '$3'"
+		FAILED=1
+	fi
+}
+
+check "get default" "$(fcctl get MIXER__SERVO_CENTER)" "MIXER__SERVO_CENTER = 1000"
+
+fcctl set MIXER__SERVO_CENTER=1200 PID__FEEDFORWARD=0
+check "set" "$(fcctl get MIXER__SERVO_CENTER PID__FEEDFORWARD)" "MIXER__SERVO_CENTER = 1200
+PID__FEEDFORWARD = 0"
+
+# The config of dump is written back by set -f
+fcctl dump > "$DIR/config.txt"
+check "dump" "$(grep '^MIXER__SERVO_CENTER ' "$DIR/config.txt")" "MIXER__SERVO_CENTER = 1200"
+fcctl set MIXER__SERVO_CENTER=1300
+fcctl set -f "$DIR/config.txt"
+check "set -f" "$(fcctl get MIXER__SERVO_CENTER)" "MIXER__SERVO_CENTER = 1200"
+
+# Frames of the sensor channel without CRC error, one CSV line each
+fcctl stream -n 50 > "$DIR/stream.csv" 2> "$DIR/stream.txt"
+check "stream" "$(cut -d, -f1-2 "$DIR/stream.txt")" "50 frames, 0 CRC errors"
+check "stream lines" "$(grep -c ',sensor_raw,' "$DIR/stream.csv")" "50"
+
+if [ $FAILED -eq 0 ]; then
+	echo "fcctl OK"
+fi
+exit $FAILED
@@ -0,0 +1,70 @@
+// Motor mixer (sw/src/mixer.c) with the motor range of fc.c: MOTOR__START 50, MOTOR__ARMED 175, MOTOR_MAX 2000
+// Exit with 1 if a check fails
+
+#include <math.h>
+#include <stdio.h>
+#include "mixer.h"
+
+#define START 50.0f
+#define ARMED 175.0f
+#define MAX 2000.0f
+
+static int failed;
+
+static void check(const char * name, float x, float expected)
+{
+	if (fabsf(x - expected) > 0.5f) {
+		printf("%s: %.1f, expected %.1f\n", name, x, expected);
+		failed = 1;
+	}
+}
+
+// Motors of QUAD_X at a throttle, offset by ARMED as in fc.c
+static void run(const float axis[NB_AXIS], float throttle, _Bool airmode, float motor[MIXER_MAX_MOTOR])
+{
+	uint8_t sat_high;
+	uint8_t sat_low;
+	int i;
+	
+	mixer_run(&mixer_table[QUAD_X], axis, throttle, START - ARMED, MAX - ARMED, airmode, motor, &sat_high, &sat_low);
+	for (i=0; i<mixer_table[QUAD_X].nb_motor; i++)
+		motor[i] += ARMED;
+}
+
+int main(void)
+{
+	const float level[NB_AXIS] = {0, 0, 0};
+	const float yaw[NB_AXIS] = {0, 0, 300.0f};
+	float motor[MIXER_MAX_MOTOR];
+	int airmode;
+	int i;
+	
+	// Table read with the layout of the firmware (-fpack-struct): a wrong one gives garbage after the first airframe
+	for (i=0; i<NB_AIRFRAME; i++)
+		check("nb_motor", mixer_table[i].nb_motor, MIXER_NB_MOTOR(i));
+	
+	for (airmode=0; airmode<=1; airmode++) {
+		// Armed idle, half and full throttle without attitude
+		run(level, 0, airmode, motor);
+		for (i=0; i<4; i++)
+			check(airmode ? "idle (airmode)" : "idle", motor[i], ARMED);
+		run(level, 850.0f, airmode, motor);
+		for (i=0; i<4; i++)
+			check(airmode ? "half (airmode)" : "half", motor[i], ARMED + 850.0f);
+		run(level, MAX - ARMED, airmode, motor);
+		for (i=0; i<4; i++)
+			check(airmode ? "full (airmode)" : "full", motor[i], MAX);
+	}
+	
+	// Yaw at idle: clipped to START, or throttle moved up by the airmode with the full yaw difference
+	run(yaw, 0, 0, motor);
+	check("idle yaw low", motor[0], START);
+	check("idle yaw high", motor[1], ARMED + 300.0f);
+	run(yaw, 0, 1, motor);
+	check("idle yaw low (airmode)", motor[0], START);
+	check("idle yaw high (airmode)", motor[1], START + 600.0f);
+	
+	if (!failed)
+		printf("mixer OK\n");
+	return failed;
+}
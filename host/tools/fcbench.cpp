@@ -0,0 +1,122 @@
+// Benchmarks of the firmware control path on the host (fc_sil, see sw/src/bench.c)
+// Each function runs over fixed input vectors, the results are printed as NAME.ns = VALUE lines, the fastest round of
+// all runs in ns per call. Two results files (these or the NAME.cycles lines of fcctl bench) are compared with -c
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <map>
+#include <string>
+
+#include "sil_host.h"
+
+static void usage()
+{
+	std::fprintf(stderr,
+		"usage: fcbench [-n RUNS] [-f PREFIX]\n"
+		"       fcbench -c BASELINE [-t PCT] [RESULTS]\n"
+		"  -n RUNS         runs of all the benchmarks, the best is kept (default 5)\n"
+		"  -f PREFIX       only the benchmarks whose name starts with PREFIX\n"
+		"  -c BASELINE     compare RESULTS (default a new run) with a previous results file\n"
+		"  -t PCT          slowdown reported as a regression (default 20)\n"
+		"The exit status of -c is 1 if a benchmark regressed\n");
+	std::exit(2);
+}
+
+static std::string trim(const std::string & s)
+{
+	size_t a = s.find_first_not_of(" \t\r");
+	size_t b = s.find_last_not_of(" \t\r");
+	
+	return (a == std::string::npos) ? std::string() : s.substr(a, b - a + 1);
+}
+
+// NAME = VALUE lines, in order of the names
+static std::map<std::string, double> read_results(const std::string & file)
+{
+	std::map<std::string, double> results;
+	std::ifstream in(file);
+	std::string line;
+	size_t eq;
+	
+	if (!in) {
+		std::fprintf(stderr, "fcbench: cannot open %s\n", file.c_str());
+		std::exit(1);
+	}
+	while (std::getline(in, line)) {
+		if ((eq = line.find('=')) != std::string::npos)
+			results[trim(line.substr(0, eq))] = std::atof(line.c_str() + eq + 1);
+	}
+	return results;
+}
+
+static std::map<std::string, double> run(int runs, const std::string & prefix)
+{
+	std::map<std::string, double> results;
+	sil_bench_s bench[SIL_NB_BENCH];
+	const char * name[SIL_NB_BENCH];
+	int r;
+	int i;
+	
+	sil_init();
+	for (r=0; r<runs; r++) {
+		sil_bench(bench, name);
+		for (i=0; i<SIL_NB_BENCH; i++) {
+			std::string key = std::string(name[i]) + ".ns";
+			if (key.compare(0, prefix.size(), prefix) != 0)
+				continue;
+			if ((r == 0) || (bench[i].best < results[key]))
+				results[key] = bench[i].best;
+		}
+	}
+	return results;
+}
+
+int main(int argc, char ** argv)
+{
+	std::string prefix;
+	std::string baseline;
+	std::string file;
+	double threshold = 20.0;
+	int runs = 5;
+	int i;
+	
+	for (i=1; i<argc; i++) {
+		std::string a = argv[i];
+		if ((a == "-n") && (i + 1 < argc))
+			runs = std::max(std::atoi(argv[++i]), 1);
+		else if ((a == "-f") && (i + 1 < argc))
+			prefix = argv[++i];
+		else if ((a == "-c") && (i + 1 < argc))
+			baseline = argv[++i];
+		else if ((a == "-t") && (i + 1 < argc))
+			threshold = std::atof(argv[++i]);
+		else if ((a[0] != '-') && !baseline.empty() && file.empty())
+			file = a;
+		else
+			usage();
+	}
+	
+	if (baseline.empty()) {
+		for (const auto & [key, value] : run(runs, prefix))
+			std::printf("%s = %.1f\n", key.c_str(), value);
+		return 0;
+	}
+	
+	// Same names in both files, the others are not compared
+	std::map<std::string, double> before = read_results(baseline);
+	std::map<std::string, double> after = file.empty() ? run(runs, prefix) : read_results(file);
+	bool regression = false;
+	for (const auto & [key, value] : after) {
+		auto b = before.find(key);
+		if ((b == before.end()) || (b->second <= 0.0))
+			continue;
+		double change = (value - b->second) / b->second * 100.0;
+		bool slower = (change > threshold);
+		std::printf("%s: %.1f -> %.1f (%+.1f%%)%s\n", key.c_str(), b->second, value, change, slower ? " REGRESSION" : "");
+		regression = regression || slower;
+	}
+	
+	return regression ? 1 : 0;
+}
@@ -0,0 +1,419 @@
+// Command line ground station: register access, config, telemetry capture, blackbox dump, benchmarks and latency trace
+
+#include <algorithm>
+#include <atomic>
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "fc/client.h"
+#include "fc/telemetry.h"
+
+static std::atomic<bool> stop(false);
+
+static void on_signal(int)
+{
+	stop = true;
+}
+
+static void usage()
+{
+	std::fprintf(stderr,
+		"usage: fcctl [-p port] [-b baud] <command>\n"
+		"  get [--flash] NAME...           print registers or fields (REG or REG__SUBF)\n"
+		"  set NAME=VALUE...               write fields in one batch (read-modify-write)\n"
+		"  set -f FILE                     same, with the NAME = VALUE lines of dump\n"
+		"  dump [--flash] [--all]          print the flash registers like read_config.m, --all for every field\n"
+		"  stream [-c MASK] [-r RATE] [--delta|--raw] [-n FRAMES] [-o FILE]\n"
+		"                                  capture telemetry as CSV (time, seq, channel, fields), -o saves the raw bytes\n"
+		"  flash                           save the RAM config to flash (save_config.m)\n"
+		"  blackbox FILE                   dump the flight log\n"
+		"  bench                           run the benchmarks of the control path (disarmed), cycles per call\n"
+		"  latency [--reset]               print the latency trace of the sensor samples (LATENCY__ENABLE), --reset clears it\n"
+		"The port defaults to $FC_PORT, then /dev/ttyACM0\n");
+	std::exit(2);
+}
+
+static uint32_t parse_uint(const std::string & s)
+{
+	return (uint32_t)std::stoul(s, nullptr, 0);
+}
+
+static int cmd_get(fc::client & c, const std::vector<std::string> & args)
+{
+	fc::target t = fc::target::ram;
+	std::vector<fc::reg_field> fields;
+	
+	for (const std::string & a : args) {
+		if (a == "--flash") {
+			t = fc::target::flash;
+			continue;
+		}
+		std::optional<fc::reg_field> f = fc::reg_find(a);
+		if (!f)
+			throw fc::error("unknown register " + a);
+		fields.push_back(*f);
+	}
+	if (fields.empty())
+		usage();
+	
+	std::vector<uint32_t> cfg = c.read_config(t);
+	for (const fc::reg_field & f : fields)
+		std::printf("%s = %s\n", f.name.c_str(), fc::reg_format(f, cfg[f.reg->addr]).c_str());
+	
+	return 0;
+}
+
+static int cmd_set(fc::client & c, const std::vector<std::string> & args)
+{
+	std::map<std::string, double> values;
+	std::vector<std::pair<std::string, bool>> lines; // Line, from a file
+	std::string line;
+	size_t i;
+	size_t eq;
+	
+	for (i=0; i<args.size(); i++) {
+		if (args[i] == "-f") {
+			if (++i == args.size())
+				usage();
+			std::ifstream in(args[i]);
+			if (!in)
+				throw fc::error("cannot open " + args[i]);
+			while (std::getline(in, line))
+				lines.push_back({line, true});
+		}
+		else
+			lines.push_back({args[i], false});
+	}
+	
+	for (auto & [l, file] : lines) {
+		l.erase(0, l.find_first_not_of(" \t"));
+		if (l.empty() || (l[0] == '#') || (l[0] == '%'))
+			continue;
+		eq = l.find('=');
+		if (eq == std::string::npos)
+			throw fc::error("expected NAME=VALUE: " + l);
+		std::string name = l.substr(0, eq);
+		name.erase(name.find_last_not_of(" \t") + 1);
+		// The dump of a config has the calibration results too, they are kept
+		std::optional<fc::reg_field> f = fc::reg_find(name);
+		if (file && f && f->reg->read_only)
+			continue;
+		values[name] = std::stod(l.substr(eq + 1));
+	}
+	if (values.empty())
+		usage();
+	
+	c.write_config(values);
+	
+	return 0;
+}
+
+static int cmd_dump(fc::client & c, const std::vector<std::string> & args)
+{
+	fc::target t = fc::target::ram;
+	bool all = false;
+	
+	for (const std::string & a : args) {
+		if (a == "--flash")
+			t = fc::target::flash;
+		else if (a == "--all")
+			all = true;
+		else
+			usage();
+	}
+	
+	std::vector<uint32_t> cfg = c.read_config(t);
+	for (const fc::reg_field & f : fc::reg_fields()) {
+		if (!all && (!f.reg->flash || f.whole))
+			continue;
+		std::printf("%s = %s\n", f.name.c_str(), fc::reg_format(f, cfg[f.reg->addr]).c_str());
+	}
+	
+	return 0;
+}
+
+static int cmd_stream(fc::client & c, const std::vector<std::string> & args)
+{
+	std::map<std::string, double> cfg;
+	uint32_t mask = 0x01;
+	uint64_t frames = 0;
+	uint64_t n = 0;
+	std::string out;
+	std::ofstream raw;
+	std::vector<uint8_t> buf(65536);
+	fc::telemetry_decoder decoder;
+	size_t size;
+	size_t i;
+	
+	for (i=0; i<args.size(); i++) {
+		if ((args[i] == "-c") && (i + 1 < args.size()))
+			mask = parse_uint(args[++i]);
+		else if ((args[i] == "-r") && (i + 1 < args.size()))
+			cfg["DEBUG_RATE"] = parse_uint(args[++i]);
+		else if ((args[i] == "-n") && (i + 1 < args.size()))
+			frames = std::stoull(args[++i]);
+		else if ((args[i] == "-o") && (i + 1 < args.size()))
+			out = args[++i];
+		else if (args[i] == "--delta")
+			cfg["DEBUG_DELTA__ENABLE"] = 1;
+		else if (args[i] == "--raw")
+			cfg["DEBUG_DELTA__ENABLE"] = 0;
+		else
+			usage();
+	}
+	
+	if (!out.empty()) {
+		raw.open(out, std::ios::binary);
+		if (!raw)
+			throw fc::error("cannot open " + out);
+	}
+	
+	c.stop_telemetry();
+	if (!cfg.empty())
+		c.write_config(cfg);
+	std::signal(SIGINT, on_signal);
+	std::signal(SIGTERM, on_signal);
+	c.write(fc::reg_find("DEBUG")->reg->addr, mask);
+	
+	// The serial thread keeps receiving while this one decodes and writes
+	while (!stop && ((frames == 0) || (n < frames))) {
+		size = c.port().read_some(buf.data(), buf.size(), std::chrono::milliseconds(100));
+		if (size == 0)
+			continue;
+		if (raw)
+			raw.write((const char*)buf.data(), size);
+		decoder.feed(buf.data(), size, [&](const fc::telemetry_frame & fr) {
+			uint8_t ch;
+			for (ch=0; ch<fc::TELEMETRY_NB_CHANNEL; ch++) {
+				if (fr.payload[ch].empty())
+					continue;
+				std::printf("%u,%u,%s", fr.time, fr.seq, fc::telemetry_channels[ch].name);
+				for (double v : fc::telemetry_values(ch, fr.payload[ch]))
+					std::printf(",%.9g", v);
+				std::printf("\n");
+			}
+			n++;
+		});
+	}
+	
+	c.stop_telemetry();
+	std::fflush(stdout);
+	std::fprintf(stderr, "%llu frames, %llu CRC errors, %llu delta payloads lost, %llu bytes dropped by the host\n",
+		(unsigned long long)decoder.frames(), (unsigned long long)decoder.crc_errors(),
+		(unsigned long long)decoder.lost(), (unsigned long long)c.port().dropped());
+	
+	return 0;
+}
+
+static int cmd_flash(fc::client & c, const std::vector<std::string> & args)
+{
+	if (!args.empty())
+		usage();
+	
+	c.save_config();
+	
+	// Check the copy, the non-flash registers do not matter
+	std::vector<uint32_t> ram = c.read_config(fc::target::ram);
+	std::vector<uint32_t> flash = c.read_config(fc::target::flash);
+	for (const fc::reg_info & r : fc::reg_map()) {
+		if (r.flash && !r.read_only && (ram[r.addr] != flash[r.addr]))
+			throw fc::error(std::string("flash mismatch on ") + r.name);
+	}
+	
+	return 0;
+}
+
+static int cmd_blackbox(fc::client & c, const std::vector<std::string> & args)
+{
+	if (args.size() != 1)
+		usage();
+	
+	std::vector<uint8_t> log = c.blackbox_dump([](size_t n, size_t size) {
+		std::fprintf(stderr, "\r%zu / %zu", n, size);
+	});
+	std::fprintf(stderr, "\n");
+	
+	std::ofstream f(args[0], std::ios::binary);
+	f.write((const char*)log.data(), log.size());
+	if (!f)
+		throw fc::error("cannot write " + args[0]);
+	
+	return 0;
+}
+
+// Order of bench.h (BENCH_*), radio_decode is the protocol of the board
+static const char * const bench_name[] = {
+	"mpu_process_samples",
+	"angle_estimate",
+	"radio_decode",
+	"radio_expo",
+	"dshot_encode",
+	"pid_mixer",
+	"reg_access_write",
+	"reg_update_on_read"
+};
+
+// NAME.cycles = VALUE lines in the order of the names, like fcbench (compared with fcbench -c)
+static int cmd_bench(fc::client & c, const std::vector<std::string> & args)
+{
+	if (!args.empty())
+		usage();
+	
+	std::optional<fc::reg_field> run = fc::reg_find("BENCH__RUN");
+	std::optional<fc::reg_field> item = fc::reg_find("BENCH__ITEM");
+	std::optional<fc::reg_field> result = fc::reg_find("BENCH_RESULT");
+	if (!run || !item || !result)
+		throw fc::error("no benchmarks in the register map");
+	
+	// The firmware runs all of them before it answers the next command, wait for the end with a read
+	c.write(run->reg->addr, fc::reg_set(*run, 0, 1));
+	c.read(run->reg->addr);
+	std::map<std::string, double> cycles;
+	size_t i;
+	for (i=0; i<sizeof(bench_name)/sizeof(bench_name[0]); i++) {
+		c.write(item->reg->addr, fc::reg_set(*item, 0, (double)i));
+		cycles[bench_name[i]] = fc::reg_get(*result, c.read(result->reg->addr));
+	}
+	if (cycles["mpu_process_samples"] == 0.0)
+		throw fc::error("no results, the board is armed");
+	for (const auto & [name, value] : cycles)
+		std::printf("%s.cycles = %.1f\n", name.c_str(), value);
+	
+	return 0;
+}
+
+// Points of latency.h after the data ready interrupt
+static const char * const latency_name[fc::LATENCY_NB_POINT - 1] = {
+	"sensor_done",
+	"process",
+	"motor",
+	"dshot"
+};
+
+// NAME = VALUE lines like fcsil: percentiles of each point from the histogram (upper edge of the bin, the lower edge for
+// the last bin that holds the longer times), then the worst samples sorted by their last point, in us
+static int cmd_latency(fc::client & c, const std::vector<std::string> & args)
+{
+	bool reset = false;
+	
+	for (const std::string & a : args) {
+		if (a == "--reset")
+			reset = true;
+		else
+			usage();
+	}
+	
+	std::vector<uint32_t> w = c.read_latency();
+	double ticks_us = (w[0] > 0) ? (double)w[0] : 1.0;
+	uint32_t bin = w[1];
+	std::printf("samples = %u\n", w[2]);
+	std::printf("dropped = %u\n", w[3]);
+	std::printf("bin_us = %u\n", bin);
+	
+	size_t p;
+	size_t k;
+	for (p=0; p<fc::LATENCY_NB_POINT-1; p++) {
+		const uint32_t * h = &w[fc::LATENCY_HIST + p * fc::LATENCY_NB_BIN];
+		uint64_t total = 0;
+		for (k=0; k<fc::LATENCY_NB_BIN; k++)
+			total += h[k];
+		if (total == 0)
+			continue;
+		for (double q : {0.5, 0.99, 1.0}) {
+			uint64_t n = 0;
+			for (k=0; k<fc::LATENCY_NB_BIN; k++) {
+				n += h[k];
+				if ((double)n >= q * (double)total)
+					break;
+			}
+			std::printf("%s.%s_us = %u\n", latency_name[p], (q == 0.5) ? "p50" : (q == 1.0) ? "max" : "p99",
+				(uint32_t)((k == fc::LATENCY_NB_BIN - 1) ? k : k + 1) * bin);
+		}
+		std::printf("%s.over = %u\n", latency_name[p], h[fc::LATENCY_NB_BIN - 1]);
+		std::string hist;
+		for (k=0; k<fc::LATENCY_NB_BIN; k++)
+			hist += (k ? " " : "") + std::to_string(h[k]);
+		std::printf("%s.hist = %s\n", latency_name[p], hist.c_str());
+	}
+	
+	// The end point is the last one with a time
+	std::vector<std::vector<uint32_t>> worst;
+	for (k=0; k<fc::LATENCY_NB_WORST; k++) {
+		const uint32_t * s = &w[fc::LATENCY_WORST + k * fc::LATENCY_NB_POINT];
+		if (s[0] != 0)
+			worst.emplace_back(s, s + fc::LATENCY_NB_POINT);
+	}
+	auto end = [](const std::vector<uint32_t> & s) { return *std::max_element(s.begin() + 1, s.end()); };
+	std::sort(worst.begin(), worst.end(), [&](const auto & a, const auto & b) { return end(a) > end(b); });
+	for (k=0; k<worst.size(); k++) {
+		std::printf("worst_%zu.sample = %u\n", k, worst[k][0]);
+		for (p=1; p<fc::LATENCY_NB_POINT; p++) {
+			if (worst[k][p] != 0)
+				std::printf("worst_%zu.%s_us = %.2f\n", k, latency_name[p-1], worst[k][p] / ticks_us);
+		}
+	}
+	
+	if (reset)
+		c.write_config({{"LATENCY__RESET", 1}});
+	
+	return 0;
+}
+
+int main(int argc, char ** argv)
+{
+	const char * env = std::getenv("FC_PORT");
+	std::string port = env ? env : "/dev/ttyACM0";
+	int baud = 115200;
+	int i;
+	
+	for (i=1; i<argc; i++) {
+		if ((std::strcmp(argv[i], "-p") == 0) && (i + 1 < argc))
+			port = argv[++i];
+		else if ((std::strcmp(argv[i], "-b") == 0) && (i + 1 < argc))
+			baud = std::atoi(argv[++i]);
+		else
+			break;
+	}
+	if (i == argc)
+		usage();
+	
+	std::string cmd = argv[i];
+	std::vector<std::string> args(argv + i + 1, argv + argc);
+	
+	try {
+		fc::serial s(port, baud);
+		fc::client c(s);
+		
+		if (cmd == "get")
+			return cmd_get(c, args);
+		if (cmd == "set")
+			return cmd_set(c, args);
+		if (cmd == "dump")
+			return cmd_dump(c, args);
+		if (cmd == "stream")
+			return cmd_stream(c, args);
+		if (cmd == "flash")
+			return cmd_flash(c, args);
+		if (cmd == "blackbox")
+			return cmd_blackbox(c, args);
+		if (cmd == "bench")
+			return cmd_bench(c, args);
+		if (cmd == "latency")
+			return cmd_latency(c, args);
+		usage();
+	}
+	catch (const std::exception & e) {
+		std::fprintf(stderr, "fcctl: %s\n", e.what());
+		return 1;
+	}
+	
+	return 0;
+}
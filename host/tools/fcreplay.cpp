@@ -0,0 +1,256 @@
+// Replay of a telemetry capture through the firmware control path (fc_sil, see sw/inc/sil.h)
+// The SENSOR_RAW and RADIO_RAW payloads of the capture are fed to sensor_ready and task_radio at their
+// recorded times, the outputs of each stage are written per sample and each stage is timed on the host
+
+#include <charconv>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <map>
+#include <string>
+#include <vector>
+
+#include "fc/protocol.h"
+#include "fc/registers.h"
+#include "fc/telemetry.h"
+#include "sil_host.h"
+
+constexpr uint32_t SENSOR_PERIOD = 1000; // us, fc.h
+constexpr uint8_t CHANNEL_SENSOR_RAW = 0;
+constexpr uint8_t CHANNEL_RADIO_RAW = 3;
+constexpr uint8_t CHANNEL_VBAT = 7;
+
+static FILE * telemetry_out = nullptr;
+
+static void usage()
+{
+	std::fprintf(stderr,
+		"usage: fcreplay [-c FILE] [-s NAME=VALUE]... [-o FILE] [-t FILE] CAPTURE\n"
+		"  CAPTURE         raw bytes of fcctl stream -c 0x89 -r 0 -o CAPTURE (SENSOR_RAW, RADIO_RAW and VBAT at full rate)\n"
+		"  -c FILE         config, the NAME = VALUE lines of fcctl dump (read-only fields are skipped)\n"
+		"  -s NAME=VALUE   register field, applied after the config\n"
+		"  -o FILE         outputs of the stages as CSV, one line per sensor sample\n"
+		"  -t FILE         telemetry sent by the replayed firmware (DEBUG), raw bytes like fcctl stream -o\n"
+		"The timing of each stage is printed on stderr\n");
+	std::exit(2);
+}
+
+static void on_host_send(const uint8_t * data, uint8_t size)
+{
+	if (telemetry_out)
+		std::fwrite(data, 1, size, telemetry_out);
+}
+
+// CSV field, to_chars is several times faster than printf for the floats
+template <typename T>
+static void csv_add(std::string & line, T x)
+{
+	char buf[32];
+	
+	line += ',';
+	line.append(buf, std::to_chars(buf, buf + sizeof(buf), x).ptr);
+}
+
+static std::string trim(const std::string & s)
+{
+	size_t a = s.find_first_not_of(" \t\r");
+	size_t b = s.find_last_not_of(" \t\r");
+	
+	return (a == std::string::npos) ? std::string() : s.substr(a, b - a + 1);
+}
+
+// NAME=VALUE in the register words, read-only fields are an error unless they come from a config file
+static void parse_field(const std::string & line, bool file, std::vector<uint32_t> & reg)
+{
+	std::string l = trim(line);
+	size_t eq;
+	
+	if (l.empty() || (l[0] == '#') || (l[0] == '%'))
+		return;
+	eq = l.find('=');
+	if (eq == std::string::npos)
+		throw fc::error("expected NAME=VALUE: " + l);
+	std::string name = trim(l.substr(0, eq));
+	std::optional<fc::reg_field> f = fc::reg_find(name);
+	if (!f)
+		throw fc::error("unknown register " + name);
+	if (f->reg->read_only) {
+		if (file)
+			return;
+		throw fc::error(name + " is read-only");
+	}
+	reg[f->reg->addr] = fc::reg_set(*f, reg[f->reg->addr], std::stod(l.substr(eq + 1)));
+}
+
+static void print_timing(double duration, double wall)
+{
+	int i;
+	
+	std::fprintf(stderr, "%-20s %10s %10s %10s %10s\n", "stage", "calls", "mean ns", "min ns", "max ns");
+	for (i=0; i<SIL_NB_TIMING; i++) {
+		const sil_timing_s & t = sil_timing[i];
+		if (t.count == 0)
+			continue;
+		std::fprintf(stderr, "%-20s %10llu %10.0f %10llu %10llu\n", sil_timing_name[i], (unsigned long long)t.count,
+			(double)t.total / (double)t.count, (unsigned long long)t.min, (unsigned long long)t.max);
+	}
+	std::fprintf(stderr, "%.3f s of capture replayed in %.3f s (%.0fx real time)\n", duration, wall,
+		(wall > 0) ? duration / wall : 0.0);
+}
+
+int main(int argc, char ** argv)
+{
+	std::vector<std::pair<std::string, bool>> fields; // Line, from a file
+	std::string capture;
+	std::string out;
+	std::string tel;
+	std::string line;
+	int i;
+	
+	for (i=1; i<argc; i++) {
+		std::string a = argv[i];
+		if ((a == "-c") && (i + 1 < argc)) {
+			std::ifstream in(argv[++i]);
+			if (!in) {
+				std::fprintf(stderr, "fcreplay: cannot open %s\n", argv[i]);
+				return 1;
+			}
+			while (std::getline(in, line))
+				fields.push_back({line, true});
+		}
+		else if ((a == "-s") && (i + 1 < argc))
+			fields.push_back({argv[++i], false});
+		else if ((a == "-o") && (i + 1 < argc))
+			out = argv[++i];
+		else if ((a == "-t") && (i + 1 < argc))
+			tel = argv[++i];
+		else if (capture.empty() && (a[0] != '-'))
+			capture = a;
+		else
+			usage();
+	}
+	if (capture.empty())
+		usage();
+	
+	FILE * csv = nullptr;
+	
+	try {
+		std::ifstream in(capture, std::ios::binary);
+		if (!in)
+			throw fc::error("cannot open " + capture);
+		std::vector<uint8_t> data((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+		
+		if (!out.empty() && !(csv = std::fopen(out.c_str(), "w")))
+			throw fc::error("cannot open " + out);
+		if (!tel.empty() && !(telemetry_out = std::fopen(tel.c_str(), "wb")))
+			throw fc::error("cannot open " + tel);
+		
+		// Power on, then the config through the host protocol like fcctl set
+		sil_init();
+		sil_set_host(on_host_send);
+		std::vector<uint32_t> reg(fc::nb_reg());
+		size_t n;
+		for (n=0; n<reg.size(); n++)
+			reg[n] = sil_reg_read((uint8_t)n);
+		std::vector<uint32_t> initial = reg;
+		for (const auto & [l, file] : fields)
+			parse_field(l, file, reg);
+		for (n=0; n<reg.size(); n++) {
+			if (reg[n] != initial[n])
+				sil_reg_write((uint8_t)n, reg[n]);
+		}
+		
+		if (csv) {
+			std::fprintf(csv, "time,armed,acro,gyro_x,gyro_y,gyro_z,accel_x,accel_y,accel_z,angle_pitch,angle_roll,"
+				"throttle,pitch,roll,yaw,setpoint_pitch,setpoint_roll,setpoint_yaw,pid_pitch,pid_roll,pid_yaw");
+			for (n=0; n<SIL_NB_OUTPUT; n++)
+				std::fprintf(csv, ",motor_%zu", n);
+			std::fprintf(csv, "\n");
+		}
+		
+		fc::telemetry_decoder decoder;
+		uint64_t samples = 0;
+		uint64_t late = 0;
+		uint64_t duration = 0;
+		bool first = true;
+		uint32_t time_z = 0;
+		sil_output_s o;
+		std::string row;
+		
+		auto start = std::chrono::steady_clock::now();
+		decoder.feed(data.data(), data.size(), [&](const fc::telemetry_frame & fr) {
+			uint16_t radio[SIL_RADIO_NB_CHAN];
+			uint32_t period;
+			float vbat;
+			int k;
+			
+			if (fr.payload[CHANNEL_VBAT].size() == sizeof(vbat)) {
+				std::memcpy(&vbat, fr.payload[CHANNEL_VBAT].data(), sizeof(vbat));
+				sil_vbat(vbat);
+			}
+			if (fr.payload[CHANNEL_RADIO_RAW].size() == sizeof(radio)) {
+				std::memcpy(radio, fr.payload[CHANNEL_RADIO_RAW].data(), sizeof(radio));
+				sil_radio(radio);
+			}
+			if (fr.payload[CHANNEL_SENSOR_RAW].size() != SIL_SENSOR_RAW_SIZE)
+				return;
+			
+			// Samples at their recorded period, the time of the capture wraps every 71 minutes
+			period = first ? SENSOR_PERIOD : fr.time - time_z;
+			time_z = fr.time;
+			first = false;
+			if (period > SENSOR_PERIOD + SENSOR_PERIOD / 2)
+				late++;
+			duration += period;
+			samples++;
+			sil_sensor(period, fr.payload[CHANNEL_SENSOR_RAW].data());
+			
+			if (!csv)
+				return;
+			sil_output(&o);
+			row = std::to_string(o.time);
+			csv_add(row, o.armed);
+			csv_add(row, o.acro);
+			for (k=0; k<3; k++)
+				csv_add(row, o.gyro[k]);
+			for (k=0; k<3; k++)
+				csv_add(row, o.accel[k]);
+			for (k=0; k<2; k++)
+				csv_add(row, o.angle[k]);
+			for (k=0; k<4; k++)
+				csv_add(row, o.radio[k]);
+			for (k=0; k<3; k++)
+				csv_add(row, o.setpoint[k]);
+			for (k=0; k<3; k++)
+				csv_add(row, o.pid[k]);
+			for (k=0; k<SIL_NB_OUTPUT; k++)
+				csv_add(row, o.motor[k]);
+			row += '\n';
+			std::fwrite(row.data(), 1, row.size(), csv);
+		});
+		std::chrono::duration<double> wall = std::chrono::steady_clock::now() - start;
+		
+		if (samples == 0)
+			throw fc::error("no SENSOR_RAW payload in " + capture);
+		std::fprintf(stderr, "%llu samples, %llu frames, %llu CRC errors, %llu delta payloads lost\n",
+			(unsigned long long)samples, (unsigned long long)decoder.frames(),
+			(unsigned long long)decoder.crc_errors(), (unsigned long long)decoder.lost());
+		if (late > samples / 2)
+			std::fprintf(stderr, "warning: SENSOR_RAW is decimated, capture with fcctl stream -r 0\n");
+		print_timing((double)duration * 1e-6, wall.count());
+	}
+	catch (const std::exception & e) {
+		std::fprintf(stderr, "fcreplay: %s\n", e.what());
+		return 1;
+	}
+	
+	if (csv)
+		std::fclose(csv);
+	if (telemetry_out)
+		std::fclose(telemetry_out);
+	
+	return 0;
+}
@@ -0,0 +1,417 @@
+// Closed loop of the firmware control path (fc_sil, see sw/inc/sil.h) with a multirotor model (fc/plant.h)
+// The aircraft is armed, takes off and hovers, then gets a doublet on the rate of each axis in acro. The step
+// response of the rates, the noise in hover and the host time of each stage are printed as NAME = VALUE lines
+
+#include <algorithm>
+#include <charconv>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <map>
+#include <string>
+#include <vector>
+
+#include "fc/plant.h"
+#include "fc/protocol.h"
+#include "fc/registers.h"
+#include "sil_host.h"
+
+constexpr uint32_t SENSOR_PERIOD = 1000; // us, fc.h
+constexpr uint32_t RADIO_PERIOD = 7000; // us, fc.h
+constexpr int PITCH = 0; // pid.h
+constexpr int ROLL = 1;
+constexpr int YAW = 2;
+constexpr double G = 9.81;
+
+// Scenario, ms
+constexpr uint32_t T_ARM = 500;
+constexpr uint32_t T_TAKEOFF = 1000;
+constexpr uint32_t T_HOVER = 3000; // Noise measured from here to the first step
+constexpr uint32_t T_STEP = 4000;
+constexpr uint32_t STEP_TIME = 200; // Each half of the doublet
+constexpr uint32_t STEP_PERIOD = 1500; // Between the steps of two axes
+constexpr uint32_t T_LAND = T_STEP + 3 * STEP_PERIOD;
+constexpr uint32_t T_END = T_LAND + 2000;
+
+// Pilot
+constexpr double ALTITUDE = 1.0; // m
+constexpr double LEVEL_GAIN = 5.0; // deg/s per deg, pitch and roll back to level between the steps
+constexpr double ALT_P = 0.15; // Throttle per m
+constexpr double ALT_D = 0.1; // Throttle per m/s
+constexpr double ALT_I = 0.1; // Throttle per m s
+
+static const char * const axis_name[3] = {"pitch", "roll", "yaw"};
+
+static void usage()
+{
+	std::fprintf(stderr,
+		"usage: fcsil [-c FILE] [-s NAME=VALUE]... [-p NAME=VALUE]... [-a STICK] [-o FILE]\n"
+		"  -c FILE         config, the NAME = VALUE lines of fcctl dump (read-only fields are skipped)\n"
+		"  -s NAME=VALUE   register field, applied after the config\n"
+		"  -p NAME=VALUE   model parameter (fc/plant.h): mass, arm, inertia_x, inertia_y, inertia_z, thrust_max,\n"
+		"                  thrust_linear, torque_ratio, motor_tau, drag, rot_drag, gyro_noise, accel_noise,\n"
+		"                  gyro_vibration, accel_vibration, rotor_hz, temperature, seed\n"
+		"  -a STICK        amplitude of the doublets, fraction of full stick (default 0.5, before expo)\n"
+		"  -o FILE         trace as CSV, one line per sensor sample\n"
+		"The results are printed on stdout, the exit status is 1 if the aircraft crashed\n");
+	std::exit(2);
+}
+
+// CSV field, to_chars is several times faster than printf for the floats
+template <typename T>
+static void csv_add(std::string & line, T x)
+{
+	char buf[32];
+	
+	line += ',';
+	line.append(buf, std::to_chars(buf, buf + sizeof(buf), x).ptr);
+}
+
+static std::string trim(const std::string & s)
+{
+	size_t a = s.find_first_not_of(" \t\r");
+	size_t b = s.find_last_not_of(" \t\r");
+	
+	return (a == std::string::npos) ? std::string() : s.substr(a, b - a + 1);
+}
+
+// NAME=VALUE in the register words, read-only fields are an error unless they come from a config file
+static void parse_field(const std::string & line, bool file, std::vector<uint32_t> & reg)
+{
+	std::string l = trim(line);
+	size_t eq;
+	
+	if (l.empty() || (l[0] == '#') || (l[0] == '%'))
+		return;
+	eq = l.find('=');
+	if (eq == std::string::npos)
+		throw fc::error("expected NAME=VALUE: " + l);
+	std::string name = trim(l.substr(0, eq));
+	std::optional<fc::reg_field> f = fc::reg_find(name);
+	if (!f)
+		throw fc::error("unknown register " + name);
+	if (f->reg->read_only) {
+		if (file)
+			return;
+		throw fc::error(name + " is read-only");
+	}
+	reg[f->reg->addr] = fc::reg_set(*f, reg[f->reg->addr], std::stod(l.substr(eq + 1)));
+}
+
+static void parse_param(const std::string & line, fc::plant_params & p)
+{
+	const std::map<std::string, double *> fields = {
+		{"mass", &p.mass}, {"arm", &p.arm}, {"inertia_x", &p.inertia[0]}, {"inertia_y", &p.inertia[1]},
+		{"inertia_z", &p.inertia[2]}, {"thrust_max", &p.thrust_max}, {"thrust_linear", &p.thrust_linear},
+		{"torque_ratio", &p.torque_ratio}, {"motor_tau", &p.motor_tau}, {"drag", &p.drag}, {"rot_drag", &p.rot_drag},
+		{"gyro_noise", &p.gyro_noise}, {"accel_noise", &p.accel_noise}, {"gyro_vibration", &p.gyro_vibration},
+		{"accel_vibration", &p.accel_vibration}, {"rotor_hz", &p.rotor_hz}, {"temperature", &p.temperature}
+	};
+	size_t eq = line.find('=');
+	
+	if (eq == std::string::npos)
+		throw fc::error("expected NAME=VALUE: " + line);
+	std::string name = trim(line.substr(0, eq));
+	double value = std::stod(line.substr(eq + 1));
+	if (name == "seed")
+		p.seed = (uint32_t)value;
+	else if (fields.count(name))
+		*fields.at(name) = value;
+	else
+		throw fc::error("unknown model parameter " + name);
+}
+
+static double reg_value(const std::string & name)
+{
+	std::optional<fc::reg_field> f = fc::reg_find(name);
+	
+	return fc::reg_get(*f, sil_reg_read(f->reg->addr));
+}
+
+// Stick that gives the hover thrust with all the rotors at the same speed
+static double hover_throttle(const fc::plant_params & p)
+{
+	double nb = 0;
+	double t;
+	double n;
+	double raw;
+	
+	for (const auto & c : p.mixer)
+		nb += ((c[0] != 0.0) || (c[1] != 0.0) || (c[2] != 0.0)) ? 1.0 : 0.0;
+	t = p.mass * G / (nb * p.thrust_max);
+	n = (-p.thrust_linear + std::sqrt(p.thrust_linear * p.thrust_linear + 4.0 * (1.0 - p.thrust_linear) * t))
+		/ (2.0 * (1.0 - p.thrust_linear));
+	raw = p.dshot ? 48.0 + n * 1999.0 : n * 2000.0;
+	return (raw - reg_value("MOTOR__ARMED")) / reg_value("MOTOR__RANGE");
+}
+
+// Response of one axis to the first half of its doublet, from the change of setpoint to the reversal of the stick
+struct step_result {
+	double rise; // ms, 10% to 90%
+	double overshoot; // %
+	double settling; // ms, last time out of 5% of the step, the window if never in
+	double error; // deg/s RMS, rate - setpoint
+};
+
+static step_result step_response(const std::vector<double> & rate, const std::vector<double> & setpoint, size_t start, size_t end)
+{
+	step_result r = {0, 0, 0, 0};
+	double y0 = rate[start];
+	double target = setpoint[end - 1];
+	double t10 = -1;
+	double t90 = -1;
+	double peak = 0;
+	double y;
+	size_t i;
+	
+	if ((start == 0) || (end <= start) || (std::fabs(target - y0) < 1.0))
+		return r;
+	
+	for (i=start; i<end; i++) {
+		y = (rate[i] - y0) / (target - y0);
+		if ((t10 < 0) && (y >= 0.1))
+			t10 = (double)(i - start);
+		if ((t90 < 0) && (y >= 0.9))
+			t90 = (double)(i - start);
+		if (y > peak)
+			peak = y;
+		if (std::fabs(y - 1.0) > 0.05)
+			r.settling = (double)(i - start + 1);
+		r.error += (rate[i] - setpoint[i]) * (rate[i] - setpoint[i]);
+	}
+	r.rise = ((t10 >= 0) && (t90 >= 0)) ? t90 - t10 : (double)(end - start);
+	r.overshoot = (peak > 1.0) ? (peak - 1.0) * 100.0 : 0.0;
+	r.error = std::sqrt(r.error / (double)(end - start));
+	
+	return r;
+}
+
+static double rms(const std::vector<double> & x, size_t a, size_t b)
+{
+	double m = 0;
+	double s = 0;
+	size_t i;
+	
+	for (i=a; i<b; i++)
+		m += x[i];
+	m /= (double)(b - a);
+	for (i=a; i<b; i++)
+		s += (x[i] - m) * (x[i] - m);
+	
+	return std::sqrt(s / (double)(b - a));
+}
+
+int main(int argc, char ** argv)
+{
+	std::vector<std::pair<std::string, bool>> fields; // Line, from a file
+	std::vector<std::string> params;
+	std::string out;
+	std::string line;
+	double amplitude = 0.5;
+	int i;
+	
+	for (i=1; i<argc; i++) {
+		std::string a = argv[i];
+		if ((a == "-c") && (i + 1 < argc)) {
+			std::ifstream in(argv[++i]);
+			if (!in) {
+				std::fprintf(stderr, "fcsil: cannot open %s\n", argv[i]);
+				return 1;
+			}
+			while (std::getline(in, line))
+				fields.push_back({line, true});
+		}
+		else if ((a == "-s") && (i + 1 < argc))
+			fields.push_back({argv[++i], false});
+		else if ((a == "-p") && (i + 1 < argc))
+			params.push_back(argv[++i]);
+		else if ((a == "-a") && (i + 1 < argc))
+			amplitude = std::atof(argv[++i]);
+		else if ((a == "-o") && (i + 1 < argc))
+			out = argv[++i];
+		else
+			usage();
+	}
+	
+	FILE * csv = nullptr;
+	bool crashed = false;
+	
+	try {
+		if (!out.empty() && !(csv = std::fopen(out.c_str(), "w")))
+			throw fc::error("cannot open " + out);
+		
+		// Power on, then the config through the host protocol like fcctl set
+		sil_init();
+		std::vector<uint32_t> reg(fc::nb_reg());
+		size_t n;
+		for (n=0; n<reg.size(); n++)
+			reg[n] = sil_reg_read((uint8_t)n);
+		std::vector<uint32_t> initial = reg;
+		for (const auto & [l, file] : fields)
+			parse_field(l, file, reg);
+		for (n=0; n<reg.size(); n++) {
+			if (reg[n] != initial[n])
+				sil_reg_write((uint8_t)n, reg[n]);
+		}
+		
+		// Model with the motors of the build
+		fc::plant_params prm;
+		sil_airframe_s airframe;
+		sil_airframe(&airframe);
+		for (n=0; n<SIL_NB_OUTPUT; n++)
+			prm.mixer.push_back({airframe.coef[n][0], airframe.coef[n][1], airframe.coef[n][2]});
+		prm.dshot = (airframe.dshot != 0);
+		for (const std::string & p : params)
+			parse_param(p, prm);
+		fc::plant model(prm);
+		
+		double hover = hover_throttle(prm);
+		double rate_max[3] = {reg_value("RATE__PITCH_ROLL"), reg_value("RATE__PITCH_ROLL"), reg_value("RATE__YAW")};
+		
+		if (csv) {
+			std::fprintf(csv, "time,setpoint_pitch,setpoint_roll,setpoint_yaw,rate_pitch,rate_roll,rate_yaw,"
+				"gyro_x,gyro_y,gyro_z,angle_pitch,angle_roll,altitude,pid_pitch,pid_roll,pid_yaw");
+			for (n=0; n<SIL_NB_OUTPUT; n++)
+				std::fprintf(csv, ",motor_%zu", n);
+			std::fprintf(csv, "\n");
+		}
+		
+		std::vector<double> rate[3];
+		std::vector<double> setpoint[3];
+		std::vector<double> measure[3]; // Filtered gyro of the firmware
+		std::vector<double> motor[SIL_NB_OUTPUT];
+		float stick[SIL_RADIO_NB_CHAN] = {0, 0, 0, 0, 0, 0, 0, 0};
+		uint32_t motor_raw[SIL_NB_OUTPUT] = {0, 0, 0, 0};
+		size_t step_start[3] = {0, 0, 0};
+		double alt_i = 0;
+		float gyro[3];
+		float accel[3];
+		float temperature;
+		sil_output_s o;
+		std::string row;
+		uint32_t t;
+		uint32_t k;
+		int a;
+		
+		sil_timing_reset();
+		for (t=0; t<T_END; t++) {
+			std::array<double, 3> r = model.rate();
+			std::array<double, 2> att = model.attitude();
+			
+			// Pilot, at the radio period: arm, altitude hold and level in acro, doublets on each axis
+			if ((t * 1000) % RADIO_PERIOD == 0) {
+				stick[4] = (t >= T_ARM) ? 0.5f : 0.0f; // Armed in acro
+				if (t < T_TAKEOFF)
+					stick[0] = 0;
+				else {
+					double z = (t < T_LAND) ? ALTITUDE : -1.0;
+					alt_i += ALT_I * (z - model.position()[2]) * RADIO_PERIOD * 1e-6;
+					stick[0] = (float)std::clamp(hover + alt_i + ALT_P * (z - model.position()[2]) - ALT_D * model.velocity()[2],
+						0.0, 1.0);
+				}
+				stick[2] = (float)(-LEVEL_GAIN * att[PITCH] / rate_max[PITCH]);
+				stick[1] = (float)(-LEVEL_GAIN * att[ROLL] / rate_max[ROLL]);
+				stick[3] = 0;
+				for (a=0; a<3; a++) {
+					uint32_t s = T_STEP + (uint32_t)a * STEP_PERIOD;
+					if ((t < s) || (t >= s + 2 * STEP_TIME))
+						continue;
+					float x = (t < s + STEP_TIME) ? (float)amplitude : -(float)amplitude;
+					if (a == PITCH)
+						stick[2] = x;
+					else if (a == ROLL)
+						stick[1] = x;
+					else
+						stick[3] = x;
+				}
+				sil_sticks(stick);
+			}
+			
+			// The motor commands of the last sample act until the next one
+			model.step(SENSOR_PERIOD * 1e-6, motor_raw);
+			model.measure(gyro, accel, temperature);
+			sil_mpu(SENSOR_PERIOD, gyro, accel, temperature);
+			sil_output(&o);
+			for (n=0; n<SIL_NB_OUTPUT; n++) {
+				motor_raw[n] = o.motor[n];
+				motor[n].push_back(o.motor[n]);
+			}
+			
+			r = model.rate();
+			for (a=0; a<3; a++) {
+				rate[a].push_back(r[a]);
+				setpoint[a].push_back(o.setpoint[a]);
+				measure[a].push_back(o.gyro[a]);
+				// The setpoint changes with the first radio frame of the doublet
+				uint32_t s = T_STEP + (uint32_t)a * STEP_PERIOD;
+				if ((step_start[a] == 0) && (t >= s) && (std::fabs(o.setpoint[a] - setpoint[a][s - 1]) > 1.0))
+					step_start[a] = t;
+			}
+			
+			// Flipped over, or back on the ground before the landing
+			att = model.attitude();
+			if ((t > T_HOVER) && (t < T_LAND) && (model.on_ground() || (model.up()[2] < 0.0)))
+				crashed = true;
+			
+			if (!csv)
+				continue;
+			row = std::to_string(o.time);
+			for (a=0; a<3; a++)
+				csv_add(row, o.setpoint[a]);
+			for (a=0; a<3; a++)
+				csv_add(row, (float)r[a]);
+			for (a=0; a<3; a++)
+				csv_add(row, o.gyro[a]);
+			csv_add(row, (float)att[0]);
+			csv_add(row, (float)att[1]);
+			csv_add(row, (float)model.position()[2]);
+			for (a=0; a<3; a++)
+				csv_add(row, o.pid[a]);
+			for (n=0; n<SIL_NB_OUTPUT; n++)
+				csv_add(row, o.motor[n]);
+			row += '\n';
+			std::fwrite(row.data(), 1, row.size(), csv);
+		}
+		
+		// Step responses and hover noise, deterministic for a config and a seed
+		std::printf("crashed = %d\n", crashed ? 1 : 0);
+		std::printf("hover_throttle = %.3f\n", hover);
+		for (a=0; a<3; a++) {
+			size_t end = T_STEP + (size_t)a * STEP_PERIOD + STEP_TIME;
+			step_result s = step_response(rate[a], setpoint[a], step_start[a], end);
+			std::printf("%s.step = %.1f\n", axis_name[a], setpoint[a][end - 1]);
+			std::printf("%s.rise_ms = %.0f\n", axis_name[a], s.rise);
+			std::printf("%s.overshoot_pct = %.1f\n", axis_name[a], s.overshoot);
+			std::printf("%s.settling_ms = %.0f\n", axis_name[a], s.settling);
+			std::printf("%s.error_dps = %.2f\n", axis_name[a], s.error);
+			std::printf("%s.hover_noise_dps = %.3f\n", axis_name[a], rms(rate[a], T_HOVER, T_STEP));
+			std::printf("%s.gyro_noise_dps = %.3f\n", axis_name[a], rms(measure[a], T_HOVER, T_STEP));
+		}
+		for (n=0; n<SIL_NB_OUTPUT; n++)
+			std::printf("motor_%zu.hover_noise = %.2f\n", n, rms(motor[n], T_HOVER, T_STEP));
+		
+		// Host time of the stages, varies from run to run
+		for (k=0; k<SIL_NB_TIMING; k++) {
+			const sil_timing_s & s = sil_timing[k];
+			if (s.count == 0)
+				continue;
+			std::string name = sil_timing_name[k];
+			for (char & c : name) {
+				if (c == ' ')
+					c = '_';
+			}
+			std::printf("cpu.%s.mean_ns = %.0f\n", name.c_str(), (double)s.total / (double)s.count);
+			std::printf("cpu.%s.max_ns = %llu\n", name.c_str(), (unsigned long long)s.max);
+		}
+	}
+	catch (const std::exception & e) {
+		std::fprintf(stderr, "fcsil: %s\n", e.what());
+		return 1;
+	}
+	
+	if (csv)
+		std::fclose(csv);
+	
+	return crashed ? 1 : 0;
+}
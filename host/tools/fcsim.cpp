@@ -0,0 +1,352 @@
+// Stand-in for the board on a pseudo-terminal, to run fcctl and the host tools without hardware
+// Register map with RAM and flash copies, the host instructions of reg_access() and the telemetry
+// channels with synthetic data (sensor task at 1 kHz, radio at 50 Hz, VBAT at 10 Hz)
+
+#include <chrono>
+#include <cmath>
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <fcntl.h>
+#include <poll.h>
+#include <termios.h>
+#include <unistd.h>
+
+#include "fc/protocol.h"
+#include "fc/registers.h"
+#include "fc/telemetry.h"
+
+static volatile sig_atomic_t stop = 0;
+
+static void on_signal(int)
+{
+	stop = 1;
+}
+
+struct board {
+	int fd; // pty master
+	unsigned loss; // Drop one frame in loss, 0 for none
+	uint64_t nb_sent;
+	std::vector<uint32_t> reg;
+	std::vector<uint32_t> flash;
+	std::vector<uint8_t> rx;
+	fc::telemetry_encoder telemetry_sensor;
+	fc::telemetry_encoder telemetry_radio;
+	fc::telemetry_encoder telemetry_vbat;
+	uint16_t count[fc::TELEMETRY_NB_CHANNEL];
+};
+
+static uint32_t field(const board & b, const char * name)
+{
+	std::optional<fc::reg_field> f = fc::reg_find(name);
+	
+	return (uint32_t)fc::reg_get(*f, b.reg[f->reg->addr]);
+}
+
+// The host link drops what it cannot send, like the USB CDC ring of the board
+static void send(board & b, const uint8_t * data, size_t size)
+{
+	if (::write(b.fd, data, size) < 0) {}
+}
+
+static void send_frame(board & b, const std::vector<uint8_t> & frame)
+{
+	if (frame.empty())
+		return;
+	b.nb_sent++;
+	if (b.loss && (b.nb_sent % b.loss == 0))
+		return;
+	send(b, frame.data(), frame.size());
+}
+
+static void block_read(board & b, const std::vector<uint32_t> & src, uint8_t addr, uint8_t count)
+{
+	std::vector<uint8_t> r;
+	uint16_t crc;
+	size_t i;
+	
+	if (addr >= src.size())
+		count = 0;
+	else if (count > src.size() - addr)
+		count = (uint8_t)(src.size() - addr);
+	if (count > fc::REG_BLOCK_MAX)
+		count = fc::REG_BLOCK_MAX;
+	
+	for (i=0; i<count; i++) {
+		r.push_back((uint8_t)src[addr + i]);
+		r.push_back((uint8_t)(src[addr + i] >> 8));
+		r.push_back((uint8_t)(src[addr + i] >> 16));
+		r.push_back((uint8_t)(src[addr + i] >> 24));
+	}
+	crc = fc::crc16(r.data(), r.size());
+	r.push_back((uint8_t)crc);
+	r.push_back((uint8_t)(crc >> 8));
+	send(b, r.data(), r.size());
+}
+
+// Return the bytes of the command, 0 until it is complete
+static size_t command(board & b)
+{
+	const uint8_t * c = b.rx.data();
+	uint8_t instr = c[0];
+	uint8_t addr = c[1];
+	uint32_t data = c[2] | (c[3] << 8) | (c[4] << 16) | ((uint32_t)c[5] << 24);
+	uint8_t count = c[2];
+	uint8_t status;
+	uint32_t x;
+	size_t i;
+	
+	switch (instr) {
+		case 0: // REG read
+		case 4: // Flash read
+		{
+			x = (addr < b.reg.size()) ? ((instr == 0) ? b.reg[addr] : b.flash[addr]) : 0;
+			send(b, (const uint8_t*)&x, 4);
+			break;
+		}
+		case 1: // REG write
+		{
+			if ((addr < b.reg.size()) && !fc::reg_map()[addr].read_only)
+				b.reg[addr] = data;
+			break;
+		}
+		case 5: // Flash write, programming only clears bits
+		{
+			if (addr < b.flash.size())
+				b.flash[addr] &= data;
+			break;
+		}
+		case 6: // Flash page erase
+		{
+			for (uint32_t & f : b.flash)
+				f = 0xFFFFFFFF;
+			break;
+		}
+		case 9: // REG block read
+		case 13: // Flash block read
+		{
+			block_read(b, (instr == 9) ? b.reg : b.flash, addr, count);
+			break;
+		}
+		case 10: // REG block write
+		case 14: // Flash block write
+		{
+			if ((count <= fc::REG_BLOCK_MAX) && (b.rx.size() < fc::HOST_CMD_SIZE + count * 4u))
+				return 0;
+			if ((count == 0) || (count > fc::REG_BLOCK_MAX) || (addr >= b.reg.size()) || (count > b.reg.size() - addr) ||
+			    (fc::crc16(&c[fc::HOST_CMD_SIZE], count * 4) != (c[4] | (c[5] << 8)))) {
+				status = 1;
+				send(b, &status, 1);
+				return (count <= fc::REG_BLOCK_MAX) ? fc::HOST_CMD_SIZE + count * 4 : fc::HOST_CMD_SIZE;
+			}
+			for (i=0; i<count; i++) {
+				std::memcpy(&x, &c[fc::HOST_CMD_SIZE + 4 * i], 4);
+				if (instr == 14)
+					b.flash[addr + i] &= x;
+				else if (!fc::reg_map()[addr + i].read_only)
+					b.reg[addr + i] = x;
+			}
+			status = 0;
+			send(b, &status, 1);
+			return fc::HOST_CMD_SIZE + count * 4;
+		}
+		case 11: // Blackbox dump, empty log
+		{
+			uint8_t r[1 + fc::BLACKBOX_DUMP_SIZE + 2];
+			uint16_t crc;
+			r[0] = 0;
+			std::memset(&r[1], 0xFF, fc::BLACKBOX_DUMP_SIZE);
+			crc = fc::crc16(r, 1 + fc::BLACKBOX_DUMP_SIZE);
+			r[1 + fc::BLACKBOX_DUMP_SIZE] = (uint8_t)crc;
+			r[2 + fc::BLACKBOX_DUMP_SIZE] = (uint8_t)(crc >> 8);
+			send(b, r, sizeof(r));
+			break;
+		}
+		case 12: // Latency trace, no samples
+		{
+			std::vector<uint32_t> trace(fc::LATENCY_SIZE, 0);
+			trace[0] = 72; // Ticks per us
+			trace[1] = 1u << field(b, "LATENCY__BIN");
+			block_read(b, trace, addr, count);
+			break;
+		}
+	}
+	
+	return fc::HOST_CMD_SIZE;
+}
+
+// Return 1 if the channel is selected and its decimation is reached, as telemetry_due()
+static bool due(const board & b, uint8_t channel)
+{
+	uint32_t mask;
+	
+	if ((field(b, "DEBUG") & (1 << channel)) == 0)
+		return false;
+	
+	mask = (1 << ((field(b, "DEBUG_RATE") >> (4 * channel)) & 0x0F)) - 1;
+	return (b.count[channel] & mask) == 0;
+}
+
+// Synthetic payload of a channel, slow sines with a little noise
+static std::vector<uint8_t> payload(uint8_t channel, double t)
+{
+	const fc::telemetry_channel & c = fc::telemetry_channels[channel];
+	std::vector<uint8_t> p(c.size);
+	double v;
+	float f;
+	int16_t s;
+	uint16_t u;
+	uint32_t w;
+	int i;
+	
+	for (i=0; i<c.nb; i++) {
+		v = std::sin(2 * M_PI * (0.5 + 0.3 * i) * t + i) + 0.01 * (std::rand() % 100 - 50) / 50.0;
+		switch (c.type) {
+			case fc::field_type::int16:
+				s = (int16_t)(v * 2000);
+				std::memcpy(&p[2*i], &s, 2);
+				break;
+			case fc::field_type::uint16:
+				u = (uint16_t)(1500 + v * 500);
+				std::memcpy(&p[2*i], &u, 2);
+				break;
+			case fc::field_type::uint32:
+				w = (uint32_t)(1500 + v * 400);
+				std::memcpy(&p[4*i], &w, 4);
+				break;
+			default:
+				f = (channel == fc::TELEMETRY_NB_CHANNEL - 1) ? (float)(12.0 + 0.2 * v) : (float)(100 * v);
+				std::memcpy(&p[4*i], &f, 4);
+				break;
+		}
+	}
+	
+	return p;
+}
+
+static void tick(board & b, uint64_t n)
+{
+	static const uint8_t sensor[] = {0, 1, 2, 5, 6};
+	uint32_t time = (uint32_t)(n * 1000);
+	double t = n / 1000.0;
+	bool delta = field(b, "DEBUG_DELTA__ENABLE") != 0;
+	uint8_t keyframe = (uint8_t)field(b, "DEBUG_DELTA__KEYFRAME");
+	
+	b.telemetry_sensor.start(time, delta);
+	for (uint8_t ch : sensor) {
+		if (due(b, ch))
+			b.telemetry_sensor.add(ch, payload(ch, t), keyframe);
+		b.count[ch]++;
+	}
+	send_frame(b, b.telemetry_sensor.finish());
+	
+	if (n % 20 == 0) {
+		b.telemetry_radio.start(time, delta);
+		for (uint8_t ch = 3; ch <= 4; ch++) {
+			if (due(b, ch))
+				b.telemetry_radio.add(ch, payload(ch, t), keyframe);
+			b.count[ch]++;
+		}
+		send_frame(b, b.telemetry_radio.finish());
+	}
+	
+	if (n % 100 == 0) {
+		b.telemetry_vbat.start(time, delta);
+		if (due(b, 7))
+			b.telemetry_vbat.add(7, payload(7, t), keyframe);
+		b.count[7]++;
+		send_frame(b, b.telemetry_vbat.finish());
+	}
+}
+
+int main(int argc, char ** argv)
+{
+	board b;
+	std::string link;
+	struct termios tio;
+	uint8_t buf[4096];
+	ssize_t n;
+	size_t used;
+	uint64_t ticks = 0;
+	int slave;
+	int i;
+	
+	b.loss = 0;
+	for (i=1; i<argc; i++) {
+		if ((std::strcmp(argv[i], "-l") == 0) && (i + 1 < argc))
+			link = argv[++i];
+		else if ((std::strcmp(argv[i], "--loss") == 0) && (i + 1 < argc))
+			b.loss = (unsigned)std::atoi(argv[++i]);
+		else {
+			std::fprintf(stderr, "usage: fcsim [-l LINK] [--loss N]\n"
+				"  -l LINK    symlink to the pseudo-terminal\n"
+				"  --loss N   drop one telemetry frame in N\n");
+			return 2;
+		}
+	}
+	
+	b.fd = ::posix_openpt(O_RDWR | O_NOCTTY);
+	if ((b.fd < 0) || (::grantpt(b.fd) < 0) || (::unlockpt(b.fd) < 0)) {
+		std::perror("fcsim: posix_openpt");
+		return 1;
+	}
+	::fcntl(b.fd, F_SETFL, O_NONBLOCK);
+	
+	// Keep the slave open and raw, the master reads fail while no slave is open
+	slave = ::open(::ptsname(b.fd), O_RDWR | O_NOCTTY);
+	::tcgetattr(slave, &tio);
+	::cfmakeraw(&tio);
+	::tcsetattr(slave, TCSANOW, &tio);
+	
+	if (!link.empty()) {
+		::unlink(link.c_str());
+		if (::symlink(::ptsname(b.fd), link.c_str()) < 0) {
+			std::perror("fcsim: symlink");
+			return 1;
+		}
+	}
+	std::printf("%s\n", ::ptsname(b.fd));
+	std::fflush(stdout);
+	
+	for (const fc::reg_info & r : fc::reg_map()) {
+		b.reg.push_back(r.dflt);
+		b.flash.push_back(r.flash ? r.dflt : 0xFFFFFFFF);
+	}
+	std::memset(b.count, 0, sizeof(b.count));
+	b.nb_sent = 0;
+	
+	std::signal(SIGINT, on_signal);
+	std::signal(SIGTERM, on_signal);
+	
+	auto next = std::chrono::steady_clock::now();
+	while (!stop) {
+		n = ::read(b.fd, buf, sizeof(buf));
+		if (n > 0)
+			b.rx.insert(b.rx.end(), buf, buf + n);
+		while (b.rx.size() >= fc::HOST_CMD_SIZE) {
+			used = command(b);
+			if (used == 0)
+				break;
+			b.rx.erase(b.rx.begin(), b.rx.begin() + used);
+		}
+		
+		// Catch up after a late wake up, the time stamps stay regular
+		while (std::chrono::steady_clock::now() >= next) {
+			tick(b, ticks++);
+			next += std::chrono::milliseconds(1);
+		}
+		std::this_thread::sleep_until(next);
+	}
+	
+	if (!link.empty())
+		::unlink(link.c_str());
+	::close(slave);
+	::close(b.fd);
+	
+	return 0;
+}
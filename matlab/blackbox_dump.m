@@ -0,0 +1,36 @@
+function sessions = blackbox_dump(file)
+% Read the flight log from the blackbox flash and decode it
+% file: optional, the raw log is also saved to this file
+
+global fc
+global ser
+
+DumpSize = 128; % BLACKBOX_DUMP_SIZE
+
+fc.target = 0;
+n = double(fc.BLACKBOX_STATUS__PAGES) * 256;
+raw = zeros(1,n);
+addr = 0;
+while addr < n
+	fwrite(ser,[11,0,floor(mod(addr ./ 2.^(0:8:24),2^8))]);
+	r = fread(ser,DumpSize+3)';
+	if length(r) ~= DumpSize+3 || crc16(r(1:DumpSize+1)) ~= r(DumpSize+2) + 256*r(DumpSize+3)
+		error('blackbox_dump: read failed at address %d', addr);
+	end
+	if r(1) == 0
+		raw(addr+1:addr+DumpSize) = r(2:DumpSize+1);
+		addr = addr + DumpSize;
+	else
+		sleep(10); % Flash busy (page program or erase)
+	end
+end
+
+if nargin > 0
+	f = fopen(file,'w');
+	fwrite(f,raw);
+	fclose(f);
+end
+
+sessions = blackbox_decode(raw);
+
+end
@@ -4,18 +4,13 @@ if nargin < 2, NbSamples = 512; end
 
 global fc
 global ser
+global port
 
 %% To Customize
 WindowSize = 256;
-switch DebugCase
-	case {1,2,3,6,7} % sensor rate (1kHz)
-      SampleMask = hex2dec('001F');
-	case {4,5} % radio rate (~100Hz)
-		SampleMask = hex2dec('0003');
-	case 8 % vbat rate (100Hz)
-		SampleMask = hex2dec('0003');
-end
+% Decimation of each channel: DEBUG_RATE register
 c = 'brgcmkyb';
+Channel = DebugCase - 1; % Telemetry channel (bit of the DEBUG register)
 
 %%
 figure(DebugCase);
@@ -38,7 +33,7 @@ switch DebugCase
 		l{4} = line(nan(1,WindowSize),nan(1,WindowSize),'Parent',a{3},'Color',c(1));
 	case 2 % scaled sensors
 		dlen = 7;
-		dtype = 'float';
+		dtype = 'single';
 		for n = 1:3
 			a{n} = subplot(3,1,n);
 		end
@@ -52,7 +47,7 @@ switch DebugCase
 		l{7} = line(nan(1,WindowSize),nan(1,WindowSize),'Parent',a{3},'Color',c(1));
 	case 3 % angle
       dlen = 4;
-		dtype = 'float';
+		dtype = 'single';
       for n = 1:2
          a{n} = subplot(2,1,n);
          a{n}.YLim = [-180,180];
@@ -70,7 +65,7 @@ switch DebugCase
 		end
 	case 5 % commands
 		dlen = 8;
-		dtype = 'float';
+		dtype = 'single';
 		a{1} = subplot(211);
 		a{2} = subplot(212);
 		a{1}.YLim = [-1.05,1.05];
@@ -87,7 +82,7 @@ switch DebugCase
 		end
 	case 6 % pitch, roll, yaw
 		dlen = 3;
-		dtype = 'float';
+		dtype = 'single';
 		a{1} = axes;
 		for n = 1:3
 			l{n} = line(nan(1,WindowSize),nan(1,WindowSize),'Parent',a{1},'Color',c(n));
@@ -102,7 +97,7 @@ switch DebugCase
       end
    case 8 % vbat
 		dlen = 1;
-		dtype = 'float';
+		dtype = 'single';
 		a{1} = axes;
 		l{1} = line(nan(1,WindowSize),nan(1,WindowSize),'Parent',a{1},'Color',c(1));
 end
@@ -112,13 +107,11 @@ for n = 1:length(a)
 end
 
 d = nan(dlen,WindowSize);
-switch dtype
-	case {'uint16','int16'}
-		r1 = 2*dlen;
-	case {'uint32','float'}
-		r1 = 4*dlen;
-end
 n = 0;
+buf = [];
+clear telemetry_decode % Reset the delta decoder
+seq = -1;
+lost = 0;
 
 % Empty VCP buffer
 fc.DEBUG(0);
@@ -128,36 +121,68 @@ while (ser.BytesAvailable > 0)
    sleep(10);
 end
 
-fc.DEBUG__MASK(SampleMask);
-fc.DEBUG__CASE(DebugCase);
-
-while (n < NbSamples)
+if exist('fc_stream') == 3
+	% Compiled decoder (fc_stream/make.m): a thread drains the port, full rate channels can be plotted
+	% It opens its own handle on the port, the serial object is closed meanwhile
+	fclose(ser);
+	fc_stream('open', port);
+	fc_stream('write', [1, fc.info.DEBUG(1), 2^Channel, 0, 0, 0]);
 	
-	if (ser.BytesAvailable >= r1)
-
-		r = fread(ser,r1);
-		n = n + 1;
-
+	while (n < NbSamples)
+		x = fc_stream('read', Channel);
+		if isempty(x)
+			sleep(10);
+			continue
+		end
+		m = min(size(x,2), WindowSize);
+		n = n + size(x,2);
+		d(:,1:WindowSize-m) = d(:,m+1:WindowSize);
+		d(:,WindowSize-m+1:WindowSize) = x(1:dlen,end-m+1:end);
+		
 		for m = 1:dlen
-			switch dtype
-            case 'uint16'
-					d(m,WindowSize) = 2^8*r((m-1)*2+2) + r((m-1)*2+1);
-				case 'int16'
-					d(m,WindowSize) = c2s(2^8*r((m-1)*2+2) + r((m-1)*2+1), 16);
-            case 'uint32'
-					d(m,WindowSize) = 2^24*r((m-1)*4+4) + 2^16*r((m-1)*4+3) + 2^8*r((m-1)*4+2) + r((m-1)*4+1);
-				case 'float'
-					d(m,WindowSize) = typecast(uint32(2^24*r((m-1)*4+4) + 2^16*r((m-1)*4+3) + 2^8*r((m-1)*4+2) + r((m-1)*4+1)), 'single');
-				end
 			set(l{m},'XData',1:WindowSize);
 			set(l{m},'YData',d(m,:));
 		end
 		drawnow
-
-		d(:,1:WindowSize-1) = d(:,2:WindowSize);
-
 	end
-
+	
+	fc_stream('write', [1, fc.info.DEBUG(1), 0, 0, 0, 0]);
+	s = fc_stream('stats');
+	lost = s(3); % Delta payloads
+	fc_stream('close');
+	fopen(ser);
+	
+else
+	fc.DEBUG(2^Channel);
+	
+	while (n < NbSamples)
+		
+		if (ser.BytesAvailable > 0)
+	
+			[frames, buf] = telemetry_decode([buf, fread(ser,ser.BytesAvailable)']);
+	
+			for k = 1:length(frames)
+				if seq >= 0
+					lost = lost + mod(frames(k).seq - seq - 1, 256);
+				end
+				seq = frames(k).seq;
+				p = frames(k).payload{Channel+1};
+				if ~isempty(p)
+					n = n + 1;
+					d(:,1:WindowSize-1) = d(:,2:WindowSize);
+					d(:,WindowSize) = double(typecast(uint8(p), dtype));
+				end
+			end
+	
+			for m = 1:dlen
+				set(l{m},'XData',1:WindowSize);
+				set(l{m},'YData',d(m,:));
+			end
+			drawnow
+	
+		end
+	
+	end
 end
 
 % Empty VCP buffer
@@ -168,4 +193,8 @@ while (ser.BytesAvailable > 0)
    sleep(10);
 end
 
+if lost > 0
+	fprintf('%d frames lost\n', lost);
+end
+
 end
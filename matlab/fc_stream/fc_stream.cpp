@@ -0,0 +1,238 @@
+//------ Include ------//
+
+#include <chrono>
+#include <cstring>
+#include <memory>
+#include <vector>
+
+#include "mex.h"
+#include "fc/serial.h"
+#include "fc/telemetry.h"
+
+//------ Macro and type defines ------//
+
+#define ERROR_IF(condition, message, arg) \
+	if (condition) \
+		{ \
+			mexPrintf("ERROR during ""%s"": ", CommandName); \
+			mexPrintf(message, arg); \
+			mexPrintf("\n"); \
+			plhs[0] = mxCreateDoubleScalar(-1); \
+			mxFree(CommandName); \
+			return; \
+		}
+
+#define SAMPLES_MAX 1000000 // Payloads kept per channel between two reads
+
+//------ Global variables ------//
+
+static std::unique_ptr<fc::serial> Port; // Its thread drains the port into a lock-free ring
+static fc::telemetry_decoder Decoder;
+static std::vector<double> Samples[fc::TELEMETRY_NB_CHANNEL]; // Time (us) and fields of each payload, not read yet
+static double SamplesDropped; // Payloads dropped because the channel was not read
+
+//------ Functions ------//
+
+static void Close(void)
+{
+	Port.reset();
+}
+
+static void Store(const fc::telemetry_frame & Frame)
+{
+	uint8_t Channel;
+	std::vector<double> Values;
+	
+	for (Channel = 0; Channel < fc::TELEMETRY_NB_CHANNEL; Channel++)
+	{
+		if (Frame.payload[Channel].empty())
+			continue;
+		if (Samples[Channel].size() >= (size_t)SAMPLES_MAX * (fc::telemetry_channels[Channel].nb + 1))
+		{
+			SamplesDropped++;
+			continue;
+		}
+		Values = fc::telemetry_values(Channel, Frame.payload[Channel]);
+		Samples[Channel].push_back(Frame.time);
+		Samples[Channel].insert(Samples[Channel].end(), Values.begin(), Values.end());
+	}
+}
+
+// Decode what the serial thread has received so far
+static void Drain(void)
+{
+	static uint8_t Buffer[65536];
+	size_t n;
+	
+	while ((n = Port->read_some(Buffer, sizeof(Buffer), std::chrono::milliseconds(0))) > 0)
+		Decoder.feed(Buffer, n, Store);
+}
+
+static void Clear(void)
+{
+	size_t i;
+	
+	Decoder.reset();
+	for (i = 0; i < fc::TELEMETRY_NB_CHANNEL; i++)
+		Samples[i].clear();
+	SamplesDropped = 0;
+}
+
+//------ Main function ------//
+
+void mexFunction (int nlhs, mxArray * plhs[], int nrhs, const mxArray * prhs[])
+{
+	//------ Local variables ------//
+	
+	char * CommandName; // Matlab command
+	char * PortName;
+	double * DataArray;
+	std::vector<uint8_t> Data;
+	int Channel;
+	int Baud;
+	size_t Nb;
+	size_t Count;
+	size_t i, j;
+	
+	//------ Help ------//
+	
+	if (nrhs < 1)
+	{
+		mexPrintf("fc_stream()\n");
+		mexPrintf("	Print this readme.\n");
+		mexPrintf("fc_stream('open', port, [baud])\n");
+		mexPrintf("	Open the serial port (COM21, /dev/ttyACM0) and drain it in a background thread.\n");
+		mexPrintf("	The Matlab serial object must be closed meanwhile (Windows opens a port only once).\n");
+		mexPrintf("fc_stream('close')\n");
+		mexPrintf("	Stop the thread and close the port.\n");
+		mexPrintf("fc_stream('write', bytes)\n");
+		mexPrintf("	Send a host command, e.g. [1, fc.info.DEBUG(1), mask, 0, 0, 0] to write the DEBUG register.\n");
+		mexPrintf("[x, t] = fc_stream('read', channel)\n");
+		mexPrintf("	Decode the telemetry received so far and return the payloads of channel (bit of DEBUG) not read yet.\n");
+		mexPrintf("	x: one column per payload (fields), t: time in us. Raw and delta frames are both decoded.\n");
+		mexPrintf("	Up to %d payloads are kept per channel, read all the enabled channels.\n", SAMPLES_MAX);
+		mexPrintf("fc_stream('flush')\n");
+		mexPrintf("	Drop the telemetry received so far and reset the decoder.\n");
+		mexPrintf("fc_stream('stats')\n");
+		mexPrintf("	Return [frames, CRC errors, delta payloads lost, bytes dropped by the ring, payloads dropped].\n");
+		mexPrintf("\n");
+		mexPrintf("open, close, write and flush return 0 for success and -1 for failure\n");
+		return;
+	}
+	
+	CommandName = mxArrayToString(prhs[0]);
+	if (CommandName == NULL)
+		mexErrMsgTxt("fc_stream: the first argument must be a command name");
+	
+	mexAtExit(Close);
+	
+	//------ Open ------//
+	
+	if (strcmp(CommandName, "open") == 0)
+	{
+		ERROR_IF((nrhs < 2) || !mxIsChar(prhs[1]), "%s", "Port name expected")
+		Baud = (nrhs > 2) ? (int)mxGetScalar(prhs[2]) : 115200;
+		PortName = mxArrayToString(prhs[1]);
+		
+		Close();
+		Clear();
+		try
+		{
+			Port.reset(new fc::serial(PortName, Baud));
+		}
+		catch (const std::exception & e)
+		{
+			mxFree(PortName);
+			ERROR_IF(true, "%s", e.what())
+		}
+		mxFree(PortName);
+		
+		plhs[0] = mxCreateDoubleScalar(0);
+	}
+	
+	//------ Close ------//
+	
+	else if (strcmp(CommandName, "close") == 0)
+	{
+		Close();
+		plhs[0] = mxCreateDoubleScalar(0);
+	}
+	
+	//------ Write ------//
+	
+	else if (strcmp(CommandName, "write") == 0)
+	{
+		ERROR_IF(!Port, "%s", "Port not open")
+		ERROR_IF((nrhs < 2) || !mxIsDouble(prhs[1]), "%s", "Bytes expected")
+		DataArray = mxGetPr(prhs[1]);
+		for (i = 0; i < mxGetNumberOfElements(prhs[1]); i++)
+			Data.push_back((uint8_t)DataArray[i]);
+		try
+		{
+			Port->write(Data.data(), Data.size());
+		}
+		catch (const std::exception & e)
+		{
+			ERROR_IF(true, "%s", e.what())
+		}
+		plhs[0] = mxCreateDoubleScalar(0);
+	}
+	
+	//------ Read ------//
+	
+	else if (strcmp(CommandName, "read") == 0)
+	{
+		ERROR_IF(!Port, "%s", "Port not open")
+		ERROR_IF(nrhs < 2, "%s", "Channel expected")
+		Channel = (int)mxGetScalar(prhs[1]);
+		ERROR_IF((Channel < 0) || ((size_t)Channel >= fc::TELEMETRY_NB_CHANNEL), "Channel %d does not exist", Channel)
+		
+		Drain();
+		
+		Nb = fc::telemetry_channels[Channel].nb;
+		Count = Samples[Channel].size() / (Nb + 1);
+		plhs[0] = mxCreateDoubleMatrix(Nb, Count, mxREAL);
+		DataArray = mxGetPr(plhs[0]);
+		for (i = 0; i < Count; i++)
+			for (j = 0; j < Nb; j++)
+				DataArray[i * Nb + j] = Samples[Channel][i * (Nb + 1) + 1 + j];
+		if (nlhs > 1)
+		{
+			plhs[1] = mxCreateDoubleMatrix(1, Count, mxREAL);
+			DataArray = mxGetPr(plhs[1]);
+			for (i = 0; i < Count; i++)
+				DataArray[i] = Samples[Channel][i * (Nb + 1)];
+		}
+		Samples[Channel].clear();
+	}
+	
+	//------ Flush ------//
+	
+	else if (strcmp(CommandName, "flush") == 0)
+	{
+		ERROR_IF(!Port, "%s", "Port not open")
+		Port->drain(std::chrono::milliseconds(20));
+		Clear();
+		plhs[0] = mxCreateDoubleScalar(0);
+	}
+	
+	//------ Stats ------//
+	
+	else if (strcmp(CommandName, "stats") == 0)
+	{
+		plhs[0] = mxCreateDoubleMatrix(1, 5, mxREAL);
+		DataArray = mxGetPr(plhs[0]);
+		DataArray[0] = (double)Decoder.frames();
+		DataArray[1] = (double)Decoder.crc_errors();
+		DataArray[2] = (double)Decoder.lost();
+		DataArray[3] = Port ? (double)Port->dropped() : 0;
+		DataArray[4] = SamplesDropped;
+	}
+	
+	else
+	{
+		ERROR_IF(true, "%s", "Unknown command")
+	}
+	
+	mxFree(CommandName);
+}
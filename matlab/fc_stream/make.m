@@ -0,0 +1,10 @@
+% fc_stream uses the serial link and the telemetry decoder of libfc (host/)
+src = {'fc_stream.cpp', '../../host/src/serial.cpp', '../../host/src/telemetry.cpp', '../../host/src/protocol.cpp'};
+if exist('OCTAVE_VERSION', 'builtin')
+   setenv('CXXFLAGS', [strtrim(mkoctfile('-p', 'CXXFLAGS')), ' -std=c++17 -pthread']);
+   mkoctfile('--mex', '-I../../host/include', src{:}, '-o', 'fc_stream', '-lpthread');
+elseif ispc
+   mex('COMPFLAGS=$COMPFLAGS /std:c++17', '-I../../host/include', src{:});
+else
+   mex('CXXFLAGS=$CXXFLAGS -std=c++17 -pthread', '-I../../host/include', src{:}, '-lpthread');
+end
@@ -2,6 +2,7 @@ restoredefaultpath
 addpath reg
 addpath utils
 addpath ftdi
+addpath fc_stream
 
 clear all
 
@@ -9,13 +10,15 @@ global fc
 global mpu
 global rf
 global ser
+global port
 
 fc = fc_reg;
 mpu = mpu_reg;
 rf = sx1276_reg;
 
 delete(instrfindall);
-ser = serial('COM21');
+port = 'COM21';
+ser = serial(port);
 ser.BaudRate = 115200;
 ser.Timeout = 1;
 fopen(ser);
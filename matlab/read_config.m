@@ -2,6 +2,7 @@ function read_config
 
 global fc
 
+fc.cache = fc.read_block(0, fc.nb_reg); % Whole map in a few block reads, the accessors below use the cache
 reg = fieldnames(fc.info);
 
 for n = 1:length(reg)
@@ -15,4 +16,6 @@ for n = 1:length(reg)
    end
 end
 
+fc.cache = [];
+
 end
\ No newline at end of file
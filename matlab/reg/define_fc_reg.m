@@ -30,8 +30,7 @@ n = n + 1;
 reg(n).name = 'DEBUG';
 reg(n).read_only = 0;
 reg(n).flash = 0;
-reg(n).subf{1} = {'CASE',7,0,'uint8',0};
-reg(n).subf{2} = {'MASK',23,8,'uint16',127};
+reg(n).subf{1} = {'DEBUG',7,0,'uint8',0};
 
 n = n + 1;
 reg(n).name = 'ERROR';
@@ -245,3 +244,155 @@ reg(n).read_only = 1;
 reg(n).flash = 1;
 reg(n).subf{1} = {'IDLE',15,0,'uint16',0};
 reg(n).subf{2} = {'RANGE',31,16,'uint16',0};
+
+n = n + 1;
+reg(n).name = 'SCHED';
+reg(n).read_only = 1;
+reg(n).flash = 0;
+reg(n).subf{1} = {'MISSED',15,0,'uint16',0};
+reg(n).subf{2} = {'OVERRUN',31,16,'uint16',0};
+
+n = n + 1;
+reg(n).name = 'SENSOR_PERIOD';
+reg(n).read_only = 1;
+reg(n).flash = 0;
+reg(n).subf{1} = {'MIN',15,0,'uint16',0};
+reg(n).subf{2} = {'MAX',31,16,'uint16',0};
+
+n = n + 1;
+reg(n).name = 'PID';
+reg(n).read_only = 0;
+reg(n).flash = 1;
+reg(n).subf{1} = {'D_ON_MEASURE',0,0,'uint8',0};
+reg(n).subf{2} = {'FEEDFORWARD',1,1,'uint8',1};
+reg(n).subf{3} = {'ANTI_WINDUP',2,2,'uint8',1};
+reg(n).subf{4} = {'SETPOINT_WEIGHT',15,8,'uint8',100};
+reg(n).subf{5} = {'D_TIME_CONSTANT',31,16,'uint16',0};
+
+n = n + 1;
+reg(n).name = 'MIXER';
+reg(n).read_only = 0;
+reg(n).flash = 1;
+reg(n).subf{1} = {'AIRMODE',0,0,'uint8',0};
+reg(n).subf{2} = {'SERVO_CENTER',31,16,'uint16',1000};
+
+n = n + 1;
+reg(n).name = 'GAIN_SCALE';
+reg(n).read_only = 0;
+reg(n).flash = 1;
+reg(n).subf{1} = {'TPA_BREAKPOINT',7,0,'uint8',100};
+reg(n).subf{2} = {'TPA_RATE',15,8,'uint8',0};
+reg(n).subf{3} = {'VBAT_REF',31,16,'uint16',0};
+
+n = n + 1;
+reg(n).name = 'FF_PITCH';
+reg(n).read_only = 0;
+reg(n).flash = 1;
+reg(n).subf{1} = {'FF_PITCH',31,0,'single',0};
+
+n = n + 1;
+reg(n).name = 'FF_ROLL';
+reg(n).read_only = 0;
+reg(n).flash = 1;
+reg(n).subf{1} = {'FF_ROLL',31,0,'single',0};
+
+n = n + 1;
+reg(n).name = 'FF_YAW';
+reg(n).read_only = 0;
+reg(n).flash = 1;
+reg(n).subf{1} = {'FF_YAW',31,0,'single',0};
+
+n = n + 1;
+reg(n).name = 'GYRO_TC_X';
+reg(n).read_only = 0;
+reg(n).flash = 1;
+reg(n).subf{1} = {'GYRO_TC_X',31,0,'single',0};
+
+n = n + 1;
+reg(n).name = 'GYRO_TC_Y';
+reg(n).read_only = 0;
+reg(n).flash = 1;
+reg(n).subf{1} = {'GYRO_TC_Y',31,0,'single',0};
+
+n = n + 1;
+reg(n).name = 'GYRO_TC_Z';
+reg(n).read_only = 0;
+reg(n).flash = 1;
+reg(n).subf{1} = {'GYRO_TC_Z',31,0,'single',0};
+
+n = n + 1;
+reg(n).name = 'GYRO_TC_TEMP';
+reg(n).read_only = 1;
+reg(n).flash = 1;
+reg(n).subf{1} = {'GYRO_TC_TEMP',31,0,'single',25};
+
+n = n + 1;
+reg(n).name = 'GYRO_TC';
+reg(n).read_only = 0;
+reg(n).flash = 1;
+reg(n).subf{1} = {'LEARN',0,0,'uint8',0};
+reg(n).subf{2} = {'TEMP_SPAN',15,8,'uint8',20};
+
+n = n + 1;
+reg(n).name = 'CAL';
+reg(n).read_only = 1;
+reg(n).flash = 0;
+reg(n).subf{1} = {'SENSOR',7,0,'uint8',0};
+reg(n).subf{2} = {'RADIO_IDLE',15,8,'uint8',0};
+reg(n).subf{3} = {'RADIO_RANGE',23,16,'uint8',0};
+
+n = n + 1;
+reg(n).name = 'DEBUG_RATE';
+reg(n).read_only = 0;
+reg(n).flash = 0;
+reg(n).subf{1} = {'SENSOR_RAW',3,0,'uint8',5};
+reg(n).subf{2} = {'SENSOR',7,4,'uint8',5};
+reg(n).subf{3} = {'ANGLE',11,8,'uint8',5};
+reg(n).subf{4} = {'RADIO_RAW',15,12,'uint8',2};
+reg(n).subf{5} = {'RADIO',19,16,'uint8',2};
+reg(n).subf{6} = {'PID',23,20,'uint8',5};
+reg(n).subf{7} = {'MOTOR',27,24,'uint8',5};
+reg(n).subf{8} = {'VBAT',31,28,'uint8',2};
+
+n = n + 1;
+reg(n).name = 'BLACKBOX';
+reg(n).read_only = 0;
+reg(n).flash = 1;
+reg(n).subf{1} = {'ENABLE',0,0,'uint8',1};
+reg(n).subf{2} = {'RATE',7,4,'uint8',0};
+reg(n).subf{3} = {'ERASE',8,8,'uint8',0};
+
+n = n + 1;
+reg(n).name = 'BLACKBOX_STATUS';
+reg(n).read_only = 1;
+reg(n).flash = 0;
+reg(n).subf{1} = {'PAGES',15,0,'uint16',0};
+reg(n).subf{2} = {'DROPPED',31,16,'uint16',0};
+
+n = n + 1;
+reg(n).name = 'DEBUG_DELTA';
+reg(n).read_only = 0;
+reg(n).flash = 0;
+reg(n).subf{1} = {'ENABLE',0,0,'uint8',1};
+reg(n).subf{2} = {'KEYFRAME',6,4,'uint8',4};
+
+n = n + 1;
+reg(n).name = 'BENCH';
+reg(n).read_only = 0;
+reg(n).flash = 0;
+reg(n).subf{1} = {'RUN',0,0,'uint8',0};
+reg(n).subf{2} = {'ITEM',11,8,'uint8',0};
+
+n = n + 1;
+reg(n).name = 'BENCH_RESULT';
+reg(n).read_only = 1;
+reg(n).flash = 0;
+reg(n).subf{1} = {'BENCH_RESULT',31,0,'single',0};
+
+n = n + 1;
+reg(n).name = 'LATENCY';
+reg(n).read_only = 0;
+reg(n).flash = 0;
+reg(n).subf{1} = {'ENABLE',0,0,'uint8',0};
+reg(n).subf{2} = {'RESET',1,1,'uint8',0};
+reg(n).subf{3} = {'BIN',7,4,'uint8',3};
@@ -2,7 +2,9 @@ classdef fc_reg
 	methods
 		function data = read(obj,addr)
 			global ser
-			if obj.method
+			if ~isempty(obj.cache)
+				data = obj.cache(addr+1);
+			elseif obj.method
 				r = sx1272_receive(0);
 				sx1272_send([0,addr,0,0,0,0],1);
 				sleep(300);
@@ -21,6 +23,43 @@ classdef fc_reg
 				fwrite(ser,[obj.target*4+1,addr,floor(mod(double(data) ./ 2.^(0:8:24),2^8))]);
 			end
 		end
+		function data = read_block(obj,addr,count)
+			global ser
+			data = zeros(1,count,'uint32');
+			for k = 0:obj.block_max:count-1
+				n = min(obj.block_max, count-k);
+				if obj.method
+					for m = 1:n
+						data(k+m) = obj.read(addr+k+m-1);
+					end
+				else
+					fwrite(ser,[obj.target*4+9,addr+k,n,0,0,0]);
+					r = fread(ser,4*n+2)';
+					if length(r) ~= 4*n+2 || crc16(r(1:4*n)) ~= r(4*n+1) + 256*r(4*n+2)
+						error('fc_reg: block read failed at address %d', addr+k);
+					end
+					data(k+1:k+n) = uint32(sum(reshape(r(1:4*n),4,n) .* 2.^(0:8:24)', 1));
+				end
+			end
+		end
+		function write_block(obj,addr,data)
+			global ser
+			for k = 0:obj.block_max:length(data)-1
+				d = double(data(k+1:min(k+obj.block_max,end)));
+				if obj.method
+					for m = 1:length(d)
+						obj.write(addr+k+m-1, d(m));
+					end
+				else
+					b = reshape(floor(mod(d ./ 2.^(0:8:24)',2^8)), 1, []);
+					c = crc16(b);
+					fwrite(ser,[obj.target*4+10,addr+k,length(d),0,mod(c,256),floor(c/256),b]);
+					if fread(ser,1) ~= 0
+						error('fc_reg: block write rejected at address %d', addr+k);
+					end
+				end
+			end
+		end
 		function y = VERSION(obj,x)
 			if nargin < 2
 				y = obj.read(0);
@@ -139,26 +178,6 @@ classdef fc_reg
 				obj.write(3, uint32(x));
 			end
 		end
-		function y = DEBUG__CASE(obj,x)
-			r = double(obj.read(3));
-			if nargin < 2
-				z = typecast(uint32(bitshift(bitand(r, 255), 0)),'uint8');
-				y = z(1);
-			else
-				w = bitand(bitshift(double(x), 0), 255) + bitand(r, 4294967040);
-				obj.write(3, uint32(w));
-			end
-		end
-		function y = DEBUG__MASK(obj,x)
-			r = double(obj.read(3));
-			if nargin < 2
-				z = typecast(uint32(bitshift(bitand(r, 16776960), -8)),'uint16');
-				y = z(1);
-			else
-				w = bitand(bitshift(double(x), 8), 16776960) + bitand(r, 4278190335);
-				obj.write(3, uint32(w));
-			end
-		end
 		function y = ERROR(obj,x)
 			if nargin < 2
 				y = obj.read(4);
@@ -650,10 +669,550 @@ classdef fc_reg
 				obj.write(36, uint32(w));
 			end
 		end
+		function y = SCHED(obj,x)
+			if nargin < 2
+				y = obj.read(37);
+			else
+				obj.write(37, uint32(x));
+			end
+		end
+		function y = SCHED__MISSED(obj,x)
+			r = double(obj.read(37));
+			if nargin < 2
+				z = typecast(uint32(bitshift(bitand(r, 65535), 0)),'uint16');
+				y = z(1);
+			else
+				w = bitand(bitshift(double(x), 0), 65535) + bitand(r, 4294901760);
+				obj.write(37, uint32(w));
+			end
+		end
+		function y = SCHED__OVERRUN(obj,x)
+			r = double(obj.read(37));
+			if nargin < 2
+				z = typecast(uint32(bitshift(bitand(r, 4294901760), -16)),'uint16');
+				y = z(1);
+			else
+				w = bitand(bitshift(double(x), 16), 4294901760) + bitand(r, 65535);
+				obj.write(37, uint32(w));
+			end
+		end
+		function y = SENSOR_PERIOD(obj,x)
+			if nargin < 2
+				y = obj.read(38);
+			else
+				obj.write(38, uint32(x));
+			end
+		end
+		function y = SENSOR_PERIOD__MIN(obj,x)
+			r = double(obj.read(38));
+			if nargin < 2
+				z = typecast(uint32(bitshift(bitand(r, 65535), 0)),'uint16');
+				y = z(1);
+			else
+				w = bitand(bitshift(double(x), 0), 65535) + bitand(r, 4294901760);
+				obj.write(38, uint32(w));
+			end
+		end
+		function y = SENSOR_PERIOD__MAX(obj,x)
+			r = double(obj.read(38));
+			if nargin < 2
+				z = typecast(uint32(bitshift(bitand(r, 4294901760), -16)),'uint16');
+				y = z(1);
+			else
+				w = bitand(bitshift(double(x), 16), 4294901760) + bitand(r, 65535);
+				obj.write(38, uint32(w));
+			end
+		end
+		function y = PID(obj,x)
+			if nargin < 2
+				y = obj.read(39);
+			else
+				obj.write(39, uint32(x));
+			end
+		end
+		function y = PID__D_ON_MEASURE(obj,x)
+			r = double(obj.read(39));
+			if nargin < 2
+				z = typecast(uint32(bitshift(bitand(r, 1), 0)),'uint8');
+				y = z(1);
+			else
+				w = bitand(bitshift(double(x), 0), 1) + bitand(r, 4294967294);
+				obj.write(39, uint32(w));
+			end
+		end
+		function y = PID__FEEDFORWARD(obj,x)
+			r = double(obj.read(39));
+			if nargin < 2
+				z = typecast(uint32(bitshift(bitand(r, 2), -1)),'uint8');
+				y = z(1);
+			else
+				w = bitand(bitshift(double(x), 1), 2) + bitand(r, 4294967293);
+				obj.write(39, uint32(w));
+			end
+		end
+		function y = PID__ANTI_WINDUP(obj,x)
+			r = double(obj.read(39));
+			if nargin < 2
+				z = typecast(uint32(bitshift(bitand(r, 4), -2)),'uint8');
+				y = z(1);
+			else
+				w = bitand(bitshift(double(x), 2), 4) + bitand(r, 4294967291);
+				obj.write(39, uint32(w));
+			end
+		end
+		function y = PID__SETPOINT_WEIGHT(obj,x)
+			r = double(obj.read(39));
+			if nargin < 2
+				z = typecast(uint32(bitshift(bitand(r, 65280), -8)),'uint8');
+				y = z(1);
+			else
+				w = bitand(bitshift(double(x), 8), 65280) + bitand(r, 4294902015);
+				obj.write(39, uint32(w));
+			end
+		end
+		function y = PID__D_TIME_CONSTANT(obj,x)
+			r = double(obj.read(39));
+			if nargin < 2
+				z = typecast(uint32(bitshift(bitand(r, 4294901760), -16)),'uint16');
+				y = z(1);
+			else
+				w = bitand(bitshift(double(x), 16), 4294901760) + bitand(r, 65535);
+				obj.write(39, uint32(w));
+			end
+		end
+		function y = MIXER(obj,x)
+			if nargin < 2
+				y = obj.read(40);
+			else
+				obj.write(40, uint32(x));
+			end
+		end
+		function y = MIXER__AIRMODE(obj,x)
+			r = double(obj.read(40));
+			if nargin < 2
+				z = typecast(uint32(bitshift(bitand(r, 1), 0)),'uint8');
+				y = z(1);
+			else
+				w = bitand(bitshift(double(x), 0), 1) + bitand(r, 4294967294);
+				obj.write(40, uint32(w));
+			end
+		end
+		function y = MIXER__SERVO_CENTER(obj,x)
+			r = double(obj.read(40));
+			if nargin < 2
+				z = typecast(uint32(bitshift(bitand(r, 4294901760), -16)),'uint16');
+				y = z(1);
+			else
+				w = bitand(bitshift(double(x), 16), 4294901760) + bitand(r, 65535);
+				obj.write(40, uint32(w));
+			end
+		end
+		function y = GAIN_SCALE(obj,x)
+			if nargin < 2
+				y = obj.read(41);
+			else
+				obj.write(41, uint32(x));
+			end
+		end
+		function y = GAIN_SCALE__TPA_BREAKPOINT(obj,x)
+			r = double(obj.read(41));
+			if nargin < 2
+				z = typecast(uint32(bitshift(bitand(r, 255), 0)),'uint8');
+				y = z(1);
+			else
+				w = bitand(bitshift(double(x), 0), 255) + bitand(r, 4294967040);
+				obj.write(41, uint32(w));
+			end
+		end
+		function y = GAIN_SCALE__TPA_RATE(obj,x)
+			r = double(obj.read(41));
+			if nargin < 2
+				z = typecast(uint32(bitshift(bitand(r, 65280), -8)),'uint8');
+				y = z(1);
+			else
+				w = bitand(bitshift(double(x), 8), 65280) + bitand(r, 4294902015);
+				obj.write(41, uint32(w));
+			end
+		end
+		function y = GAIN_SCALE__VBAT_REF(obj,x)
+			r = double(obj.read(41));
+			if nargin < 2
+				z = typecast(uint32(bitshift(bitand(r, 4294901760), -16)),'uint16');
+				y = z(1);
+			else
+				w = bitand(bitshift(double(x), 16), 4294901760) + bitand(r, 65535);
+				obj.write(41, uint32(w));
+			end
+		end
+		function y = FF_PITCH(obj,x)
+			if nargin < 2
+				y = typecast(obj.read(42), 'single');
+			else
+				obj.write(42, typecast(single(x), 'uint32'));
+			end
+		end
+		function y = FF_ROLL(obj,x)
+			if nargin < 2
+				y = typecast(obj.read(43), 'single');
+			else
+				obj.write(43, typecast(single(x), 'uint32'));
+			end
+		end
+		function y = FF_YAW(obj,x)
+			if nargin < 2
+				y = typecast(obj.read(44), 'single');
+			else
+				obj.write(44, typecast(single(x), 'uint32'));
+			end
+		end
+		function y = GYRO_TC_X(obj,x)
+			if nargin < 2
+				y = typecast(obj.read(45), 'single');
+			else
+				obj.write(45, typecast(single(x), 'uint32'));
+			end
+		end
+		function y = GYRO_TC_Y(obj,x)
+			if nargin < 2
+				y = typecast(obj.read(46), 'single');
+			else
+				obj.write(46, typecast(single(x), 'uint32'));
+			end
+		end
+		function y = GYRO_TC_Z(obj,x)
+			if nargin < 2
+				y = typecast(obj.read(47), 'single');
+			else
+				obj.write(47, typecast(single(x), 'uint32'));
+			end
+		end
+		function y = GYRO_TC_TEMP(obj,x)
+			if nargin < 2
+				y = typecast(obj.read(48), 'single');
+			else
+				obj.write(48, typecast(single(x), 'uint32'));
+			end
+		end
+		function y = GYRO_TC(obj,x)
+			if nargin < 2
+				y = obj.read(49);
+			else
+				obj.write(49, uint32(x));
+			end
+		end
+		function y = GYRO_TC__LEARN(obj,x)
+			r = double(obj.read(49));
+			if nargin < 2
+				z = typecast(uint32(bitshift(bitand(r, 1), 0)),'uint8');
+				y = z(1);
+			else
+				w = bitand(bitshift(double(x), 0), 1) + bitand(r, 4294967294);
+				obj.write(49, uint32(w));
+			end
+		end
+		function y = GYRO_TC__TEMP_SPAN(obj,x)
+			r = double(obj.read(49));
+			if nargin < 2
+				z = typecast(uint32(bitshift(bitand(r, 65280), -8)),'uint8');
+				y = z(1);
+			else
+				w = bitand(bitshift(double(x), 8), 65280) + bitand(r, 4294902015);
+				obj.write(49, uint32(w));
+			end
+		end
+		function y = CAL(obj,x)
+			if nargin < 2
+				y = obj.read(50);
+			else
+				obj.write(50, uint32(x));
+			end
+		end
+		function y = CAL__SENSOR(obj,x)
+			r = double(obj.read(50));
+			if nargin < 2
+				z = typecast(uint32(bitshift(bitand(r, 255), 0)),'uint8');
+				y = z(1);
+			else
+				w = bitand(bitshift(double(x), 0), 255) + bitand(r, 4294967040);
+				obj.write(50, uint32(w));
+			end
+		end
+		function y = CAL__RADIO_IDLE(obj,x)
+			r = double(obj.read(50));
+			if nargin < 2
+				z = typecast(uint32(bitshift(bitand(r, 65280), -8)),'uint8');
+				y = z(1);
+			else
+				w = bitand(bitshift(double(x), 8), 65280) + bitand(r, 4294902015);
+				obj.write(50, uint32(w));
+			end
+		end
+		function y = CAL__RADIO_RANGE(obj,x)
+			r = double(obj.read(50));
+			if nargin < 2
+				z = typecast(uint32(bitshift(bitand(r, 16711680), -16)),'uint8');
+				y = z(1);
+			else
+				w = bitand(bitshift(double(x), 16), 16711680) + bitand(r, 4278255615);
+				obj.write(50, uint32(w));
+			end
+		end
+		function y = DEBUG_RATE(obj,x)
+			if nargin < 2
+				y = obj.read(51);
+			else
+				obj.write(51, uint32(x));
+			end
+		end
+		function y = DEBUG_RATE__SENSOR_RAW(obj,x)
+			r = double(obj.read(51));
+			if nargin < 2
+				z = typecast(uint32(bitshift(bitand(r, 15), 0)),'uint8');
+				y = z(1);
+			else
+				w = bitand(bitshift(double(x), 0), 15) + bitand(r, 4294967280);
+				obj.write(51, uint32(w));
+			end
+		end
+		function y = DEBUG_RATE__SENSOR(obj,x)
+			r = double(obj.read(51));
+			if nargin < 2
+				z = typecast(uint32(bitshift(bitand(r, 240), -4)),'uint8');
+				y = z(1);
+			else
+				w = bitand(bitshift(double(x), 4), 240) + bitand(r, 4294967055);
+				obj.write(51, uint32(w));
+			end
+		end
+		function y = DEBUG_RATE__ANGLE(obj,x)
+			r = double(obj.read(51));
+			if nargin < 2
+				z = typecast(uint32(bitshift(bitand(r, 3840), -8)),'uint8');
+				y = z(1);
+			else
+				w = bitand(bitshift(double(x), 8), 3840) + bitand(r, 4294963455);
+				obj.write(51, uint32(w));
+			end
+		end
+		function y = DEBUG_RATE__RADIO_RAW(obj,x)
+			r = double(obj.read(51));
+			if nargin < 2
+				z = typecast(uint32(bitshift(bitand(r, 61440), -12)),'uint8');
+				y = z(1);
+			else
+				w = bitand(bitshift(double(x), 12), 61440) + bitand(r, 4294905855);
+				obj.write(51, uint32(w));
+			end
+		end
+		function y = DEBUG_RATE__RADIO(obj,x)
+			r = double(obj.read(51));
+			if nargin < 2
+				z = typecast(uint32(bitshift(bitand(r, 983040), -16)),'uint8');
+				y = z(1);
+			else
+				w = bitand(bitshift(double(x), 16), 983040) + bitand(r, 4293984255);
+				obj.write(51, uint32(w));
+			end
+		end
+		function y = DEBUG_RATE__PID(obj,x)
+			r = double(obj.read(51));
+			if nargin < 2
+				z = typecast(uint32(bitshift(bitand(r, 15728640), -20)),'uint8');
+				y = z(1);
+			else
+				w = bitand(bitshift(double(x), 20), 15728640) + bitand(r, 4279238655);
+				obj.write(51, uint32(w));
+			end
+		end
+		function y = DEBUG_RATE__MOTOR(obj,x)
+			r = double(obj.read(51));
+			if nargin < 2
+				z = typecast(uint32(bitshift(bitand(r, 251658240), -24)),'uint8');
+				y = z(1);
+			else
+				w = bitand(bitshift(double(x), 24), 251658240) + bitand(r, 4043309055);
+				obj.write(51, uint32(w));
+			end
+		end
+		function y = DEBUG_RATE__VBAT(obj,x)
+			r = double(obj.read(51));
+			if nargin < 2
+				z = typecast(uint32(bitshift(bitand(r, 4026531840), -28)),'uint8');
+				y = z(1);
+			else
+				w = bitand(bitshift(double(x), 28), 4026531840) + bitand(r, 268435455);
+				obj.write(51, uint32(w));
+			end
+		end
+		function y = BLACKBOX(obj,x)
+			if nargin < 2
+				y = obj.read(52);
+			else
+				obj.write(52, uint32(x));
+			end
+		end
+		function y = BLACKBOX__ENABLE(obj,x)
+			r = double(obj.read(52));
+			if nargin < 2
+				z = typecast(uint32(bitshift(bitand(r, 1), 0)),'uint8');
+				y = z(1);
+			else
+				w = bitand(bitshift(double(x), 0), 1) + bitand(r, 4294967294);
+				obj.write(52, uint32(w));
+			end
+		end
+		function y = BLACKBOX__RATE(obj,x)
+			r = double(obj.read(52));
+			if nargin < 2
+				z = typecast(uint32(bitshift(bitand(r, 240), -4)),'uint8');
+				y = z(1);
+			else
+				w = bitand(bitshift(double(x), 4), 240) + bitand(r, 4294967055);
+				obj.write(52, uint32(w));
+			end
+		end
+		function y = BLACKBOX__ERASE(obj,x)
+			r = double(obj.read(52));
+			if nargin < 2
+				z = typecast(uint32(bitshift(bitand(r, 256), -8)),'uint8');
+				y = z(1);
+			else
+				w = bitand(bitshift(double(x), 8), 256) + bitand(r, 4294967039);
+				obj.write(52, uint32(w));
+			end
+		end
+		function y = BLACKBOX_STATUS(obj,x)
+			if nargin < 2
+				y = obj.read(53);
+			else
+				obj.write(53, uint32(x));
+			end
+		end
+		function y = BLACKBOX_STATUS__PAGES(obj,x)
+			r = double(obj.read(53));
+			if nargin < 2
+				z = typecast(uint32(bitshift(bitand(r, 65535), 0)),'uint16');
+				y = z(1);
+			else
+				w = bitand(bitshift(double(x), 0), 65535) + bitand(r, 4294901760);
+				obj.write(53, uint32(w));
+			end
+		end
+		function y = BLACKBOX_STATUS__DROPPED(obj,x)
+			r = double(obj.read(53));
+			if nargin < 2
+				z = typecast(uint32(bitshift(bitand(r, 4294901760), -16)),'uint16');
+				y = z(1);
+			else
+				w = bitand(bitshift(double(x), 16), 4294901760) + bitand(r, 65535);
+				obj.write(53, uint32(w));
+			end
+		end
+		function y = DEBUG_DELTA(obj,x)
+			if nargin < 2
+				y = obj.read(54);
+			else
+				obj.write(54, uint32(x));
+			end
+		end
+		function y = DEBUG_DELTA__ENABLE(obj,x)
+			r = double(obj.read(54));
+			if nargin < 2
+				z = typecast(uint32(bitshift(bitand(r, 1), 0)),'uint8');
+				y = z(1);
+			else
+				w = bitand(bitshift(double(x), 0), 1) + bitand(r, 4294967294);
+				obj.write(54, uint32(w));
+			end
+		end
+		function y = DEBUG_DELTA__KEYFRAME(obj,x)
+			r = double(obj.read(54));
+			if nargin < 2
+				z = typecast(uint32(bitshift(bitand(r, 112), -4)),'uint8');
+				y = z(1);
+			else
+				w = bitand(bitshift(double(x), 4), 112) + bitand(r, 4294967183);
+				obj.write(54, uint32(w));
+			end
+		end
+		function y = BENCH(obj,x)
+			if nargin < 2
+				y = obj.read(55);
+			else
+				obj.write(55, uint32(x));
+			end
+		end
+		function y = BENCH__RUN(obj,x)
+			r = double(obj.read(55));
+			if nargin < 2
+				z = typecast(uint32(bitshift(bitand(r, 1), 0)),'uint8');
+				y = z(1);
+			else
+				w = bitand(bitshift(double(x), 0), 1) + bitand(r, 4294967294);
+				obj.write(55, uint32(w));
+			end
+		end
+		function y = BENCH__ITEM(obj,x)
+			r = double(obj.read(55));
+			if nargin < 2
+				z = typecast(uint32(bitshift(bitand(r, 3840), -8)),'uint8');
+				y = z(1);
+			else
+				w = bitand(bitshift(double(x), 8), 3840) + bitand(r, 4294963455);
+				obj.write(55, uint32(w));
+			end
+		end
+		function y = BENCH_RESULT(obj,x)
+			if nargin < 2
+				y = typecast(obj.read(56), 'single');
+			else
+				obj.write(56, typecast(single(x), 'uint32'));
+			end
+		end
+		function y = LATENCY(obj,x)
+			if nargin < 2
+				y = obj.read(57);
+			else
+				obj.write(57, uint32(x));
+			end
+		end
+		function y = LATENCY__ENABLE(obj,x)
+			r = double(obj.read(57));
+			if nargin < 2
+				z = typecast(uint32(bitshift(bitand(r, 1), 0)),'uint8');
+				y = z(1);
+			else
+				w = bitand(bitshift(double(x), 0), 1) + bitand(r, 4294967294);
+				obj.write(57, uint32(w));
+			end
+		end
+		function y = LATENCY__RESET(obj,x)
+			r = double(obj.read(57));
+			if nargin < 2
+				z = typecast(uint32(bitshift(bitand(r, 2), -1)),'uint8');
+				y = z(1);
+			else
+				w = bitand(bitshift(double(x), 1), 2) + bitand(r, 4294967293);
+				obj.write(57, uint32(w));
+			end
+		end
+		function y = LATENCY__BIN(obj,x)
+			r = double(obj.read(57));
+			if nargin < 2
+				z = typecast(uint32(bitshift(bitand(r, 240), -4)),'uint8');
+				y = z(1);
+			else
+				w = bitand(bitshift(double(x), 4), 240) + bitand(r, 4294967055);
+				obj.write(57, uint32(w));
+			end
+		end
 	end
 	properties
 		method = 0;
 		target = 0;
+		cache = [];
+		nb_reg = 58;
+		block_max = 14; % REG_BLOCK_MAX
 		info = struct(...
 			'VERSION', [0,1,0,0],...
 			'CTRL', [1,0,0,1],...
@@ -667,9 +1226,7 @@ classdef fc_reg
 			'MOTOR_TEST', [2,0,0,1],...
 			'MOTOR_TEST__VALUE', [2,0,0,2],...
 			'MOTOR_TEST__SELECT', [2,0,0,2],...
-			'DEBUG', [3,0,0,1],...
-			'DEBUG__CASE', [3,0,0,2],...
-			'DEBUG__MASK', [3,0,0,2],...
+			'DEBUG', [3,0,0,0],...
 			'ERROR', [4,0,0,1],...
 			'ERROR__SENSOR', [4,0,0,2],...
 			'ERROR__RADIO', [4,0,0,2],...
@@ -728,6 +1285,66 @@ classdef fc_reg
 			'ELEVATOR__RANGE', [35,1,0,2],...
 			'RUDDER', [36,1,0,1],...
 			'RUDDER__IDLE', [36,1,0,2],...
-			'RUDDER__RANGE', [36,1,0,2] );
+			'RUDDER__RANGE', [36,1,0,2],...
+			'SCHED', [37,0,0,1],...
+			'SCHED__MISSED', [37,0,0,2],...
+			'SCHED__OVERRUN', [37,0,0,2],...
+			'SENSOR_PERIOD', [38,0,0,1],...
+			'SENSOR_PERIOD__MIN', [38,0,0,2],...
+			'SENSOR_PERIOD__MAX', [38,0,0,2],...
+			'PID', [39,1,0,1],...
+			'PID__D_ON_MEASURE', [39,1,0,2],...
+			'PID__FEEDFORWARD', [39,1,0,2],...
+			'PID__ANTI_WINDUP', [39,1,0,2],...
+			'PID__SETPOINT_WEIGHT', [39,1,0,2],...
+			'PID__D_TIME_CONSTANT', [39,1,0,2],...
+			'MIXER', [40,1,0,1],...
+			'MIXER__AIRMODE', [40,1,0,2],...
+			'MIXER__SERVO_CENTER', [40,1,0,2],...
+			'GAIN_SCALE', [41,1,0,1],...
+			'GAIN_SCALE__TPA_BREAKPOINT', [41,1,0,2],...
+			'GAIN_SCALE__TPA_RATE', [41,1,0,2],...
+			'GAIN_SCALE__VBAT_REF', [41,1,0,2],...
+			'FF_PITCH', [42,1,1,0],...
+			'FF_ROLL', [43,1,1,0],...
+			'FF_YAW', [44,1,1,0],...
+			'GYRO_TC_X', [45,1,1,0],...
+			'GYRO_TC_Y', [46,1,1,0],...
+			'GYRO_TC_Z', [47,1,1,0],...
+			'GYRO_TC_TEMP', [48,1,1,0],...
+			'GYRO_TC', [49,1,0,1],...
+			'GYRO_TC__LEARN', [49,1,0,2],...
+			'GYRO_TC__TEMP_SPAN', [49,1,0,2],...
+			'CAL', [50,0,0,1],...
+			'CAL__SENSOR', [50,0,0,2],...
+			'CAL__RADIO_IDLE', [50,0,0,2],...
+			'CAL__RADIO_RANGE', [50,0,0,2],...
+			'DEBUG_RATE', [51,0,0,1],...
+			'DEBUG_RATE__SENSOR_RAW', [51,0,0,2],...
+			'DEBUG_RATE__SENSOR', [51,0,0,2],...
+			'DEBUG_RATE__ANGLE', [51,0,0,2],...
+			'DEBUG_RATE__RADIO_RAW', [51,0,0,2],...
+			'DEBUG_RATE__RADIO', [51,0,0,2],...
+			'DEBUG_RATE__PID', [51,0,0,2],...
+			'DEBUG_RATE__MOTOR', [51,0,0,2],...
+			'DEBUG_RATE__VBAT', [51,0,0,2],...
+			'BLACKBOX', [52,1,0,1],...
+			'BLACKBOX__ENABLE', [52,1,0,2],...
+			'BLACKBOX__RATE', [52,1,0,2],...
+			'BLACKBOX__ERASE', [52,1,0,2],...
+			'BLACKBOX_STATUS', [53,0,0,1],...
+			'BLACKBOX_STATUS__PAGES', [53,0,0,2],...
+			'BLACKBOX_STATUS__DROPPED', [53,0,0,2],...
+			'DEBUG_DELTA', [54,0,0,1],...
+			'DEBUG_DELTA__ENABLE', [54,0,0,2],...
+			'DEBUG_DELTA__KEYFRAME', [54,0,0,2],...
+			'BENCH', [55,0,0,1],...
+			'BENCH__RUN', [55,0,0,2],...
+			'BENCH__ITEM', [55,0,0,2],...
+			'BENCH_RESULT', [56,0,1,0],...
+			'LATENCY', [57,0,0,1],...
+			'LATENCY__ENABLE', [57,0,0,2],...
+			'LATENCY__RESET', [57,0,0,2],...
+			'LATENCY__BIN', [57,0,0,2] );
 	end
 end
@@ -10,15 +10,15 @@ fprintf(f,'#define NB_REG %d\n\n', length(reg));
 for n = 1:length(reg)
 	if length(reg(n).subf) == 1
 		if strcmp(reg(n).subf{1}{4}, 'single')
-			fprintf(f,'#define REG_%s regf[%d]\n', reg(n).subf{1}{1}, n-1);
+			fprintf(f,'#define REG_%s reg[%d].f\n', reg(n).subf{1}{1}, n-1);
 		else
-			fprintf(f,'#define REG_%s reg[%d]\n', reg(n).subf{1}{1}, n-1);
+			fprintf(f,'#define REG_%s reg[%d].u\n', reg(n).subf{1}{1}, n-1);
 		end
 	else
-		fprintf(f,'#define REG_%s reg[%d]\n', reg(n).name, n-1);
+		fprintf(f,'#define REG_%s reg[%d].u\n', reg(n).name, n-1);
 		for m = 1:length(reg(n).subf)
 			mask = sum(2.^(reg(n).subf{m}{3}:reg(n).subf{m}{2}));
-			fprintf(f,'#define REG_%s__%s (%s_t)((reg[%d] & %dU) >> %d)\n', reg(n).name, reg(n).subf{m}{1}, reg(n).subf{m}{4}, n-1, mask, reg(n).subf{m}{3});
+			fprintf(f,'#define REG_%s__%s (%s_t)((reg[%d].u & %dU) >> %d)\n', reg(n).name, reg(n).subf{m}{1}, reg(n).subf{m}{4}, n-1, mask, reg(n).subf{m}{3});
          fprintf(f,'#define REG_%s__%s_Msk %dU\n', reg(n).name, reg(n).subf{m}{1}, mask);
          fprintf(f,'#define REG_%s__%s_Pos %dU\n', reg(n).name, reg(n).subf{m}{1}, reg(n).subf{m}{3});
 		end
@@ -29,7 +29,7 @@ fclose(f);
 
 f = fopen('reg.c','w');
 
-fprintf(f,'reg_properties_t reg_properties[NB_REG] = \n{\n');
+fprintf(f,'const reg_properties_t reg_properties[NB_REG] = \n{\n');
 
 % bools = {'false','true'};
 bools = {'0','1'};
@@ -59,6 +59,7 @@ for n = 1:length(reg)
          end
 		end
 	end
+	dflt(n) = default;
 	if n < length(reg)
 		fprintf(f,'\t{%s, %s, %s, %d}, // %s\n', bools{reg(n).read_only+1}, bools{reg(n).flash+1}, bools{float+1}, default, reg(n).name);
 	else
@@ -76,7 +77,9 @@ fprintf(f,'classdef fc_reg\n');
 fprintf(f,'\tmethods\n');
 fprintf(f,'\t\tfunction data = read(obj,addr)\n');
 fprintf(f,'\t\t\tglobal ser\n');
-fprintf(f,'\t\t\tif obj.method\n');
+fprintf(f,'\t\t\tif ~isempty(obj.cache)\n');
+fprintf(f,'\t\t\t\tdata = obj.cache(addr+1);\n');
+fprintf(f,'\t\t\telseif obj.method\n');
 fprintf(f,'\t\t\t\tr = sx1272_receive(0);\n');
 fprintf(f,'\t\t\t\tsx1272_send([0,addr,0,0,0,0],1);\n');
 fprintf(f,'\t\t\t\tsleep(300);\n');
@@ -95,6 +98,43 @@ fprintf(f,'\t\t\telse\n');
 fprintf(f,'\t\t\t\tfwrite(ser,[obj.target*4+1,addr,floor(mod(double(data) ./ 2.^(0:8:24),2^8))]);\n');
 fprintf(f,'\t\t\tend\n');
 fprintf(f,'\t\tend\n');
+fprintf(f,'\t\tfunction data = read_block(obj,addr,count)\n');
+fprintf(f,'\t\t\tglobal ser\n');
+fprintf(f,'\t\t\tdata = zeros(1,count,''uint32'');\n');
+fprintf(f,'\t\t\tfor k = 0:obj.block_max:count-1\n');
+fprintf(f,'\t\t\t\tn = min(obj.block_max, count-k);\n');
+fprintf(f,'\t\t\t\tif obj.method\n');
+fprintf(f,'\t\t\t\t\tfor m = 1:n\n');
+fprintf(f,'\t\t\t\t\t\tdata(k+m) = obj.read(addr+k+m-1);\n');
+fprintf(f,'\t\t\t\t\tend\n');
+fprintf(f,'\t\t\t\telse\n');
+fprintf(f,'\t\t\t\t\tfwrite(ser,[obj.target*4+9,addr+k,n,0,0,0]);\n');
+fprintf(f,'\t\t\t\t\tr = fread(ser,4*n+2)'';\n');
+fprintf(f,'\t\t\t\t\tif length(r) ~= 4*n+2 || crc16(r(1:4*n)) ~= r(4*n+1) + 256*r(4*n+2)\n');
+fprintf(f,'\t\t\t\t\t\terror(''fc_reg: block read failed at address %%d'', addr+k);\n');
+fprintf(f,'\t\t\t\t\tend\n');
+fprintf(f,'\t\t\t\t\tdata(k+1:k+n) = uint32(sum(reshape(r(1:4*n),4,n) .* 2.^(0:8:24)'', 1));\n');
+fprintf(f,'\t\t\t\tend\n');
+fprintf(f,'\t\t\tend\n');
+fprintf(f,'\t\tend\n');
+fprintf(f,'\t\tfunction write_block(obj,addr,data)\n');
+fprintf(f,'\t\t\tglobal ser\n');
+fprintf(f,'\t\t\tfor k = 0:obj.block_max:length(data)-1\n');
+fprintf(f,'\t\t\t\td = double(data(k+1:min(k+obj.block_max,end)));\n');
+fprintf(f,'\t\t\t\tif obj.method\n');
+fprintf(f,'\t\t\t\t\tfor m = 1:length(d)\n');
+fprintf(f,'\t\t\t\t\t\tobj.write(addr+k+m-1, d(m));\n');
+fprintf(f,'\t\t\t\t\tend\n');
+fprintf(f,'\t\t\t\telse\n');
+fprintf(f,'\t\t\t\t\tb = reshape(floor(mod(d ./ 2.^(0:8:24)'',2^8)), 1, []);\n');
+fprintf(f,'\t\t\t\t\tc = crc16(b);\n');
+fprintf(f,'\t\t\t\t\tfwrite(ser,[obj.target*4+10,addr+k,length(d),0,mod(c,256),floor(c/256),b]);\n');
+fprintf(f,'\t\t\t\t\tif fread(ser,1) ~= 0\n');
+fprintf(f,'\t\t\t\t\t\terror(''fc_reg: block write rejected at address %%d'', addr+k);\n');
+fprintf(f,'\t\t\t\t\tend\n');
+fprintf(f,'\t\t\t\tend\n');
+fprintf(f,'\t\t\tend\n');
+fprintf(f,'\t\tend\n');
 
 for n = 1:length(reg)
 	
@@ -153,6 +193,9 @@ fprintf(f,'\tend\n');
 fprintf(f,'\tproperties\n');
 fprintf(f,'\t\tmethod = 0;\n');
 fprintf(f,'\t\ttarget = 0;\n');
+fprintf(f,'\t\tcache = [];\n');
+fprintf(f,'\t\tnb_reg = %d;\n', length(reg));
+fprintf(f,'\t\tblock_max = 14; %% REG_BLOCK_MAX\n');
 
 fprintf(f,'\t\tinfo = struct(...\n');
 for n = 1:length(reg)
@@ -170,4 +213,21 @@ fprintf(f,' );\n');
 fprintf(f,'\tend\n');
 fprintf(f,'end\n');
 
+fclose(f);
+
+%% generate C++ register map (host/libfc)
+
+f = fopen('reg_map.inc','w');
+
+for n = 1:length(reg)
+	fprintf(f,'\t{"%s", %d, %d, %d, %dU, {', reg(n).name, n-1, reg(n).read_only, reg(n).flash, dflt(n));
+	for m = 1:length(reg(n).subf)
+		if m > 1
+			fprintf(f,', ');
+		end
+		fprintf(f,'{"%s", %d, %d, field_type::%s}', reg(n).subf{m}{1}, reg(n).subf{m}{2}, reg(n).subf{m}{3}, reg(n).subf{m}{4});
+	end
+	fprintf(f,'}},\n');
+end
+
 fclose(f);
\ No newline at end of file
@@ -1,9 +1,9 @@
-reg_properties_t reg_properties[NB_REG] = 
+const reg_properties_t reg_properties[NB_REG] = 
 {
 	{1, 1, 0, 0}, // VERSION
 	{0, 0, 0, 0}, // CTRL
 	{0, 0, 0, 0}, // MOTOR_TEST
-	{0, 0, 0, 32512}, // DEBUG
+	{0, 0, 0, 0}, // DEBUG
 	{1, 0, 0, 0}, // ERROR
 	{1, 0, 0, 0}, // TIME
 	{1, 0, 1, 0}, // VBAT
@@ -36,5 +36,26 @@ reg_properties_t reg_properties[NB_REG] =
 	{1, 1, 0, 0}, // THROTTLE
 	{1, 1, 0, 0}, // AILERON
 	{1, 1, 0, 0}, // ELEVATOR
-	{1, 1, 0, 0} // RUDDER
+	{1, 1, 0, 0}, // RUDDER
+	{1, 0, 0, 0}, // SCHED
+	{1, 0, 0, 0}, // SENSOR_PERIOD
+	{0, 1, 0, 25606}, // PID
+	{0, 1, 0, 65536000}, // MIXER
+	{0, 1, 0, 100}, // GAIN_SCALE
+	{0, 1, 1, 0}, // FF_PITCH
+	{0, 1, 1, 0}, // FF_ROLL
+	{0, 1, 1, 0}, // FF_YAW
+	{0, 1, 1, 0}, // GYRO_TC_X
+	{0, 1, 1, 0}, // GYRO_TC_Y
+	{0, 1, 1, 0}, // GYRO_TC_Z
+	{1, 1, 1, 1103626240}, // GYRO_TC_TEMP
+	{0, 1, 0, 5120}, // GYRO_TC
+	{1, 0, 0, 0}, // CAL
+	{0, 0, 0, 626140501}, // DEBUG_RATE
+	{0, 1, 0, 1}, // BLACKBOX
+	{1, 0, 0, 0}, // BLACKBOX_STATUS
+	{0, 0, 0, 65}, // DEBUG_DELTA
+	{0, 0, 0, 0}, // BENCH
+	{1, 0, 1, 0}, // BENCH_RESULT
+	{0, 0, 0, 48} // LATENCY
 };
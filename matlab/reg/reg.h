@@ -1,150 +1,282 @@
-#define NB_REG 37
+#define NB_REG 58
 
-#define REG_VERSION reg[0]
-#define REG_CTRL reg[1]
-#define REG_CTRL__SENSOR_HOST_CTRL (uint8_t)((reg[1] & 1U) >> 0)
+#define REG_VERSION reg[0].u
+#define REG_CTRL reg[1].u
+#define REG_CTRL__SENSOR_HOST_CTRL (uint8_t)((reg[1].u & 1U) >> 0)
 #define REG_CTRL__SENSOR_HOST_CTRL_Msk 1U
 #define REG_CTRL__SENSOR_HOST_CTRL_Pos 0U
-#define REG_CTRL__ARM_TEST (uint8_t)((reg[1] & 6U) >> 1)
+#define REG_CTRL__ARM_TEST (uint8_t)((reg[1].u & 6U) >> 1)
 #define REG_CTRL__ARM_TEST_Msk 6U
 #define REG_CTRL__ARM_TEST_Pos 1U
-#define REG_CTRL__BEEP_TEST (uint8_t)((reg[1] & 8U) >> 3)
+#define REG_CTRL__BEEP_TEST (uint8_t)((reg[1].u & 8U) >> 3)
 #define REG_CTRL__BEEP_TEST_Msk 8U
 #define REG_CTRL__BEEP_TEST_Pos 3U
-#define REG_CTRL__TIME_MAXHOLD (uint8_t)((reg[1] & 16U) >> 4)
+#define REG_CTRL__TIME_MAXHOLD (uint8_t)((reg[1].u & 16U) >> 4)
 #define REG_CTRL__TIME_MAXHOLD_Msk 16U
 #define REG_CTRL__TIME_MAXHOLD_Pos 4U
-#define REG_CTRL__SENSOR_CAL (uint8_t)((reg[1] & 32U) >> 5)
+#define REG_CTRL__SENSOR_CAL (uint8_t)((reg[1].u & 32U) >> 5)
 #define REG_CTRL__SENSOR_CAL_Msk 32U
 #define REG_CTRL__SENSOR_CAL_Pos 5U
-#define REG_CTRL__RADIO_CAL_IDLE (uint8_t)((reg[1] & 64U) >> 6)
+#define REG_CTRL__RADIO_CAL_IDLE (uint8_t)((reg[1].u & 64U) >> 6)
 #define REG_CTRL__RADIO_CAL_IDLE_Msk 64U
 #define REG_CTRL__RADIO_CAL_IDLE_Pos 6U
-#define REG_CTRL__RADIO_CAL_RANGE (uint8_t)((reg[1] & 128U) >> 7)
+#define REG_CTRL__RADIO_CAL_RANGE (uint8_t)((reg[1].u & 128U) >> 7)
 #define REG_CTRL__RADIO_CAL_RANGE_Msk 128U
 #define REG_CTRL__RADIO_CAL_RANGE_Pos 7U
-#define REG_MOTOR_TEST reg[2]
-#define REG_MOTOR_TEST__VALUE (uint16_t)((reg[2] & 65535U) >> 0)
+#define REG_MOTOR_TEST reg[2].u
+#define REG_MOTOR_TEST__VALUE (uint16_t)((reg[2].u & 65535U) >> 0)
 #define REG_MOTOR_TEST__VALUE_Msk 65535U
 #define REG_MOTOR_TEST__VALUE_Pos 0U
-#define REG_MOTOR_TEST__SELECT (uint8_t)((reg[2] & 983040U) >> 16)
+#define REG_MOTOR_TEST__SELECT (uint8_t)((reg[2].u & 983040U) >> 16)
 #define REG_MOTOR_TEST__SELECT_Msk 983040U
 #define REG_MOTOR_TEST__SELECT_Pos 16U
-#define REG_DEBUG reg[3]
-#define REG_DEBUG__CASE (uint8_t)((reg[3] & 255U) >> 0)
-#define REG_DEBUG__CASE_Msk 255U
-#define REG_DEBUG__CASE_Pos 0U
-#define REG_DEBUG__MASK (uint16_t)((reg[3] & 16776960U) >> 8)
-#define REG_DEBUG__MASK_Msk 16776960U
-#define REG_DEBUG__MASK_Pos 8U
-#define REG_ERROR reg[4]
-#define REG_ERROR__SENSOR (uint8_t)((reg[4] & 255U) >> 0)
+#define REG_DEBUG reg[3].u
+#define REG_ERROR reg[4].u
+#define REG_ERROR__SENSOR (uint8_t)((reg[4].u & 255U) >> 0)
 #define REG_ERROR__SENSOR_Msk 255U
 #define REG_ERROR__SENSOR_Pos 0U
-#define REG_ERROR__RADIO (uint8_t)((reg[4] & 65280U) >> 8)
+#define REG_ERROR__RADIO (uint8_t)((reg[4].u & 65280U) >> 8)
 #define REG_ERROR__RADIO_Msk 65280U
 #define REG_ERROR__RADIO_Pos 8U
-#define REG_ERROR__RF (uint8_t)((reg[4] & 16711680U) >> 16)
+#define REG_ERROR__RF (uint8_t)((reg[4].u & 16711680U) >> 16)
 #define REG_ERROR__RF_Msk 16711680U
 #define REG_ERROR__RF_Pos 16U
-#define REG_ERROR__CRC (uint8_t)((reg[4] & 4278190080U) >> 24)
+#define REG_ERROR__CRC (uint8_t)((reg[4].u & 4278190080U) >> 24)
 #define REG_ERROR__CRC_Msk 4278190080U
 #define REG_ERROR__CRC_Pos 24U
-#define REG_TIME reg[5]
-#define REG_TIME__SENSOR (uint16_t)((reg[5] & 65535U) >> 0)
+#define REG_TIME reg[5].u
+#define REG_TIME__SENSOR (uint16_t)((reg[5].u & 65535U) >> 0)
 #define REG_TIME__SENSOR_Msk 65535U
 #define REG_TIME__SENSOR_Pos 0U
-#define REG_TIME__PROCESSING (uint16_t)((reg[5] & 4294901760U) >> 16)
+#define REG_TIME__PROCESSING (uint16_t)((reg[5].u & 4294901760U) >> 16)
 #define REG_TIME__PROCESSING_Msk 4294901760U
 #define REG_TIME__PROCESSING_Pos 16U
-#define REG_VBAT regf[6]
-#define REG_VBAT_MIN regf[7]
-#define REG_TIME_CONSTANT reg[8]
-#define REG_TIME_CONSTANT__ACCEL (uint16_t)((reg[8] & 65535U) >> 0)
+#define REG_VBAT reg[6].f
+#define REG_VBAT_MIN reg[7].f
+#define REG_TIME_CONSTANT reg[8].u
+#define REG_TIME_CONSTANT__ACCEL (uint16_t)((reg[8].u & 65535U) >> 0)
 #define REG_TIME_CONSTANT__ACCEL_Msk 65535U
 #define REG_TIME_CONSTANT__ACCEL_Pos 0U
-#define REG_TIME_CONSTANT__VBAT (uint16_t)((reg[8] & 4294901760U) >> 16)
+#define REG_TIME_CONSTANT__VBAT (uint16_t)((reg[8].u & 4294901760U) >> 16)
 #define REG_TIME_CONSTANT__VBAT_Msk 4294901760U
 #define REG_TIME_CONSTANT__VBAT_Pos 16U
-#define REG_TIME_CONSTANT_RADIO reg[9]
-#define REG_EXPO_PITCH_ROLL regf[10]
-#define REG_EXPO_YAW regf[11]
-#define REG_MOTOR reg[12]
-#define REG_MOTOR__START (uint16_t)((reg[12] & 1023U) >> 0)
+#define REG_TIME_CONSTANT_RADIO reg[9].u
+#define REG_EXPO_PITCH_ROLL reg[10].f
+#define REG_EXPO_YAW reg[11].f
+#define REG_MOTOR reg[12].u
+#define REG_MOTOR__START (uint16_t)((reg[12].u & 1023U) >> 0)
 #define REG_MOTOR__START_Msk 1023U
 #define REG_MOTOR__START_Pos 0U
-#define REG_MOTOR__ARMED (uint16_t)((reg[12] & 1047552U) >> 10)
+#define REG_MOTOR__ARMED (uint16_t)((reg[12].u & 1047552U) >> 10)
 #define REG_MOTOR__ARMED_Msk 1047552U
 #define REG_MOTOR__ARMED_Pos 10U
-#define REG_MOTOR__RANGE (uint16_t)((reg[12] & 4293918720U) >> 20)
+#define REG_MOTOR__RANGE (uint16_t)((reg[12].u & 4293918720U) >> 20)
 #define REG_MOTOR__RANGE_Msk 4293918720U
 #define REG_MOTOR__RANGE_Pos 20U
-#define REG_RATE reg[13]
-#define REG_RATE__PITCH_ROLL (uint16_t)((reg[13] & 4095U) >> 0)
+#define REG_RATE reg[13].u
+#define REG_RATE__PITCH_ROLL (uint16_t)((reg[13].u & 4095U) >> 0)
 #define REG_RATE__PITCH_ROLL_Msk 4095U
 #define REG_RATE__PITCH_ROLL_Pos 0U
-#define REG_RATE__YAW (uint16_t)((reg[13] & 16773120U) >> 12)
+#define REG_RATE__YAW (uint16_t)((reg[13].u & 16773120U) >> 12)
 #define REG_RATE__YAW_Msk 16773120U
 #define REG_RATE__YAW_Pos 12U
-#define REG_RATE__ANGLE (uint8_t)((reg[13] & 4278190080U) >> 24)
+#define REG_RATE__ANGLE (uint8_t)((reg[13].u & 4278190080U) >> 24)
 #define REG_RATE__ANGLE_Msk 4278190080U
 #define REG_RATE__ANGLE_Pos 24U
-#define REG_P_PITCH regf[14]
-#define REG_I_PITCH regf[15]
-#define REG_D_PITCH regf[16]
-#define REG_P_ROLL regf[17]
-#define REG_I_ROLL regf[18]
-#define REG_D_ROLL regf[19]
-#define REG_P_YAW regf[20]
-#define REG_I_YAW regf[21]
-#define REG_D_YAW regf[22]
-#define REG_P_PITCH_ANGLE regf[23]
-#define REG_I_PITCH_ANGLE regf[24]
-#define REG_D_PITCH_ANGLE regf[25]
-#define REG_P_ROLL_ANGLE regf[26]
-#define REG_I_ROLL_ANGLE regf[27]
-#define REG_D_ROLL_ANGLE regf[28]
-#define REG_GYRO_DC_XY reg[29]
-#define REG_GYRO_DC_XY__X (int16_t)((reg[29] & 65535U) >> 0)
+#define REG_P_PITCH reg[14].f
+#define REG_I_PITCH reg[15].f
+#define REG_D_PITCH reg[16].f
+#define REG_P_ROLL reg[17].f
+#define REG_I_ROLL reg[18].f
+#define REG_D_ROLL reg[19].f
+#define REG_P_YAW reg[20].f
+#define REG_I_YAW reg[21].f
+#define REG_D_YAW reg[22].f
+#define REG_P_PITCH_ANGLE reg[23].f
+#define REG_I_PITCH_ANGLE reg[24].f
+#define REG_D_PITCH_ANGLE reg[25].f
+#define REG_P_ROLL_ANGLE reg[26].f
+#define REG_I_ROLL_ANGLE reg[27].f
+#define REG_D_ROLL_ANGLE reg[28].f
+#define REG_GYRO_DC_XY reg[29].u
+#define REG_GYRO_DC_XY__X (int16_t)((reg[29].u & 65535U) >> 0)
 #define REG_GYRO_DC_XY__X_Msk 65535U
 #define REG_GYRO_DC_XY__X_Pos 0U
-#define REG_GYRO_DC_XY__Y (int16_t)((reg[29] & 4294901760U) >> 16)
+#define REG_GYRO_DC_XY__Y (int16_t)((reg[29].u & 4294901760U) >> 16)
 #define REG_GYRO_DC_XY__Y_Msk 4294901760U
 #define REG_GYRO_DC_XY__Y_Pos 16U
-#define REG_GYRO_DC_Z reg[30]
-#define REG_ACCEL_DC_XY reg[31]
-#define REG_ACCEL_DC_XY__X (int16_t)((reg[31] & 65535U) >> 0)
+#define REG_GYRO_DC_Z reg[30].u
+#define REG_ACCEL_DC_XY reg[31].u
+#define REG_ACCEL_DC_XY__X (int16_t)((reg[31].u & 65535U) >> 0)
 #define REG_ACCEL_DC_XY__X_Msk 65535U
 #define REG_ACCEL_DC_XY__X_Pos 0U
-#define REG_ACCEL_DC_XY__Y (int16_t)((reg[31] & 4294901760U) >> 16)
+#define REG_ACCEL_DC_XY__Y (int16_t)((reg[31].u & 4294901760U) >> 16)
 #define REG_ACCEL_DC_XY__Y_Msk 4294901760U
 #define REG_ACCEL_DC_XY__Y_Pos 16U
-#define REG_ACCEL_DC_Z reg[32]
-#define REG_THROTTLE reg[33]
-#define REG_THROTTLE__IDLE (uint16_t)((reg[33] & 65535U) >> 0)
+#define REG_ACCEL_DC_Z reg[32].u
+#define REG_THROTTLE reg[33].u
+#define REG_THROTTLE__IDLE (uint16_t)((reg[33].u & 65535U) >> 0)
 #define REG_THROTTLE__IDLE_Msk 65535U
 #define REG_THROTTLE__IDLE_Pos 0U
-#define REG_THROTTLE__RANGE (uint16_t)((reg[33] & 4294901760U) >> 16)
+#define REG_THROTTLE__RANGE (uint16_t)((reg[33].u & 4294901760U) >> 16)
 #define REG_THROTTLE__RANGE_Msk 4294901760U
 #define REG_THROTTLE__RANGE_Pos 16U
-#define REG_AILERON reg[34]
-#define REG_AILERON__IDLE (uint16_t)((reg[34] & 65535U) >> 0)
+#define REG_AILERON reg[34].u
+#define REG_AILERON__IDLE (uint16_t)((reg[34].u & 65535U) >> 0)
 #define REG_AILERON__IDLE_Msk 65535U
 #define REG_AILERON__IDLE_Pos 0U
-#define REG_AILERON__RANGE (uint16_t)((reg[34] & 4294901760U) >> 16)
+#define REG_AILERON__RANGE (uint16_t)((reg[34].u & 4294901760U) >> 16)
 #define REG_AILERON__RANGE_Msk 4294901760U
 #define REG_AILERON__RANGE_Pos 16U
-#define REG_ELEVATOR reg[35]
-#define REG_ELEVATOR__IDLE (uint16_t)((reg[35] & 65535U) >> 0)
+#define REG_ELEVATOR reg[35].u
+#define REG_ELEVATOR__IDLE (uint16_t)((reg[35].u & 65535U) >> 0)
 #define REG_ELEVATOR__IDLE_Msk 65535U
 #define REG_ELEVATOR__IDLE_Pos 0U
-#define REG_ELEVATOR__RANGE (uint16_t)((reg[35] & 4294901760U) >> 16)
+#define REG_ELEVATOR__RANGE (uint16_t)((reg[35].u & 4294901760U) >> 16)
 #define REG_ELEVATOR__RANGE_Msk 4294901760U
 #define REG_ELEVATOR__RANGE_Pos 16U
-#define REG_RUDDER reg[36]
-#define REG_RUDDER__IDLE (uint16_t)((reg[36] & 65535U) >> 0)
+#define REG_RUDDER reg[36].u
+#define REG_RUDDER__IDLE (uint16_t)((reg[36].u & 65535U) >> 0)
 #define REG_RUDDER__IDLE_Msk 65535U
 #define REG_RUDDER__IDLE_Pos 0U
-#define REG_RUDDER__RANGE (uint16_t)((reg[36] & 4294901760U) >> 16)
+#define REG_RUDDER__RANGE (uint16_t)((reg[36].u & 4294901760U) >> 16)
 #define REG_RUDDER__RANGE_Msk 4294901760U
 #define REG_RUDDER__RANGE_Pos 16U
+#define REG_SCHED reg[37].u
+#define REG_SCHED__MISSED (uint16_t)((reg[37].u & 65535U) >> 0)
+#define REG_SCHED__MISSED_Msk 65535U
+#define REG_SCHED__MISSED_Pos 0U
+#define REG_SCHED__OVERRUN (uint16_t)((reg[37].u & 4294901760U) >> 16)
+#define REG_SCHED__OVERRUN_Msk 4294901760U
+#define REG_SCHED__OVERRUN_Pos 16U
+#define REG_SENSOR_PERIOD reg[38].u
+#define REG_SENSOR_PERIOD__MIN (uint16_t)((reg[38].u & 65535U) >> 0)
+#define REG_SENSOR_PERIOD__MIN_Msk 65535U
+#define REG_SENSOR_PERIOD__MIN_Pos 0U
+#define REG_SENSOR_PERIOD__MAX (uint16_t)((reg[38].u & 4294901760U) >> 16)
+#define REG_SENSOR_PERIOD__MAX_Msk 4294901760U
+#define REG_SENSOR_PERIOD__MAX_Pos 16U
+#define REG_PID reg[39].u
+#define REG_PID__D_ON_MEASURE (uint8_t)((reg[39].u & 1U) >> 0)
+#define REG_PID__D_ON_MEASURE_Msk 1U
+#define REG_PID__D_ON_MEASURE_Pos 0U
+#define REG_PID__FEEDFORWARD (uint8_t)((reg[39].u & 2U) >> 1)
+#define REG_PID__FEEDFORWARD_Msk 2U
+#define REG_PID__FEEDFORWARD_Pos 1U
+#define REG_PID__ANTI_WINDUP (uint8_t)((reg[39].u & 4U) >> 2)
+#define REG_PID__ANTI_WINDUP_Msk 4U
+#define REG_PID__ANTI_WINDUP_Pos 2U
+#define REG_PID__SETPOINT_WEIGHT (uint8_t)((reg[39].u & 65280U) >> 8)
+#define REG_PID__SETPOINT_WEIGHT_Msk 65280U
+#define REG_PID__SETPOINT_WEIGHT_Pos 8U
+#define REG_PID__D_TIME_CONSTANT (uint16_t)((reg[39].u & 4294901760U) >> 16)
+#define REG_PID__D_TIME_CONSTANT_Msk 4294901760U
+#define REG_PID__D_TIME_CONSTANT_Pos 16U
+#define REG_MIXER reg[40].u
+#define REG_MIXER__AIRMODE (uint8_t)((reg[40].u & 1U) >> 0)
+#define REG_MIXER__AIRMODE_Msk 1U
+#define REG_MIXER__AIRMODE_Pos 0U
+#define REG_MIXER__SERVO_CENTER (uint16_t)((reg[40].u & 4294901760U) >> 16)
+#define REG_MIXER__SERVO_CENTER_Msk 4294901760U
+#define REG_MIXER__SERVO_CENTER_Pos 16U
+#define REG_GAIN_SCALE reg[41].u
+#define REG_GAIN_SCALE__TPA_BREAKPOINT (uint8_t)((reg[41].u & 255U) >> 0)
+#define REG_GAIN_SCALE__TPA_BREAKPOINT_Msk 255U
+#define REG_GAIN_SCALE__TPA_BREAKPOINT_Pos 0U
+#define REG_GAIN_SCALE__TPA_RATE (uint8_t)((reg[41].u & 65280U) >> 8)
+#define REG_GAIN_SCALE__TPA_RATE_Msk 65280U
+#define REG_GAIN_SCALE__TPA_RATE_Pos 8U
+#define REG_GAIN_SCALE__VBAT_REF (uint16_t)((reg[41].u & 4294901760U) >> 16)
+#define REG_GAIN_SCALE__VBAT_REF_Msk 4294901760U
+#define REG_GAIN_SCALE__VBAT_REF_Pos 16U
+#define REG_FF_PITCH reg[42].f
+#define REG_FF_ROLL reg[43].f
+#define REG_FF_YAW reg[44].f
+#define REG_GYRO_TC_X reg[45].f
+#define REG_GYRO_TC_Y reg[46].f
+#define REG_GYRO_TC_Z reg[47].f
+#define REG_GYRO_TC_TEMP reg[48].f
+#define REG_GYRO_TC reg[49].u
+#define REG_GYRO_TC__LEARN (uint8_t)((reg[49].u & 1U) >> 0)
+#define REG_GYRO_TC__LEARN_Msk 1U
+#define REG_GYRO_TC__LEARN_Pos 0U
+#define REG_GYRO_TC__TEMP_SPAN (uint8_t)((reg[49].u & 65280U) >> 8)
+#define REG_GYRO_TC__TEMP_SPAN_Msk 65280U
+#define REG_GYRO_TC__TEMP_SPAN_Pos 8U
+#define REG_CAL reg[50].u
+#define REG_CAL__SENSOR (uint8_t)((reg[50].u & 255U) >> 0)
+#define REG_CAL__SENSOR_Msk 255U
+#define REG_CAL__SENSOR_Pos 0U
+#define REG_CAL__RADIO_IDLE (uint8_t)((reg[50].u & 65280U) >> 8)
+#define REG_CAL__RADIO_IDLE_Msk 65280U
+#define REG_CAL__RADIO_IDLE_Pos 8U
+#define REG_CAL__RADIO_RANGE (uint8_t)((reg[50].u & 16711680U) >> 16)
+#define REG_CAL__RADIO_RANGE_Msk 16711680U
+#define REG_CAL__RADIO_RANGE_Pos 16U
+#define REG_DEBUG_RATE reg[51].u
+#define REG_DEBUG_RATE__SENSOR_RAW (uint8_t)((reg[51].u & 15U) >> 0)
+#define REG_DEBUG_RATE__SENSOR_RAW_Msk 15U
+#define REG_DEBUG_RATE__SENSOR_RAW_Pos 0U
+#define REG_DEBUG_RATE__SENSOR (uint8_t)((reg[51].u & 240U) >> 4)
+#define REG_DEBUG_RATE__SENSOR_Msk 240U
+#define REG_DEBUG_RATE__SENSOR_Pos 4U
+#define REG_DEBUG_RATE__ANGLE (uint8_t)((reg[51].u & 3840U) >> 8)
+#define REG_DEBUG_RATE__ANGLE_Msk 3840U
+#define REG_DEBUG_RATE__ANGLE_Pos 8U
+#define REG_DEBUG_RATE__RADIO_RAW (uint8_t)((reg[51].u & 61440U) >> 12)
+#define REG_DEBUG_RATE__RADIO_RAW_Msk 61440U
+#define REG_DEBUG_RATE__RADIO_RAW_Pos 12U
+#define REG_DEBUG_RATE__RADIO (uint8_t)((reg[51].u & 983040U) >> 16)
+#define REG_DEBUG_RATE__RADIO_Msk 983040U
+#define REG_DEBUG_RATE__RADIO_Pos 16U
+#define REG_DEBUG_RATE__PID (uint8_t)((reg[51].u & 15728640U) >> 20)
+#define REG_DEBUG_RATE__PID_Msk 15728640U
+#define REG_DEBUG_RATE__PID_Pos 20U
+#define REG_DEBUG_RATE__MOTOR (uint8_t)((reg[51].u & 251658240U) >> 24)
+#define REG_DEBUG_RATE__MOTOR_Msk 251658240U
+#define REG_DEBUG_RATE__MOTOR_Pos 24U
+#define REG_DEBUG_RATE__VBAT (uint8_t)((reg[51].u & 4026531840U) >> 28)
+#define REG_DEBUG_RATE__VBAT_Msk 4026531840U
+#define REG_DEBUG_RATE__VBAT_Pos 28U
+#define REG_BLACKBOX reg[52].u
+#define REG_BLACKBOX__ENABLE (uint8_t)((reg[52].u & 1U) >> 0)
+#define REG_BLACKBOX__ENABLE_Msk 1U
+#define REG_BLACKBOX__ENABLE_Pos 0U
+#define REG_BLACKBOX__RATE (uint8_t)((reg[52].u & 240U) >> 4)
+#define REG_BLACKBOX__RATE_Msk 240U
+#define REG_BLACKBOX__RATE_Pos 4U
+#define REG_BLACKBOX__ERASE (uint8_t)((reg[52].u & 256U) >> 8)
+#define REG_BLACKBOX__ERASE_Msk 256U
+#define REG_BLACKBOX__ERASE_Pos 8U
+#define REG_BLACKBOX_STATUS reg[53].u
+#define REG_BLACKBOX_STATUS__PAGES (uint16_t)((reg[53].u & 65535U) >> 0)
+#define REG_BLACKBOX_STATUS__PAGES_Msk 65535U
+#define REG_BLACKBOX_STATUS__PAGES_Pos 0U
+#define REG_BLACKBOX_STATUS__DROPPED (uint16_t)((reg[53].u & 4294901760U) >> 16)
+#define REG_BLACKBOX_STATUS__DROPPED_Msk 4294901760U
+#define REG_BLACKBOX_STATUS__DROPPED_Pos 16U
+#define REG_DEBUG_DELTA reg[54].u
+#define REG_DEBUG_DELTA__ENABLE (uint8_t)((reg[54].u & 1U) >> 0)
+#define REG_DEBUG_DELTA__ENABLE_Msk 1U
+#define REG_DEBUG_DELTA__ENABLE_Pos 0U
+#define REG_DEBUG_DELTA__KEYFRAME (uint8_t)((reg[54].u & 112U) >> 4)
+#define REG_DEBUG_DELTA__KEYFRAME_Msk 112U
+#define REG_DEBUG_DELTA__KEYFRAME_Pos 4U
+#define REG_BENCH reg[55].u
+#define REG_BENCH__RUN (uint8_t)((reg[55].u & 1U) >> 0)
+#define REG_BENCH__RUN_Msk 1U
+#define REG_BENCH__RUN_Pos 0U
+#define REG_BENCH__ITEM (uint8_t)((reg[55].u & 3840U) >> 8)
+#define REG_BENCH__ITEM_Msk 3840U
+#define REG_BENCH__ITEM_Pos 8U
+#define REG_BENCH_RESULT reg[56].f
+#define REG_LATENCY reg[57].u
+#define REG_LATENCY__ENABLE (uint8_t)((reg[57].u & 1U) >> 0)
+#define REG_LATENCY__ENABLE_Msk 1U
+#define REG_LATENCY__ENABLE_Pos 0U
+#define REG_LATENCY__RESET (uint8_t)((reg[57].u & 2U) >> 1)
+#define REG_LATENCY__RESET_Msk 2U
+#define REG_LATENCY__RESET_Pos 1U
+#define REG_LATENCY__BIN (uint8_t)((reg[57].u & 240U) >> 4)
+#define REG_LATENCY__BIN_Msk 240U
+#define REG_LATENCY__BIN_Pos 4U
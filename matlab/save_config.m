@@ -6,21 +6,11 @@ global ser
 fwrite(ser,[6,0,0,0,0,0]);
 sleep(3000)
 
-reg = fieldnames(fc.info);
-
-for n = 1:length(reg)
-   i = eval(sprintf('fc.info.%s',reg{n}));
-   if i(2) && (i(4) ~= 2)
-      fc.target = 0;
-      r = eval(sprintf('fc.%s',reg{n}));
-      fc.target = 1;
-      if i(3)
-         eval(sprintf('fc.%s(%f);',reg{n},r));
-      else
-         eval(sprintf('fc.%s(%d);',reg{n},r));
-      end
-   end
-end
+% Copy the RAM registers to flash (non-flash registers are ignored by reg_init)
+fc.target = 0;
+data = fc.read_block(0, fc.nb_reg);
+fc.target = 1;
+fc.write_block(0, data);
 
 fc.target = 0;
 
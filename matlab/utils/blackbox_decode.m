@@ -0,0 +1,91 @@
+function sessions = blackbox_decode(raw)
+	% Decode the blackbox log (see sw/inc/blackbox.h)
+	% sessions(k).period (us), .time (us), .gyro, .setpoint, .p, .i, .d (deg/s or PID unit, one column per axis),
+	% .motor (raw outputs), .vbat (V)
+	Scale = 16; % BLACKBOX_SCALE
+	Linear = [4:6,10:12]; % Fields predicted by a straight line (setpoint and I terms)
+	raw = double(raw(:)');
+	sessions = struct('period',{},'time',{},'gyro',{},'setpoint',{},'p',{},'i',{},'d',{},'motor',{},'vbat',{});
+	nf = 0;
+	k = 1;
+	while k <= length(raw)
+		switch raw(k)
+			case 72 % 'H'
+				if nf > 0
+					sessions(end+1) = session(period, data(1:m,:), Scale);
+				end
+				nf = raw(k+2);
+				[period, k] = varint(raw, k+3);
+				x1 = zeros(1,nf);
+				x2 = zeros(1,nf);
+				time = 0;
+				data = zeros(ceil(length(raw)/nf), nf+1);
+				m = 0;
+			case 73 % 'I'
+				[time, k] = varint(raw, k+1);
+				for n = 1:nf
+					[z, k] = varint(raw, k);
+					x1(n) = zigzag(z);
+				end
+				x2 = x1;
+				m = m + 1;
+				data(m,:) = [time, x1];
+			case 80 % 'P'
+				[z, k] = varint(raw, k+1);
+				time = time + period + zigzag(z);
+				x = x1;
+				x(Linear) = 2*x1(Linear) - x2(Linear);
+				for n = 1:nf
+					[z, k] = varint(raw, k);
+					x(n) = x(n) + zigzag(z);
+				end
+				x2 = x1;
+				x1 = x;
+				m = m + 1;
+				data(m,:) = [time, x];
+			otherwise
+				% 0xFF: end of the session, the next one starts on the next page
+				if nf > 0
+					sessions(end+1) = session(period, data(1:m,:), Scale);
+					nf = 0;
+				end
+				k = 256 * ceil(k / 256) + 1;
+		end
+	end
+	if nf > 0
+		sessions(end+1) = session(period, data(1:m,:), Scale);
+	end
+end
+
+function s = session(period, data, Scale)
+	nb_output = size(data,2) - 17;
+	s.period = period;
+	s.time = data(:,1);
+	s.gyro = data(:,2:4) / Scale;
+	s.setpoint = data(:,5:7) / Scale;
+	s.p = data(:,8:10) / Scale;
+	s.i = data(:,11:13) / Scale;
+	s.d = data(:,14:16) / Scale;
+	s.motor = data(:,17:16+nb_output);
+	s.vbat = data(:,end) / 1000;
+end
+
+function [x, k] = varint(raw, k)
+	x = 0;
+	s = 1;
+	while raw(k) >= 128
+		x = x + (raw(k) - 128) * s;
+		s = s * 128;
+		k = k + 1;
+	end
+	x = x + raw(k) * s;
+	k = k + 1;
+end
+
+function x = zigzag(z)
+	if mod(z,2)
+		x = -(z+1)/2;
+	else
+		x = z/2;
+	end
+end
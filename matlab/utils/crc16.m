@@ -0,0 +1,14 @@
+function crc = crc16(data)
+	% CRC-16/CCITT (polynomial 0x1021, initial value 0xFFFF), as crc16() in the firmware
+	crc = 65535;
+	for n = 1:length(data)
+		crc = bitxor(crc, bitshift(double(data(n)), 8));
+		for k = 1:8
+			if bitand(crc, 32768)
+				crc = bitxor(bitand(bitshift(crc, 1), 65535), 4129);
+			else
+				crc = bitand(bitshift(crc, 1), 65535);
+			end
+		end
+	end
+end
@@ -4,12 +4,14 @@ if nargin < 2, NbSamples = 1024; end
 
 global fc
 global ser
+global port
 
 figure(DebugCase);
 clf
 l = {};
 a = {};
 c = 'brgcmk';
+Channel = [0,1,7,3,4,5,6,6](DebugCase); % Telemetry channel (bit of the DEBUG register)
 
 WindowSizeSensor = 256;
 TimeWindowSizeSensor = 4000;
@@ -35,7 +37,7 @@ switch DebugCase
 		l{7} = line(nan(1,WindowSize),nan(1,WindowSize),'Parent',a{3},'Color',c(1));
 	case 2 % scaled sensors
 		dlen = 7;
-		dtype = 'float';
+		dtype = 'single';
 		WindowSize = WindowSizeSensor;
 		TimeWindowSize = TimeWindowSizeSensor;
 		for n = 1:3
@@ -52,7 +54,7 @@ switch DebugCase
 		l{7} = line(nan(1,WindowSize),nan(1,WindowSize),'Parent',a{3},'Color',c(1));
 	case 3 % vbat
 		dlen = 1;
-		dtype = 'float';
+		dtype = 'single';
 		WindowSize = WindowSizeVbat;
 		TimeWindowSize = TimeWindowSizeVbat;
 		a{1} = axes;
@@ -72,7 +74,7 @@ switch DebugCase
 		end
 	case 5 % commands
 		dlen = 4;
-		dtype = 'float';
+		dtype = 'single';
 		WindowSize = WindowSizeCommand;
 		TimeWindowSize = TimeWindowSizeCommand;
 		a{1} = subplot(211);
@@ -87,7 +89,7 @@ switch DebugCase
 		end
 	case 6 % pitch, roll, yaw
 		dlen = 3;
-		dtype = 'float';
+		dtype = 'single';
 		WindowSize = WindowSizeSensor;
 		TimeWindowSize = TimeWindowSizeSensor;
 		a{1} = axes;
@@ -98,7 +100,7 @@ switch DebugCase
 		end
 	case 7 % motors
 		dlen = 4;
-		dtype = 'float';
+		dtype = 'single';
 		WindowSize = WindowSizeSensor;
 		TimeWindowSize = TimeWindowSizeSensor;
 		for n = 1:4
@@ -122,46 +124,70 @@ end
 
 t = nan(1,WindowSize);
 d = nan(dlen,WindowSize);
-switch dtype
-	case 'int16'
-		r1 = 2*dlen+2;
-	case 'float'
-		r1 = 4*dlen+2;
-end
 n = 0;
-t0 = 0;
+buf = [];
+clear telemetry_decode % Reset the delta decoder
+
+if exist('fc_stream') == 3
+	% Compiled decoder (../matlab/fc_stream/make.m): a thread drains the port, full rate channels can be plotted
+	% It opens its own handle on the port, the serial object is closed meanwhile
+	fclose(ser);
+	fc_stream('open', port);
+	fc_stream('write', [1, fc.info.DEBUG(1), 2^Channel, 0, 0, 0]);
+	
+	while n < NbSamples
+		[x, tx] = fc_stream('read', Channel);
+		if isempty(x)
+			sleep(10);
+			continue
+		end
+		m = min(size(x,2), WindowSize);
+		n = n + size(x,2);
+		t(1:WindowSize-m) = t(m+1:WindowSize);
+		d(:,1:WindowSize-m) = d(:,m+1:WindowSize);
+		t(WindowSize-m+1:WindowSize) = tx(end-m+1:end) / 1000; % ms
+		d(:,WindowSize-m+1:WindowSize) = x(1:dlen,end-m+1:end);
+		
+		for m = 1:dlen
+			set(l{m},'XData',t-t(1));
+			set(l{m},'YData',d(m,:));
+		end
+		drawnow
+	end
+	
+	fc_stream('write', [1, fc.info.DEBUG(1), 0, 0, 0, 0]);
+	fc_stream('close');
+	ser = serial(port,115200,1);
+	return
+end
+
+fc.DEBUG(2^Channel);
 
 while n < NbSamples
 	
-	fc.DEBUG(DebugCase);
-	r = double(srl_read(ser,r1));
-	n = n + 1;
+	[frames, buf] = telemetry_decode([buf, double(srl_read(ser,64))]);
 	
-	t1 = r(1) + 2^8*r(2);
-	if t1 < (t(WindowSize-1)-t0)
-		t0 = t0 + 2^16;
-	end
-	if n == 1
-		t = ones(1,WindowSize)*(t0 + t1);
-	else
-		t(WindowSize) = t0 + t1;
+	for k = 1:length(frames)
+		p = frames(k).payload{Channel+1};
+		if isempty(p)
+			continue
+		end
+		n = n + 1;
+		x = double(typecast(uint8(p), dtype));
+		t(1:WindowSize-1) = t(2:WindowSize);
+		d(:,1:WindowSize-1) = d(:,2:WindowSize);
+		t(WindowSize) = frames(k).time / 1000; % ms
+		d(:,WindowSize) = x(1:dlen);
 	end
+	
 	for m = 1:dlen
-		switch dtype
-			case 'int16'
-				d(m,WindowSize) = c2s(2^8*r((m-1)*2+4) + r((m-1)*2+3), 16);
-			case 'float'
-				d(m,WindowSize) = typecast(uint32(2^24*r((m-1)*4+6) + 2^16*r((m-1)*4+5) + 2^8*r((m-1)*4+4) + r((m-1)*4+3)), 'single');
-		end
 		set(l{m},'XData',t-t(1));
 		set(l{m},'YData',d(m,:));
 	end
 	drawnow
 	
-	t(1:WindowSize-1) = t(2:WindowSize);
-	d(:,1:WindowSize-1) = d(:,2:WindowSize);
-	
 end
 
-end
+fc.DEBUG(0);
 
+end
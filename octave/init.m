@@ -2,15 +2,18 @@ restoredefaultpath;
 pkg load instrument-control
 addpath reg
 addpath utils
+addpath ../matlab/fc_stream
 
 clear all
 
 global fc
 global mpu
 global ser
+global port
 
 fc = fc_reg;
 mpu = mpu_reg;
 
 %ser = serial("COM9",115200,1);
-ser = serial("\\\\.\\COM11",115200,1);
\ No newline at end of file
+port = "\\\\.\\COM11";
+ser = serial(port,115200,1);
\ No newline at end of file
@@ -0,0 +1,88 @@
+function [frames, buf] = telemetry_decode(buf)
+	% Split the received bytes into telemetry frames (see sw/inc/telemetry.h)
+	% buf: bytes not decoded yet, the bytes of an incomplete frame are returned
+	% frames(k).channels (bitmask), .seq, .time (us), .payload{n+1} (bytes of channel n)
+	% Frames with a wrong CRC are skipped, a jump of seq means frames were lost
+	% Delta frames (A5 5B) are decoded back to the payloads of the raw frames (A5 5A), a channel
+	% is empty after a lost payload until its next keyframe
+	PayloadSize = [14,28,16,16,32,12,16,4]; % Channel sizes in bytes (4 motor outputs)
+	Fields = [7,7,4,8,8,3,4,1]; % Fields per channel
+	Type = {'int16','single','single','uint16','single','single','uint32','single'};
+	Scale = {1, [16,16,16,1000,1000,1000,100], 100, 1, 1000, 16, 1, 1000}; % Quantisation of the single fields
+	persistent z count
+	if isempty(z)
+		z = cell(1,8);
+		count = -ones(1,8);
+	end
+	buf = double(buf(:)');
+	frames = struct('channels',{},'seq',{},'time',{},'payload',{});
+	k = 1;
+	while length(buf) - k + 1 >= 11
+		if (buf(k) ~= 165) || ((buf(k+1) ~= 90) && (buf(k+1) ~= 91))
+			k = k + 1;
+			continue
+		end
+		len = buf(k+2);
+		if length(buf) - k + 1 < 11 + len
+			break
+		end
+		f = buf(k+2:k+8+len); % size, channels, seq, time, payloads
+		if crc16(f) ~= buf(k+9+len) + 256*buf(k+10+len)
+			k = k + 1;
+			continue
+		end
+		fr.channels = f(2);
+		fr.seq = f(3);
+		fr.time = sum(f(4:7) .* 2.^(0:8:24));
+		fr.payload = cell(1,8);
+		m = 8;
+		for n = 0:7
+			if ~bitand(fr.channels, 2^n)
+				continue
+			end
+			if buf(k+1) == 90
+				fr.payload{n+1} = f(m:m+PayloadSize(n+1)-1);
+				m = m + PayloadSize(n+1);
+				continue
+			end
+			% Count byte then zig-zag varints
+			c = mod(f(m), 128);
+			key = f(m) >= 128;
+			m = m + 1;
+			x = zeros(1,Fields(n+1));
+			for i = 1:Fields(n+1)
+				[x(i), m] = varint(f, m);
+			end
+			x = (x - mod(x,2)) / 2 .* (1 - 2*mod(x,2)) - mod(x,2); % Zig-zag
+			if ~key
+				if (count(n+1) < 0) || (mod(c - count(n+1), 128) ~= 1)
+					count(n+1) = -1; % Lost payload, wait for a keyframe
+					continue
+				end
+				x = x + z{n+1};
+			end
+			z{n+1} = x;
+			count(n+1) = c;
+			if strcmp(Type{n+1}, 'single')
+				fr.payload{n+1} = double(typecast(single(x ./ Scale{n+1}), 'uint8'));
+			else
+				fr.payload{n+1} = double(typecast(cast(x, Type{n+1}), 'uint8'));
+			end
+		end
+		frames(end+1) = fr;
+		k = k + 11 + len;
+	end
+	buf = buf(k:end);
+end
+
+function [x, m] = varint(f, m)
+	x = 0;
+	s = 1;
+	while f(m) >= 128
+		x = x + (f(m) - 128) * s;
+		s = s * 128;
+		m = m + 1;
+	end
+	x = x + f(m) * s;
+	m = m + 1;
+end
@@ -0,0 +1,39 @@
+#ifndef __BENCH_H
+#define __BENCH_H
+
+#include <stdint.h>
+
+/* Public defines -----------------*/
+
+#define BENCH_VECTORS 16 // Fixed inputs, BENCH_REPEAT calls per vector in a round of BENCH_ROUNDS (board.h)
+
+// Functions of the control path
+#define BENCH_MPU 0 // mpu_process_samples
+#define BENCH_ANGLE 1 // angle_estimate
+#define BENCH_RADIO_DECODE 2 // radio_decode for RADIO_TYPE
+#define BENCH_RADIO_EXPO 3 // radio_expo
+#define BENCH_DSHOT 4 // dshot_encode
+#define BENCH_PID_MIXER 5 // pid_update and mixer_run
+#define BENCH_REG_WRITE 6 // reg_access, register write
+#define BENCH_REG_READ 7 // reg_update_on_read, register read without the transfer
+#define NB_BENCH 8
+
+/* Public types -----------------*/
+
+// Clock ticks per call (CLOCK_TICKS, board.h) in the fastest round
+struct bench_s {
+	float best;
+};
+
+/* Exported variables -----------------*/
+
+extern struct bench_s bench[NB_BENCH];
+extern const char * const bench_name[NB_BENCH];
+
+/* Public functions -----------------*/
+
+void bench_start(void);
+_Bool bench_step(void);
+void bench_run(void);
+
+#endif
@@ -0,0 +1,47 @@
+#ifndef __BLACKBOX_H
+#define __BLACKBOX_H
+
+#include <stdint.h>
+#include "board.h" // NB_OUTPUT, BLACKBOX_SIZE
+
+/* Public defines -----------------*/
+
+// Log: a stream of records packed in flash pages, sessions start on a page boundary
+// Session header: 'H', version, number of fields, loop period (us, varint)
+// Keyframe: 'I', time (us, varint), fields (zig-zag varints)
+// Delta frame: 'P', time step (us, varint), fields minus their prediction (zig-zag varints)
+// 0xFF: end of the session in this page
+#define BLACKBOX_HEADER 'H'
+#define BLACKBOX_KEYFRAME 'I'
+#define BLACKBOX_DELTA 'P'
+#define BLACKBOX_VERSION 1
+
+// Fields: gyro (3), setpoint (3), P (3), I (3) and D (3) terms in 1/16 deg/s or PID unit,
+// motor outputs (raw), VBAT (mV)
+#define BLACKBOX_NB_FIELD (5 * 3 + NB_OUTPUT + 1)
+#define BLACKBOX_SCALE 16.0f
+
+#define BLACKBOX_PAGE_SIZE 256 // Flash page program
+#define BLACKBOX_BUFFER_SIZE 4096 // RAM ring, power of 2
+#define BLACKBOX_KEYFRAME_PERIOD 32 // Records between keyframes
+#define BLACKBOX_DUMP_SIZE 128 // Bytes per dump answer
+
+/* Public types -----------------*/
+
+/* Exported variables -----------------*/
+
+extern uint32_t blackbox_used;
+extern uint16_t blackbox_dropped;
+
+/* Public functions -----------------*/
+
+void blackbox_init(void);
+void blackbox_start(uint32_t period);
+void blackbox_stop(void);
+void blackbox_log(uint32_t time, const int32_t field[BLACKBOX_NB_FIELD]);
+_Bool blackbox_pending(void);
+void blackbox_service(void);
+void blackbox_erase(void);
+void blackbox_dump(uint32_t addr);
+
+#endif
@@ -10,8 +10,66 @@
 	#include "revolution.h"
 #elif defined(NUCLEO)
 	#include "nucleo.h"
+#elif defined(SIL)
+	#include "sil.h"
 #endif
 
+/* Public defines -----------------*/
+
+// Placement of the sensor -> PID -> mixer path, in zero wait state RAM if the board has some
+#ifndef FAST_CODE
+	#define FAST_CODE
+#endif
+#ifndef FAST_DATA
+	#define FAST_DATA
+#endif
+
+// Timing of the stages of the control path (STAGE_* in fc.h), only in the SIL build
+#ifndef STAGE_BEGIN
+	#define STAGE_BEGIN(stage)
+	#define STAGE_END(stage)
+#endif
+
+// Clock of the benchmarks (bench.c) and of the latency trace (latency.c): core cycles from the DWT, ns in the SIL build
+#ifndef CLOCK_TICKS
+	#define CLOCK_TICKS() (DWT->CYCCNT)
+	#define CLOCK_TICKS_START() do { CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk; DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk; } while (0)
+	#define CLOCK_TICKS_US (SystemCoreClock / 1000000)
+#endif
+#ifndef BENCH_ROUNDS
+	#define BENCH_ROUNDS 16
+	#define BENCH_REPEAT 1 // Passes over the vectors in a round
+#endif
+
+// Blackbox SPI flash size in bytes, 0 if the board has none
+#ifndef BLACKBOX_SIZE
+	#define BLACKBOX_SIZE 0
+#endif
+#define SPI_FLASH_CMD_SIZE 4 // Command and address bytes in front of the data of spi_flash_program
+
+// Timer prescalers from the timer clock
+#define TIMER_PSC_US(clock) ((clock) / 1000000 - 1) // 1us tick
+#define TIMER_PSC_100US(clock) ((clock) / 10000 - 1) // 100us tick
+#define ONESHOT_COUNT(x, clock) ((x) * ((clock) / 1000000) / 16) // 16 counts per us at 16MHz to counts at clock
+#define DSHOT_RATE 600000 // DShot600
+#define NB_OUTPUT 4 // Motor outputs of set_motors
+
+// NVIC: 2 bits of preemption priority, 2 bits of sub-priority
+#define IRQ_PRIORITY_GROUP 5
+#define IRQ_PRIO_SENSOR 0 // Sensor sample and motors, preempt everything else
+#define IRQ_PRIO_RADIO 1 // Radio receiver and RF link
+#define IRQ_PRIO_TIMER 2 // Timeouts, VBAT and beeper
+#define IRQ_PRIO_HOST 3 // USB or UART to host
+
+/* Public types -----------------*/
+
+typedef struct
+{
+	IRQn_Type irq;
+	uint8_t preempt;
+	uint8_t sub;
+} irq_priority_t;
+
 /* Public functions -----------------*/
 
 void board_init(void);
@@ -28,5 +86,9 @@ float get_vbat(void);
 void reset_timeout_radio(void);
 uint16_t get_timer_process(void);
 void radio_error_recover(void);
+void spi_flash_read(uint32_t addr, uint8_t * data, uint16_t size);
+void spi_flash_program(uint32_t addr, uint8_t * buf, uint16_t size);
+void spi_flash_erase(void);
+_Bool spi_flash_busy(void);
 	
 #endif
@@ -15,6 +15,18 @@
 #define TIMEOUT_RADIO 500 // ms
 #define TIMEOUT_SENSOR 10000 // us
 #define VBAT_PERIOD 10 // ms
+#define SENSOR_PERIOD 1000 // us
+#define RADIO_PERIOD 7000 // us, IBUS. Deadline of task_radio, the feedforward measures the period of the receiver
+#define HOST_DEADLINE 10000 // us
+
+// Stages of the control path, timed by STAGE_BEGIN and STAGE_END (board.h)
+#define STAGE_RADIO 0 // radio_decode
+#define STAGE_SENSOR 1 // mpu_process_samples
+#define STAGE_ANGLE 2 // angle_estimate
+#define STAGE_PID 3 // pid_update
+#define STAGE_MIXER 4 // mixer_run
+#define STAGE_MOTOR 5 // set_motors
+#define NB_STAGE 6
 
 /* Public types -----------------*/
 
@@ -32,13 +44,16 @@ extern volatile _Bool flag_radio;
 extern volatile _Bool flag_vbat;
 extern volatile _Bool flag_rf;
 extern volatile _Bool flag_host;
+extern volatile _Bool flag_blackbox;
 extern volatile _Bool flag_sensor_host_read;
 extern volatile _Bool flag_rf_host_read;
 extern volatile _Bool flag_timeout_sensor;
 extern volatile _Bool flag_timeout_radio;
 extern volatile _Bool flag_rf_rxtx_done;
 extern volatile _Bool flag_rf_host_read;
+extern volatile _Bool flag_armed;
 extern volatile _Bool flag_acro;
+extern volatile _Bool flag_pid_update;
 
 extern volatile _Bool flag_beep_user;
 extern volatile _Bool flag_beep_radio;
@@ -51,7 +66,13 @@ extern host_buffer_rx_t host_buffer_rx;
 extern uint16_t timer_sensor[2];
 extern uint16_t time_sensor;
 extern uint16_t time_process;
+extern uint16_t sensor_period_min;
+extern uint16_t sensor_period_max;
 
 /* Public functions -----------------*/
 
+void fc_init(void);
+_Bool fc_run(void);
+void sensor_ready(void);
+
 #endif
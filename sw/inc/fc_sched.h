@@ -0,0 +1,30 @@
+#ifndef __FC_SCHED_H
+#define __FC_SCHED_H
+
+#include <stdint.h>
+
+/* Public defines -----------------*/
+
+/* Public types -----------------*/
+
+// Tasks are listed by decreasing priority, the first one is the control task (if it runs in the main loop)
+typedef struct
+{
+	_Bool (*run)(void); // Run one slice, return 1 if another slice is needed
+	volatile _Bool * flag; // Release event, raised by interrupts
+	uint16_t deadline; // us after release, or after the previous slice
+	uint16_t budget; // us, maximum duration of one slice
+	_Bool ready;
+	uint16_t release;
+} task_t;
+
+/* Exported variables -----------------*/
+
+extern uint16_t sched_missed;
+extern uint16_t sched_overrun;
+
+/* Public functions -----------------*/
+
+_Bool sched_run(task_t * task, uint8_t nb_task);
+
+#endif
@@ -0,0 +1,49 @@
+#ifndef __LATENCY_H
+#define __LATENCY_H
+
+#include <stdint.h>
+#include "board.h" // LATENCY_END
+
+/* Public defines -----------------*/
+
+// Points of a sensor sample, stamped with CLOCK_TICKS (board.h) by latency_stamp
+#define LATENCY_DATA_READY 0 // Sensor data ready interrupt (EXTI), start of the sample
+#define LATENCY_SENSOR_DONE 1 // End of the sensor transfer (SPI or I2C DMA)
+#define LATENCY_PROCESS 2 // Start of task_sensor
+#define LATENCY_MOTOR 3 // Call of set_motors
+#define LATENCY_DSHOT 4 // End of the DShot DMA, boards with LATENCY_END LATENCY_DSHOT only
+#define NB_LATENCY_POINT 5
+
+#define LATENCY_NB_BIN 32 // Histogram of each point from LATENCY_DATA_READY, the last bin has the longer ones
+#define LATENCY_NB_WORST 8 // Samples with the longest time to LATENCY_END
+
+// Last point of a sample, where it is added to the histograms
+#ifndef LATENCY_END
+	#define LATENCY_END LATENCY_MOTOR
+#endif
+
+/* Public types -----------------*/
+
+// Read by the host as words (instruction 12)
+struct latency_s {
+	uint32_t ticks_us; // CLOCK_TICKS per us
+	uint32_t bin; // us per histogram bin (2^LATENCY__BIN)
+	uint32_t samples; // Complete samples
+	uint32_t dropped; // Samples without all their points (sensor transfer skipped, sample overrun)
+	uint32_t hist[NB_LATENCY_POINT - 1][LATENCY_NB_BIN];
+	uint32_t worst[LATENCY_NB_WORST][NB_LATENCY_POINT]; // Sample number, then the ticks of each point from LATENCY_DATA_READY
+};
+
+#define LATENCY_SIZE (sizeof(struct latency_s) / 4)
+
+/* Exported variables -----------------*/
+
+extern struct latency_s latency;
+
+/* Public functions -----------------*/
+
+void latency_stamp(uint8_t point);
+void latency_reset(void);
+void latency_read(uint8_t addr, uint8_t count);
+
+#endif
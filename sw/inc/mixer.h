@@ -0,0 +1,32 @@
+#ifndef __MIXER_H
+#define __MIXER_H
+
+#include <stdint.h>
+#include "utils.h" // QUAD_X
+#include "pid.h" // NB_AXIS
+
+/* Public defines -----------------*/
+
+#define MIXER_MAX_MOTOR 8
+
+// Number of motors of an airframe, usable in #if
+#define MIXER_NB_MOTOR(airframe) ((airframe) == HEX_X ? 6 : (airframe) == OCTO_X ? 8 : (airframe) == TRI ? 3 : 4)
+
+/* Public types -----------------*/
+
+// Contribution of pitch, roll and yaw to each motor
+struct mixer_s {
+	uint8_t nb_motor;
+	float coef[MIXER_MAX_MOTOR][NB_AXIS];
+	float servo[NB_AXIS]; // Tail servo of the tricopter
+};
+
+/* Exported variables -----------------*/
+
+extern const struct mixer_s mixer_table[NB_AIRFRAME];
+
+/* Public functions -----------------*/
+
+void mixer_run(const struct mixer_s * mixer, const float axis[NB_AXIS], float throttle, float out_min, float out_max, _Bool airmode, float * motor, uint8_t * sat_high, uint8_t * sat_low);
+
+#endif
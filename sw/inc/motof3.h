@@ -5,9 +5,14 @@
 #define USE_HAL_DRIVER
 #include "stm32f3xx.h"
 #define REG_FLASH_ADDR 0x0803F800
+#define SYSCLK 48000000 // 48000000 or 72000000
 #define SENSOR MPU6050
 #define SENSOR_ORIENTATION 90
 #define RADIO_TYPE IBUS
 //#define ESC DSHOT
+#define CONTROL_LOOP MAIN_LOOP
+#define AIRFRAME QUAD_X // QUAD_X or QUAD_PLUS (no timer of its own for the TRI servo)
+#define FAST_CODE __attribute__((section(".ccm_code"))) // CCM RAM, see prj/f303_ccm.sct
+#define FAST_DATA __attribute__((section(".ccm_data"), zero_init))
 
 #endif
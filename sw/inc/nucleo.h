@@ -5,9 +5,12 @@
 //#define USE_HAL_DRIVER
 #include "stm32f3xx.h"
 #define REG_FLASH_ADDR 0x0800F800
+#define SYSCLK 48000000 // 48000000 or 72000000
 #define SENSOR MPU9150
 #define SENSOR_ORIENTATION 0
 #define RADIO_TYPE IBUS
 //#define ESC DSHOT
+#define CONTROL_LOOP MAIN_LOOP
+#define AIRFRAME QUAD_X // QUAD_X or QUAD_PLUS (no timer of its own for the TRI servo)
 
 #endif
@@ -0,0 +1,59 @@
+#ifndef __PID_H
+#define __PID_H
+
+#include <stdint.h>
+
+/* Public defines -----------------*/
+
+#define PITCH 0
+#define ROLL 1
+#define YAW 2
+#define NB_AXIS 3
+
+// Flavours, selected at run time with pid.flags
+#define PID_D_ON_MEASURE 0x01 // Derivative of the measure instead of the error (no kick on setpoint steps)
+#define PID_D_FILTER 0x02 // First order low-pass filter on D
+#define PID_SETPOINT_WEIGHT 0x04 // P on (measure - weight * setpoint)
+#define PID_FEEDFORWARD 0x08 // Add pid.ff to the output
+#define PID_ANTI_WINDUP 0x10 // Hold I when the mixer is saturated, back-calculate I when the output is clipped
+
+// Flavours compiled in, the others are never evaluated
+#ifndef PID_FLAVOURS
+	#define PID_FLAVOURS (PID_D_ON_MEASURE | PID_D_FILTER | PID_SETPOINT_WEIGHT | PID_FEEDFORWARD | PID_ANTI_WINDUP)
+#endif
+
+/* Public types -----------------*/
+
+// Structure of arrays, one element per axis
+struct pid_s {
+	// Configuration
+	float kp[NB_AXIS];
+	float ki[NB_AXIS];
+	float kd[NB_AXIS];
+	float weight; // Setpoint weight of P
+	float d_alpha; // D low-pass filter coefficient
+	float i_max;
+	float out_max;
+	uint8_t flags;
+	// Inputs
+	float ff[NB_AXIS];
+	float scale[NB_AXIS]; // Gain scale of P, D and of the I increment (throttle and VBAT)
+	uint8_t sat_high; // Axes (bit per axis) whose output can not increase, set by the mixer
+	uint8_t sat_low; // Axes whose output can not decrease
+	// State
+	float error[NB_AXIS];
+	float d_input_z[NB_AXIS];
+	float p_term[NB_AXIS];
+	float i_term[NB_AXIS];
+	float d_term[NB_AXIS];
+	float out[NB_AXIS];
+};
+
+/* Exported variables -----------------*/
+
+/* Public functions -----------------*/
+
+void pid_init(struct pid_s * pid, float i_max, float out_max);
+void pid_update(struct pid_s * pid, const float setpoint[NB_AXIS], const float measure[NB_AXIS], uint8_t i_reset);
+
+#endif
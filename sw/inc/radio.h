@@ -5,6 +5,12 @@
 
 /* Public defines -----------------*/
 
+#define SX1276_SPI_CLOCK 10000000 // Max SPI clock
+
+#define RADIO_CAL_OFF 0
+#define RADIO_CAL_IDLE 1
+#define RADIO_CAL_RANGE 2
+
 #if (RADIO_TYPE == IBUS)
 	#define THROTTLE_IDLE_DEFAULT 1000
 	#define THROTTLE_RANGE_DEFAULT 1000
@@ -22,7 +28,7 @@
 	#define AILERON_IDLE_DEFAULT 12000
 	#define AILERON_RANGE_DEFAULT 3200
 	#define ELEVATOR_IDLE_DEFAULT 12000
-	#define ELEVATOR_RANGE_DEFAULT 32000
+	#define ELEVATOR_RANGE_DEFAULT 3200
 	#define RUDDER_IDLE_DEFAULT 12000
 	#define RUDDER_RANGE_DEFAULT 3200
 	#define AUX_IDLE_DEFAULT 8800
@@ -117,13 +123,35 @@ struct radio_s {
 	float aux[4];
 };
 
+// Calibration state, progress in %
+struct radio_cal_s {
+	uint8_t mode;
+	uint16_t count;
+	uint8_t progress_idle;
+	uint8_t progress_range;
+	float aileron_idle;
+	float elevator_idle;
+	float rudder_idle;
+	uint16_t throttle_min;
+	uint16_t throttle_max;
+	uint16_t aileron_min;
+	uint16_t aileron_max;
+	uint16_t elevator_min;
+	uint16_t elevator_max;
+	uint16_t rudder_min;
+	uint16_t rudder_max;
+};
+
 /* Exported variables -----------------*/
 
+extern struct radio_cal_s radio_cal;
+
 /* Public functions -----------------*/
 
 _Bool radio_decode(radio_frame_t * radio_frame, struct radio_raw_s * radio_raw, struct radio_s * radio);
-void radio_cal_idle(radio_frame_t * radio_frame);
-void radio_cal_range(radio_frame_t * radio_frame);
+void radio_cal_start(uint8_t mode);
+void radio_cal_stop(void);
+void radio_cal_step(struct radio_raw_s * radio_raw);
 void radio_expo(struct radio_s * radio, _Bool acro_mode);
 void sx1276_init(void);
 
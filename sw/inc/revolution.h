@@ -5,9 +5,14 @@
 #define USE_HAL_DRIVER
 #include "stm32f4xx.h"
 #define REG_FLASH_ADDR 0x080E0000
+#define SYSCLK 96000000 // 96000000 or 168000000
 #define SENSOR MPU6000
 #define SENSOR_ORIENTATION 180
 #define RADIO_TYPE IBUS
 #define ESC DSHOT
+#define CONTROL_LOOP MAIN_LOOP
+#define AIRFRAME QUAD_X // QUAD_X, QUAD_PLUS or TRI (with ONESHOT, servo on the first output)
+#define SERVO_DIVIDER 4 // TRI: servo pulse every 4 motor frames, the first output is alone on TIM3
+#define BLACKBOX_SIZE 0x200000 // M25P16 SPI flash
 
 #endif
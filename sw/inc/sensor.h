@@ -5,6 +5,13 @@
 
 /* Public defines -----------------*/
 
+#define MPU_SPI_CLOCK_REG 1000000 // Max SPI clock for all registers
+#define MPU_SPI_CLOCK_DATA 20000000 // Max SPI clock for sensor data registers
+#define MPU_GYRO_SCALE 0.061035f // deg/s per LSB
+#define MPU_ACCEL_SCALE 0.00048828f // g per LSB
+#define MPU_TEMP_SCALE (1.0f / 340.0f)
+#define MPU_TEMP_OFFSET 36.53f
+
 /* Public macros -----------------*/
 
 /* Public types -----------------*/
@@ -42,15 +49,45 @@ struct angle_s {
 	float roll_from_accel;
 };
 
+// Offset calibration, progress in %
+struct mpu_cal_s {
+	_Bool running;
+	uint16_t count;
+	uint8_t progress;
+	float gyro_x_dc;
+	float gyro_y_dc;
+	float gyro_z_dc;
+	float accel_x_dc;
+	float accel_y_dc;
+	float accel_z_dc;
+	float temperature;
+};
+
+// Least squares sums of the gyro drift fit (x: temperature, y: raw gyro bias)
+struct drift_s {
+	uint16_t count;
+	float n;
+	float sx;
+	float sxx;
+	float sy[3];
+	float sxy[3];
+};
+
 /* Exported variables -----------------*/
 
+extern struct mpu_cal_s mpu_cal;
+
 /* Public functions -----------------*/
 
 void mpu6000_init(void);
 void mpu6050_init(void);
 void mpu9150_init(void);
 void mpu_process_samples(sensor_raw_t * sensor_raw, struct sensor_s * sensor);
-void mpu_cal(sensor_raw_t * sensor_raw);
+void mpu_cal_start(void);
+void mpu_cal_stop(void);
+void mpu_cal_step(sensor_raw_t * sensor_raw);
+void gyro_drift_reset(void);
+void gyro_drift_learn(sensor_raw_t * sensor_raw, struct sensor_s * sensor);
 void angle_estimate(struct sensor_s * sensor, struct angle_s * angle, _Bool yaw_transfer_is_on);
 
 #endif
@@ -0,0 +1,75 @@
+#ifndef __SIL_H
+#define __SIL_H
+
+// Software in the loop: the control path built for a Linux host with gcc (host/CMakeLists.txt, fc_sil)
+// The peripherals are replaced by sil.c, the host tools drive it through sil_host.h
+#include <stdint.h>
+#define REG_FLASH_ADDR 0 // Page in RAM, see sil_flash
+#define SYSCLK 72000000
+#define SENSOR MPU6000
+#ifndef SENSOR_ORIENTATION
+	#define SENSOR_ORIENTATION 90 // Same as the board of the capture
+#endif
+#ifndef RADIO_TYPE
+	#define RADIO_TYPE IBUS
+#endif
+#ifndef ESC
+	#define ESC DSHOT
+#endif
+#define CONTROL_LOOP MAIN_LOOP
+#ifndef AIRFRAME
+	#define AIRFRAME QUAD_X
+#endif
+
+// Compiler intrinsics, __packed is defined by the build (host/CMakeLists.txt)
+#define __forceinline inline __attribute__((always_inline))
+#define __wfi()
+#define __disable_irq()
+#define __enable_irq()
+
+// Stage timing of the control path
+#define STAGE_BEGIN(stage) sil_stage_begin(stage)
+#define STAGE_END(stage) sil_stage_end(stage)
+
+// Clock of the benchmarks and of the latency trace, ns
+#define CLOCK_TICKS() sil_clock_ticks()
+#define CLOCK_TICKS_START()
+#define CLOCK_TICKS_US 1000
+#define BENCH_ROUNDS 64 // Longer rounds than on target, the host clock and scheduler are coarser
+#define BENCH_REPEAT 64
+
+// Core and flash registers used by fc.c and reg.c
+typedef int IRQn_Type;
+
+typedef struct
+{
+	volatile uint32_t CTRL;
+} SysTick_Type;
+
+typedef struct
+{
+	volatile uint32_t KEYR;
+	volatile uint32_t SR;
+	volatile uint32_t CR;
+	volatile uint32_t AR;
+} FLASH_TypeDef;
+
+#define SysTick_CTRL_TICKINT_Msk (1UL << 1)
+#define FLASH_CR_PG (1UL << 0)
+#define FLASH_CR_PER (1UL << 1)
+#define FLASH_CR_STRT (1UL << 6)
+#define FLASH_CR_LOCK (1UL << 7)
+#define FLASH_SR_BSY (1UL << 0)
+
+extern SysTick_Type sil_systick;
+extern FLASH_TypeDef sil_flash_reg;
+extern uint32_t sil_flash[];
+#define SysTick (&sil_systick)
+#define FLASH (&sil_flash_reg)
+
+void sil_flash_erase(void);
+void sil_stage_begin(uint8_t stage);
+void sil_stage_end(uint8_t stage);
+uint32_t sil_clock_ticks(void);
+
+#endif
@@ -0,0 +1,81 @@
+#ifndef __SIL_HOST_H
+#define __SIL_HOST_H
+
+// Interface of the SIL build for the host tools (host/tools/fcreplay.cpp, fcsil.cpp), plain types usable from C++
+// The structures only have 4 and 8 byte fields, their layout does not depend on -fpack-struct
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Public defines -----------------*/
+
+#define SIL_SENSOR_RAW_SIZE 14 // Payload of TELEMETRY_SENSOR_RAW
+#define SIL_RADIO_NB_CHAN 8 // Payload of TELEMETRY_RADIO_RAW (struct radio_raw_s)
+#define SIL_NB_OUTPUT 4 // NB_OUTPUT
+#define SIL_NB_TIMING 8 // Stages of fc.h (STAGE_*), then whole sensor sample and radio frame
+#define SIL_NB_BENCH 8 // NB_BENCH
+
+/* Public types -----------------*/
+
+// State of the control path after a sample
+struct sil_output_s {
+	uint32_t time; // us, time base of the telemetry
+	uint32_t armed;
+	uint32_t acro;
+	float gyro[3]; // deg/s
+	float accel[3]; // g
+	float angle[2]; // deg, pitch and roll
+	float radio[4]; // Throttle, pitch, roll and yaw commands after expo
+	float setpoint[3]; // Pitch, roll and yaw
+	float pid[3];
+	uint32_t motor[SIL_NB_OUTPUT]; // Raw motor commands
+};
+
+// Motors of the build for a model of the aircraft (host/include/fc/plant.h)
+struct sil_airframe_s {
+	float coef[SIL_NB_OUTPUT][3]; // Pitch, roll and yaw of mixer_table[AIRFRAME] for each output, zero without motor
+	uint32_t dshot; // Motor commands: 1 DShot throttle (48 to 2047, 0 stops), 0 OneShot (0 to MOTOR_MAX)
+};
+
+// Host time of a stage, ns
+struct sil_timing_s {
+	uint64_t count;
+	uint64_t total;
+	uint64_t min;
+	uint64_t max;
+};
+
+// Host time of a benchmark of bench.c, ns per call in the fastest round
+struct sil_bench_s {
+	float best;
+};
+
+/* Exported variables -----------------*/
+
+extern struct sil_timing_s sil_timing[SIL_NB_TIMING];
+extern const char * const sil_timing_name[SIL_NB_TIMING];
+
+/* Public functions -----------------*/
+
+void sil_init(void);
+void sil_set_host(void (*send)(const uint8_t * data, uint8_t size));
+void sil_sensor(uint32_t period, const uint8_t raw[SIL_SENSOR_RAW_SIZE]);
+void sil_mpu(uint32_t period, const float gyro[3], const float accel[3], float temperature);
+void sil_radio(const uint16_t raw[SIL_RADIO_NB_CHAN]);
+void sil_sticks(const float stick[SIL_RADIO_NB_CHAN]);
+void sil_vbat(float vbat);
+uint32_t sil_reg_read(uint8_t addr);
+void sil_reg_write(uint8_t addr, uint32_t value);
+void sil_output(struct sil_output_s * output);
+void sil_airframe(struct sil_airframe_s * airframe);
+void sil_timing_reset(void);
+void sil_bench(struct sil_bench_s result[SIL_NB_BENCH], const char * name[SIL_NB_BENCH]);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
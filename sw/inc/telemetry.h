@@ -0,0 +1,66 @@
+#ifndef __TELEMETRY_H
+#define __TELEMETRY_H
+
+#include <stdint.h>
+#include "board.h" // NB_OUTPUT
+
+/* Public defines -----------------*/
+
+// Frame: sync (A5 5A), payload size, channels, sequence, time (us), payloads by increasing channel, CRC16
+// Little endian, the CRC covers everything after the sync word
+#define TELEMETRY_SYNC_0 0xA5
+#define TELEMETRY_SYNC_1 0x5A
+#define TELEMETRY_HEADER_SIZE 9
+#define TELEMETRY_SIZE_MAX 128
+
+// Delta frames (sync A5 5B, DEBUG_DELTA register): each payload is a count byte (bit 7: keyframe, bits 6:0: count of
+// the channel) followed by zig-zag varints of the quantised fields, absolute in a keyframe, minus the last value otherwise
+#define TELEMETRY_SYNC_1_DELTA 0x5B
+#define TELEMETRY_KEYFRAME 0x80
+#define TELEMETRY_FIELD_MAX 8
+
+// Field types
+#define TELEMETRY_INT16 0
+#define TELEMETRY_UINT16 1
+#define TELEMETRY_UINT32 2
+#define TELEMETRY_FLOAT 3
+
+// Channels: bit n of DEBUG, decimation 2^x with x in bits 4n+3:4n of DEBUG_RATE
+#define TELEMETRY_SENSOR_RAW 0
+#define TELEMETRY_SENSOR 1
+#define TELEMETRY_ANGLE 2
+#define TELEMETRY_RADIO_RAW 3
+#define TELEMETRY_RADIO 4
+#define TELEMETRY_PID 5
+#define TELEMETRY_MOTOR 6
+#define TELEMETRY_VBAT 7
+#define TELEMETRY_NB_CHANNEL 8
+
+#if (NB_OUTPUT > TELEMETRY_FIELD_MAX)
+	#error "Too many motor outputs for the MOTOR telemetry channel"
+#endif
+
+/* Public types -----------------*/
+
+// Fields of a channel, float fields are sent as round(x * scale)
+struct telemetry_coding_s {
+	uint8_t type;
+	uint8_t nb;
+	float scale[TELEMETRY_FIELD_MAX];
+};
+
+// Frame being built, one per sending task (the sequence number counts its frames)
+struct telemetry_s {
+	uint8_t buf[TELEMETRY_SIZE_MAX];
+	uint8_t size;
+	uint8_t seq;
+};
+
+/* Public functions -----------------*/
+
+_Bool telemetry_due(uint8_t channel, uint16_t count);
+void telemetry_start(struct telemetry_s * telemetry, uint32_t time);
+void telemetry_add(struct telemetry_s * telemetry, uint8_t channel, void * data, uint8_t size);
+void telemetry_send(struct telemetry_s * telemetry);
+
+#endif
@@ -6,14 +6,20 @@
 
 /* Public defines -----------------*/
 
+#define USB_TX_RING_SIZE 1024 // bytes, power of 2
+
 /* Public types -----------------*/
 
 /* Public variables -----------------*/
 
 extern USBD_HandleTypeDef USBD_device_handler;
+extern uint16_t usb_tx_dropped;
 
 /* Public functions -----------------*/
 
 void usb_init(void);
+_Bool usb_send(uint8_t * data, uint16_t size);
+void usb_tx_service(void);
+void usb_tx_reset(void);
 	
 #endif
@@ -14,6 +14,14 @@
 #define IBUS 0
 #define SUMD 1
 #define SBUS 2
+#define MAIN_LOOP 0
+#define SENSOR_ISR 1
+#define QUAD_X 0
+#define QUAD_PLUS 1
+#define HEX_X 2
+#define OCTO_X 3
+#define TRI 4
+#define NB_AIRFRAME 5
 
 #define EXPONENTIAL exp
 #define ARCSINUS asin
@@ -26,6 +34,8 @@
 /* Public variables -----------------*/
 
 extern volatile uint32_t tick;
+extern uint32_t dshot_bit0;
+extern uint32_t dshot_bit1;
 
 /* Public functions -----------------*/
 
@@ -33,9 +43,14 @@ void wait_ms(uint32_t t);
 float uint32_to_float(uint32_t x);
 uint32_t int32_to_uint32(int32_t x);
 int32_t uint32_to_int32(uint32_t x);
+void dshot_init(uint32_t timer_period);
 void dshot_encode(volatile uint32_t* val, volatile uint32_t buf[17]);
+uint32_t spi_br(uint32_t clock, uint32_t f_max);
 float expo(float lin);
 float arcsin(float sin_val);
 float sinus(float angle);
+uint16_t crc16(uint8_t * data, uint32_t size);
+uint32_t zigzag_encode(int32_t x);
+uint8_t varint_encode(uint8_t * buf, uint32_t x);
 
 #endif
@@ -0,0 +1,300 @@
+#include "bench.h"
+#include "board.h" // CLOCK_TICKS
+#include "fc.h" // MOTOR_MAX
+#include "reg.h"
+#include "sensor.h"
+#include "radio.h"
+#include "pid.h"
+#include "mixer.h"
+#include "utils.h" // dshot_encode
+
+/* Private defines --------------------------------------*/
+
+#define BENCH_SEED 0x2545F491 // Same vectors on every run and every board
+
+/* Private macros --------------------------------------*/
+
+// One round of BENCH_REPEAT calls per vector, without interrupts so that the sensor task does not preempt it
+#define BENCH_ROUND(call) \
+	__disable_irq(); \
+	t = CLOCK_TICKS(); \
+	for (repeat=0; repeat<BENCH_REPEAT; repeat++) { \
+		for (i=0; i<BENCH_VECTORS; i++) { \
+			call; \
+		} \
+	} \
+	t = CLOCK_TICKS() - t; \
+	__enable_irq();
+
+/* Private types --------------------------------------*/
+
+struct bench_pid_s {
+	float setpoint[NB_AXIS];
+	float measure[NB_AXIS];
+	float throttle;
+};
+
+/* Private functions ------------------------------------------------*/
+
+uint32_t bench_random(void);
+float bench_uniform(float min, float max);
+void bench_add(uint8_t b, uint32_t t, uint16_t round);
+void bench_setup(uint8_t b);
+
+/* Global variables --------------------------------------*/
+
+struct bench_s bench[NB_BENCH];
+const char * const bench_name[NB_BENCH] =
+{
+	"mpu_process_samples",
+	"angle_estimate",
+#if (RADIO_TYPE == IBUS)
+	"radio_decode_ibus",
+#elif (RADIO_TYPE == SUMD)
+	"radio_decode_sumd",
+#elif (RADIO_TYPE == SBUS)
+	"radio_decode_sbus",
+#endif
+	"radio_expo",
+	"dshot_encode",
+	"pid_mixer",
+	"reg_access_write",
+	"reg_update_on_read"
+};
+
+uint32_t bench_state;
+uint8_t bench_item; // Benchmark in progress, NB_BENCH when done
+uint16_t bench_round;
+
+// Inputs of the benchmark in progress, one buffer for all of them
+union {
+	sensor_raw_t raw[BENCH_VECTORS];
+	struct sensor_s sensor[BENCH_VECTORS];
+	radio_frame_t frame[BENCH_VECTORS];
+	struct radio_s radio[BENCH_VECTORS];
+	uint32_t motor[BENCH_VECTORS];
+	struct bench_pid_s pid[BENCH_VECTORS];
+} bench_in;
+
+// State of the functions under test, carried from round to round
+struct {
+	struct sensor_s sensor;
+	struct angle_s angle;
+	struct radio_raw_s radio_raw;
+	struct radio_s radio;
+	uint32_t dshot[17];
+	struct pid_s pid;
+	float motor[MIXER_MAX_MOTOR];
+	host_buffer_rx_t cmd;
+} bench_ctx;
+
+/* Function definitions ----------------------------------*/
+
+// xorshift32
+uint32_t bench_random(void)
+{
+	bench_state ^= bench_state << 13;
+	bench_state ^= bench_state >> 17;
+	bench_state ^= bench_state << 5;
+	return bench_state;
+}
+
+float bench_uniform(float min, float max)
+{
+	return min + (max - min) * (float)(bench_random() >> 8) / 16777216.0f;
+}
+
+void bench_add(uint8_t b, uint32_t t, uint16_t round)
+{
+	float x = (float)t / (float)(BENCH_VECTORS * BENCH_REPEAT);
+	
+	if ((round == 0) || (x < bench[b].best))
+		bench[b].best = x;
+}
+
+// Inputs and state of a benchmark, in order from bench_start so that the vectors are the same on every run
+void bench_setup(uint8_t b)
+{
+	int i;
+	int j;
+	
+	switch (b)
+	{
+		case BENCH_MPU:
+		{
+			// Sensor samples as read by the SPI
+			for (i=0; i<BENCH_VECTORS; i++) {
+				for (j=0; j<16; j++)
+					bench_in.raw[i].bytes[j] = (uint8_t)bench_random();
+			}
+			break;
+		}
+		case BENCH_ANGLE:
+		{
+			// Rates up to 500 deg/s, accel around 1g
+			for (i=0; i<BENCH_VECTORS; i++) {
+				bench_in.sensor[i].gyro_x = bench_uniform(-500.0f, 500.0f);
+				bench_in.sensor[i].gyro_y = bench_uniform(-500.0f, 500.0f);
+				bench_in.sensor[i].gyro_z = bench_uniform(-500.0f, 500.0f);
+				bench_in.sensor[i].accel_x = bench_uniform(-0.5f, 0.5f);
+				bench_in.sensor[i].accel_y = bench_uniform(-0.5f, 0.5f);
+				bench_in.sensor[i].accel_z = bench_uniform(0.5f, 1.5f);
+				bench_in.sensor[i].temperature = 30.0f;
+			}
+			bench_ctx.angle.pitch = 0;
+			bench_ctx.angle.roll = 0;
+			bench_ctx.angle.pitch_from_accel = 0;
+			bench_ctx.angle.roll_from_accel = 0;
+			break;
+		}
+		case BENCH_RADIO_DECODE:
+		{
+			// Valid frames of the receiver, channels over their range
+			for (i=0; i<BENCH_VECTORS; i++) {
+				for (j=0; j<(int)sizeof(radio_frame_t); j++)
+					bench_in.frame[i].bytes[j] = 0;
+				#if (RADIO_TYPE == IBUS)
+					bench_in.frame[i].frame.header = 0x4020;
+					for (j=0; j<14; j++)
+						bench_in.frame[i].frame.chan[j] = (uint16_t)(1000 + bench_random() % 1001);
+				#elif (RADIO_TYPE == SUMD)
+					bench_in.frame[i].frame.vendor_id = 0xA8;
+					bench_in.frame[i].frame.status = 0x01;
+					bench_in.frame[i].frame.nb_chan = 12;
+					for (j=0; j<12; j++)
+						bench_in.frame[i].frame.chan[j] = (uint16_t)(8800 + bench_random() % 6401);
+				#elif (RADIO_TYPE == SBUS)
+					bench_in.frame[i].frame.header = 0x0F;
+					bench_in.frame[i].frame.chan0 = 172 + bench_random() % 1640;
+					bench_in.frame[i].frame.chan1 = 172 + bench_random() % 1640;
+					bench_in.frame[i].frame.chan2 = 172 + bench_random() % 1640;
+					bench_in.frame[i].frame.chan3 = 172 + bench_random() % 1640;
+					bench_in.frame[i].frame.chan4 = 172 + bench_random() % 1640;
+					bench_in.frame[i].frame.chan5 = 172 + bench_random() % 1640;
+					bench_in.frame[i].frame.chan6 = 172 + bench_random() % 1640;
+					bench_in.frame[i].frame.chan7 = 172 + bench_random() % 1640;
+				#endif
+			}
+			break;
+		}
+		case BENCH_RADIO_EXPO:
+		{
+			// Sticks after radio_decode, expo in acro (pitch, roll and yaw)
+			for (i=0; i<BENCH_VECTORS; i++) {
+				bench_in.radio[i].throttle = bench_uniform(0.0f, 1.0f);
+				bench_in.radio[i].pitch = bench_uniform(-1.0f, 1.0f);
+				bench_in.radio[i].roll = bench_uniform(-1.0f, 1.0f);
+				bench_in.radio[i].yaw = bench_uniform(-1.0f, 1.0f);
+				for (j=0; j<4; j++)
+					bench_in.radio[i].aux[j] = bench_uniform(0.0f, 1.0f);
+			}
+			break;
+		}
+		case BENCH_DSHOT:
+		{
+			// DShot throttle values
+			for (i=0; i<BENCH_VECTORS; i++)
+				bench_in.motor[i] = 48 + bench_random() % 2000;
+			break;
+		}
+		case BENCH_PID_MIXER:
+		{
+			// Acro rates, all the flavours of the PID compiled in (D on measurement, filtered D, setpoint weight, feedforward,
+			// anti-windup) and airmode
+			for (i=0; i<BENCH_VECTORS; i++) {
+				for (j=0; j<NB_AXIS; j++) {
+					bench_in.pid[i].setpoint[j] = bench_uniform(-500.0f, 500.0f);
+					bench_in.pid[i].measure[j] = bench_in.pid[i].setpoint[j] + bench_uniform(-50.0f, 50.0f);
+				}
+				bench_in.pid[i].throttle = bench_uniform(0.0f, 1.0f) * (float)REG_MOTOR__RANGE;
+			}
+			pid_init(&bench_ctx.pid, 300.0f, 600.0f);
+			for (j=0; j<NB_AXIS; j++) {
+				bench_ctx.pid.kp[j] = 2.0f;
+				bench_ctx.pid.ki[j] = 0.02f;
+				bench_ctx.pid.kd[j] = 0.01f;
+			}
+			bench_ctx.pid.weight = 0.8f;
+			bench_ctx.pid.d_alpha = 0.5f;
+			bench_ctx.pid.flags = PID_FLAVOURS;
+			break;
+		}
+		case BENCH_REG_WRITE:
+		{
+			// Host write of a register without hook, with its own value
+			bench_ctx.cmd.instr = 1;
+			bench_ctx.cmd.addr = (uint8_t)((reg_t*)&REG_DEBUG_RATE - reg);
+			bench_ctx.cmd.data.u32 = REG_DEBUG_RATE;
+			break;
+		}
+	}
+}
+
+// Restart the benchmarks from the first one, run by bench_step
+void bench_start(void)
+{
+	bench_state = BENCH_SEED;
+	bench_item = 0;
+	bench_round = 0;
+}
+
+// Run one round of the benchmark in progress (BENCH_VECTORS * BENCH_REPEAT calls), return 1 until the last one is done
+// mpu_process_samples swaps the bytes of its input in place, the rounds alternate between two byte orders
+_Bool bench_step(void)
+{
+	int i;
+	uint16_t repeat;
+	uint32_t t;
+	
+	if (bench_item >= NB_BENCH)
+		return 0;
+	if (bench_round == 0)
+		bench_setup(bench_item);
+	
+	switch (bench_item)
+	{
+		case BENCH_MPU:
+			BENCH_ROUND(mpu_process_samples(&bench_in.raw[i], &bench_ctx.sensor));
+			break;
+		case BENCH_ANGLE:
+			BENCH_ROUND(angle_estimate(&bench_in.sensor[i], &bench_ctx.angle, 0));
+			break;
+		case BENCH_RADIO_DECODE:
+			BENCH_ROUND(radio_decode(&bench_in.frame[i], &bench_ctx.radio_raw, &bench_ctx.radio));
+			break;
+		case BENCH_RADIO_EXPO: // The copy of the input is part of the time
+			BENCH_ROUND(bench_ctx.radio = bench_in.radio[i]; radio_expo(&bench_ctx.radio, 1));
+			break;
+		case BENCH_DSHOT:
+			BENCH_ROUND(dshot_encode(&bench_in.motor[i], bench_ctx.dshot));
+			break;
+		case BENCH_PID_MIXER: // The state is carried from call to call
+			BENCH_ROUND(pid_update(&bench_ctx.pid, bench_in.pid[i].setpoint, bench_in.pid[i].measure, 0);
+				mixer_run(&mixer_table[AIRFRAME], bench_ctx.pid.out, bench_in.pid[i].throttle,
+					(float)REG_MOTOR__START - (float)REG_MOTOR__ARMED, (float)MOTOR_MAX - (float)REG_MOTOR__ARMED,
+					1, bench_ctx.motor, &bench_ctx.pid.sat_high, &bench_ctx.pid.sat_low));
+			break;
+		case BENCH_REG_WRITE:
+			BENCH_ROUND(reg_access(&bench_ctx.cmd));
+			break;
+		default:
+			BENCH_ROUND(reg_update_on_read());
+			break;
+	}
+	bench_add(bench_item, t, bench_round);
+	
+	bench_round++;
+	if (bench_round == BENCH_ROUNDS) {
+		bench_round = 0;
+		bench_item++;
+	}
+	
+	return bench_item < NB_BENCH;
+}
+
+// Run all the benchmarks at once (SIL build)
+void bench_run(void)
+{
+	bench_start();
+	while (bench_step()) {}
+}
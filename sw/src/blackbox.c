@@ -0,0 +1,255 @@
+#include "blackbox.h"
+#include "board.h" // spi_flash_*, host_send
+#include "utils.h" // varint_encode, crc16
+
+/* Private defines ------------------------------------*/
+
+#define BLACKBOX_MASK (BLACKBOX_BUFFER_SIZE - 1)
+#define BLACKBOX_RECORD_MAX (1 + 5 * (BLACKBOX_NB_FIELD + 1)) // Type and varints of 5 bytes at most
+
+/* Private macros ------------------------------------------*/
+
+// Setpoint and I terms are smooth, they are predicted by a straight line through the last two values
+// The other fields are predicted by their last value
+#define BLACKBOX_LINEAR(i) ((((i) >= 3) && ((i) < 6)) || (((i) >= 9) && ((i) < 12)))
+
+/* Private functions ------------------------------------------------*/
+
+void blackbox_put(uint8_t * data, uint16_t size);
+
+/* Global variables --------------------------------------*/
+
+uint32_t blackbox_used; // Bytes programmed in flash, whole pages
+uint16_t blackbox_dropped; // Records lost because the RAM ring was full
+
+uint8_t blackbox_ring[BLACKBOX_BUFFER_SIZE];
+volatile uint16_t blackbox_head; // Written by the control task
+volatile uint16_t blackbox_tail; // Written by blackbox_service
+uint8_t blackbox_page[SPI_FLASH_CMD_SIZE + BLACKBOX_PAGE_SIZE];
+uint8_t blackbox_dump_tx[1 + BLACKBOX_DUMP_SIZE + 2]; // Dump answer (status, data, CRC), kept until sent
+
+volatile _Bool blackbox_on; // Session in progress
+volatile _Bool blackbox_flush; // Program the last partial page of the session
+_Bool blackbox_erase_request; // Erase started by blackbox_service once the flash is idle
+_Bool blackbox_erasing;
+uint8_t blackbox_key_count;
+uint32_t blackbox_period;
+uint32_t blackbox_time;
+int32_t blackbox_x1[BLACKBOX_NB_FIELD]; // Last value of the fields
+int32_t blackbox_x2[BLACKBOX_NB_FIELD]; // Value before
+
+/* Function definitions ----------------------------------*/
+
+// Find the end of the log: the pages are programmed in order, the first erased page follows the last session
+// A page can start in the middle of a record with a 0xFF byte, a page is only erased if all its bytes are 0xFF
+// (a programmed page holds at least one record type byte or the start of the session)
+void blackbox_init(void)
+{
+	uint32_t low = 0;
+	uint32_t high = BLACKBOX_SIZE / BLACKBOX_PAGE_SIZE;
+	uint32_t mid;
+	uint8_t * page = &blackbox_page[SPI_FLASH_CMD_SIZE];
+	int i;
+	
+	blackbox_head = 0;
+	blackbox_tail = 0;
+	blackbox_on = 0;
+	blackbox_flush = 0;
+	blackbox_erase_request = 0;
+	blackbox_erasing = 0;
+	blackbox_dropped = 0;
+	
+	while (low < high) {
+		mid = (low + high) / 2;
+		spi_flash_read(mid * BLACKBOX_PAGE_SIZE, page, BLACKBOX_PAGE_SIZE);
+		for (i=0; (i<BLACKBOX_PAGE_SIZE) && (page[i] == 0xFF); i++);
+		if (i == BLACKBOX_PAGE_SIZE)
+			high = mid;
+		else
+			low = mid + 1;
+	}
+	blackbox_used = low * BLACKBOX_PAGE_SIZE;
+}
+
+// Start a session, period of the records in us
+// Called at each record while armed, it waits for the end of the previous session and stops when the flash is full
+void blackbox_start(uint32_t period)
+{
+	uint8_t header[3 + 5];
+	uint8_t n;
+	
+	if (blackbox_on || blackbox_flush || blackbox_erase_request || blackbox_erasing || (blackbox_used + BLACKBOX_PAGE_SIZE > BLACKBOX_SIZE))
+		return;
+	
+	header[0] = BLACKBOX_HEADER;
+	header[1] = BLACKBOX_VERSION;
+	header[2] = BLACKBOX_NB_FIELD;
+	n = 3 + varint_encode(&header[3], period);
+	blackbox_put(header, n);
+	
+	blackbox_period = period;
+	blackbox_key_count = 0;
+	blackbox_on = 1;
+}
+
+void blackbox_stop(void)
+{
+	if (!blackbox_on)
+		return;
+	
+	blackbox_on = 0;
+	blackbox_flush = 1;
+}
+
+// Encode one record in the RAM ring, called by the control task
+void blackbox_log(uint32_t time, const int32_t field[BLACKBOX_NB_FIELD])
+{
+	int i;
+	uint8_t record[BLACKBOX_RECORD_MAX];
+	uint16_t n;
+	int32_t prediction;
+	
+	if (!blackbox_on)
+		return;
+	
+	// Drop the record if it may not fit, the next one is a keyframe
+	if (BLACKBOX_BUFFER_SIZE - 1 - ((blackbox_head - blackbox_tail) & BLACKBOX_MASK) < BLACKBOX_RECORD_MAX) {
+		blackbox_dropped++;
+		blackbox_key_count = 0;
+		return;
+	}
+	
+	if (blackbox_key_count == 0) {
+		record[0] = BLACKBOX_KEYFRAME;
+		n = 1 + varint_encode(&record[1], time);
+		for (i=0; i<BLACKBOX_NB_FIELD; i++) {
+			n += varint_encode(&record[n], zigzag_encode(field[i]));
+			blackbox_x1[i] = field[i];
+			blackbox_x2[i] = field[i];
+		}
+	}
+	else {
+		// The time step is predicted by the period
+		record[0] = BLACKBOX_DELTA;
+		n = 1 + varint_encode(&record[1], zigzag_encode((int32_t)(time - blackbox_time - blackbox_period)));
+		for (i=0; i<BLACKBOX_NB_FIELD; i++) {
+			if (BLACKBOX_LINEAR(i))
+				prediction = 2 * blackbox_x1[i] - blackbox_x2[i];
+			else
+				prediction = blackbox_x1[i];
+			n += varint_encode(&record[n], zigzag_encode(field[i] - prediction));
+			blackbox_x2[i] = blackbox_x1[i];
+			blackbox_x1[i] = field[i];
+		}
+	}
+	blackbox_time = time;
+	
+	blackbox_key_count++;
+	if (blackbox_key_count == BLACKBOX_KEYFRAME_PERIOD)
+		blackbox_key_count = 0;
+	
+	blackbox_put(record, n);
+}
+
+void blackbox_put(uint8_t * data, uint16_t size)
+{
+	int i;
+	uint16_t head;
+	
+	head = blackbox_head;
+	for (i=0; i<size; i++) {
+		blackbox_ring[head] = data[i];
+		head = (head + 1) & BLACKBOX_MASK;
+	}
+	blackbox_head = head;
+}
+
+// Return 1 if blackbox_service has a page to program
+_Bool blackbox_pending(void)
+{
+	return blackbox_flush || (((blackbox_head - blackbox_tail) & BLACKBOX_MASK) >= BLACKBOX_PAGE_SIZE) || blackbox_erase_request || blackbox_erasing;
+}
+
+// Program the next page if the flash is ready, called in idle time
+void blackbox_service(void)
+{
+	int i;
+	uint16_t tail;
+	uint16_t size;
+	
+	if (spi_flash_busy())
+		return;
+	
+	// The flash ignores the erase while a page is programmed
+	if (blackbox_erase_request) {
+		blackbox_erase_request = 0;
+		spi_flash_erase();
+		blackbox_erasing = 1;
+		return;
+	}
+	
+	if (blackbox_erasing) {
+		blackbox_erasing = 0;
+		blackbox_used = 0;
+		return;
+	}
+	
+	size = (blackbox_head - blackbox_tail) & BLACKBOX_MASK;
+	if (size >= BLACKBOX_PAGE_SIZE)
+		size = BLACKBOX_PAGE_SIZE;
+	else if ((size == 0) || !blackbox_flush) {
+		blackbox_flush = 0;
+		return;
+	}
+	
+	// Flash full, end of the session
+	if (blackbox_used + BLACKBOX_PAGE_SIZE > BLACKBOX_SIZE) {
+		blackbox_on = 0;
+		blackbox_flush = 0;
+		blackbox_tail = blackbox_head;
+		return;
+	}
+	
+	// The last page of a session is padded with 0xFF, the next session starts on a page boundary
+	tail = blackbox_tail;
+	for (i=0; i<size; i++) {
+		blackbox_page[SPI_FLASH_CMD_SIZE + i] = blackbox_ring[tail];
+		tail = (tail + 1) & BLACKBOX_MASK;
+	}
+	for (; i<BLACKBOX_PAGE_SIZE; i++)
+		blackbox_page[SPI_FLASH_CMD_SIZE + i] = 0xFF;
+	blackbox_tail = tail;
+	
+	spi_flash_program(blackbox_used, blackbox_page, BLACKBOX_PAGE_SIZE);
+	blackbox_used += BLACKBOX_PAGE_SIZE;
+}
+
+// Erase the whole log, only between sessions
+// The last page of the session may still be programmed (DMA or flash busy), the erase is started by blackbox_service
+void blackbox_erase(void)
+{
+	if (blackbox_on || blackbox_erase_request || blackbox_erasing)
+		return;
+	
+	blackbox_flush = 0;
+	blackbox_tail = blackbox_head;
+	blackbox_erase_request = 1;
+}
+
+// Send BLACKBOX_DUMP_SIZE bytes of the log from addr, with a status byte (0 = done, 1 = busy) and a CRC
+void blackbox_dump(uint32_t addr)
+{
+	uint16_t crc;
+	
+	if (blackbox_on || blackbox_erase_request || blackbox_erasing || spi_flash_busy() || (addr + BLACKBOX_DUMP_SIZE > BLACKBOX_SIZE))
+		blackbox_dump_tx[0] = 1;
+	else {
+		blackbox_dump_tx[0] = 0;
+		spi_flash_read(addr, &blackbox_dump_tx[1], BLACKBOX_DUMP_SIZE);
+	}
+	
+	crc = crc16(blackbox_dump_tx, 1 + BLACKBOX_DUMP_SIZE);
+	blackbox_dump_tx[1 + BLACKBOX_DUMP_SIZE] = (uint8_t)crc;
+	blackbox_dump_tx[2 + BLACKBOX_DUMP_SIZE] = (uint8_t)(crc >> 8);
+	host_send(blackbox_dump_tx, 3 + BLACKBOX_DUMP_SIZE);
+}
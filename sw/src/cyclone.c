@@ -3,10 +3,13 @@
 #include "radio.h"
 #include "sensor.h"
 #include "usb.h"
+#include "latency.h"
 
 /* Private defines ------------------------------------*/
 
 #define ADC_SCALE 0.0089f
+#define APB1_CLOCK (SystemCoreClock / 2)
+#define TIMER_CLOCK SystemCoreClock // APB1 timers (x2) and APB2 timers
 
 /* Private macros ------------------------------------------*/
 
@@ -21,6 +24,26 @@ volatile uint32_t motor2_dshot[17];
 volatile uint32_t motor3_dshot[17];
 volatile uint32_t motor4_dshot[17];
 
+// Sorted by class, sub-priority only orders pending interrupts of the same class
+const irq_priority_t irq_priority[] =
+{
+	// IRQ, preemption priority, sub-priority
+	{EXTI15_10_IRQn,       IRQ_PRIO_SENSOR, 1},
+	{SPI2_IRQn,            IRQ_PRIO_SENSOR, 2},
+	{DMA1_Channel4_IRQn,   IRQ_PRIO_SENSOR, 0},
+	{DMA1_Channel5_IRQn,   IRQ_PRIO_SENSOR, 2},
+	{DMA1_Channel7_IRQn,   IRQ_PRIO_SENSOR, 3},
+	{USART2_IRQn,          IRQ_PRIO_RADIO,  1},
+	{DMA1_Channel6_IRQn,   IRQ_PRIO_RADIO,  0},
+	{TIM1_BRK_TIM15_IRQn,  IRQ_PRIO_TIMER,  0},
+	{TIM6_DAC_IRQn,        IRQ_PRIO_TIMER,  1},
+	{TIM1_UP_TIM16_IRQn,   IRQ_PRIO_TIMER,  2},
+	{TIM4_IRQn,            IRQ_PRIO_TIMER,  3},
+	{USB_LP_CAN_RX0_IRQn,  IRQ_PRIO_HOST,   0}
+};
+
+#define NB_IRQ (sizeof(irq_priority) / sizeof(irq_priority_t))
+
 /* Functions ------------------------------------------------*/
 
 void sensor_write(uint8_t addr, uint8_t data)
@@ -54,6 +77,26 @@ void rf_read(uint8_t addr, uint8_t size)
 	
 }
 
+void spi_flash_read(uint32_t addr, uint8_t * data, uint16_t size)
+{
+	
+}
+
+void spi_flash_program(uint32_t addr, uint8_t * buf, uint16_t size)
+{
+	
+}
+
+void spi_flash_erase(void)
+{
+	
+}
+
+_Bool spi_flash_busy(void)
+{
+	return 0;
+}
+
 void radio_error_recover()
 {
 	// Disable DMA UART
@@ -87,7 +130,7 @@ __forceinline void sensor_error_recover()
 	sensor_error_count++;
 }
 
-void set_motors(uint32_t * motor_raw)
+FAST_CODE void set_motors(uint32_t * motor_raw)
 {
 	#if (ESC == DSHOT)
 		dshot_encode(&motor_raw[0], motor1_dshot);
@@ -113,10 +156,10 @@ void set_motors(uint32_t * motor_raw)
 		DMA1_Channel7->CCR |= DMA_CCR_EN;
 		TIM2->CR1 |= TIM_CR1_CEN;
 	#else
-		TIM2->CCR2 = SERVO_MAX*2 + 1 - SERVO_MIN*2 - motor_raw[0];
-		TIM2->CCR3 = SERVO_MAX*2 + 1 - SERVO_MIN*2 - motor_raw[1];
-		TIM3->CCR3 = SERVO_MAX*2 + 1 - SERVO_MIN*2 - motor_raw[2];
-		TIM3->CCR4 = SERVO_MAX*2 + 1 - SERVO_MIN*2 - motor_raw[3];
+		TIM2->CCR2 = ONESHOT_COUNT(SERVO_MAX*2 + 1 - SERVO_MIN*2 - motor_raw[0], TIMER_CLOCK);
+		TIM2->CCR3 = ONESHOT_COUNT(SERVO_MAX*2 + 1 - SERVO_MIN*2 - motor_raw[1], TIMER_CLOCK);
+		TIM3->CCR3 = ONESHOT_COUNT(SERVO_MAX*2 + 1 - SERVO_MIN*2 - motor_raw[2], TIMER_CLOCK);
+		TIM3->CCR4 = ONESHOT_COUNT(SERVO_MAX*2 + 1 - SERVO_MIN*2 - motor_raw[3], TIMER_CLOCK);
 		TIM2->CR1 |= TIM_CR1_CEN;
 		TIM3->CR1 |= TIM_CR1_CEN;
 	#endif
@@ -137,11 +180,12 @@ void set_mpu_host(_Bool host)
 	if (host) {
 		DMA1_Channel4->CMAR = (uint32_t)spi2_rx_buffer;
 		SPI2->CR1 &= ~SPI_CR1_BR_Msk;
-		SPI2->CR1 |= 4 << SPI_CR1_BR_Pos; // 700kHz
+		SPI2->CR1 |= spi_br(APB1_CLOCK, MPU_SPI_CLOCK_REG) << SPI_CR1_BR_Pos; // 750kHz at 48MHz
 	}
 	else {
 		DMA1_Channel4->CMAR = (uint32_t)&sensor_raw;
-		SPI2->CR1 &= ~SPI_CR1_BR_Msk; // 12MHz
+		SPI2->CR1 &= ~SPI_CR1_BR_Msk;
+		SPI2->CR1 |= spi_br(APB1_CLOCK, MPU_SPI_CLOCK_DATA) << SPI_CR1_BR_Pos; // 12MHz at 48MHz
 	}
 }
 
@@ -161,8 +205,8 @@ void reset_timeout_radio()
 
 void host_send(uint8_t * data, uint8_t size)
 {
-	USBD_CDC_SetTxBuffer(&USBD_device_handler, data, size);
-	USBD_CDC_TransmitPacket(&USBD_device_handler);
+	if (usb_send(data, size))
+		NVIC_SetPendingIRQ(USB_LP_CAN_RX0_IRQn); // Start the transfer from the USB interrupt if it is idle
 }
 
 uint16_t get_timer_process(void)
@@ -178,6 +222,7 @@ uint16_t get_timer_process(void)
 void EXTI15_10_IRQHandler() 
 {
 	EXTI->PR = EXTI_PR_PIF15; // Clear pending request
+	latency_stamp(LATENCY_DATA_READY);
 	if ((REG_CTRL__SENSOR_HOST_CTRL == 0) && ((SPI2->SR & SPI_SR_BSY) == 0)) {
 		sensor_read(59,14);
 		timer_sensor[0] = TIM7->CNT; // SPI transaction time
@@ -210,7 +255,8 @@ void DMA1_Channel4_IRQHandler()
 		}
 		else {
 			TIM15->CNT = 0; // Reset timeout
-			flag_sensor = 1; // Raise flag for sample ready
+			latency_stamp(LATENCY_SENSOR_DONE);
+			sensor_ready(); // Raise flag or run control task
 		}
 	}
 	
@@ -225,6 +271,14 @@ void DMA1_Channel5_IRQHandler()
 	sensor_error_recover();
 }
 
+/* End of DShot DMA ---------------------------*/
+
+void DMA1_Channel7_IRQHandler()
+{
+	DMA1->IFCR = DMA_IFCR_CGIF7;
+	latency_stamp(LATENCY_DSHOT);
+}
+
 /* Radio UART error ------------------------------*/
 
 void USART2_IRQHandler()
@@ -306,6 +360,7 @@ void TIM1_UP_TIM16_IRQHandler()
 void USB_LP_CAN_RX0_IRQHandler()
 {
 	HAL_PCD_IRQHandler(&PCD_handler);
+	usb_tx_service();
 }
 
 /* INIT ----------------------------------------------------------------
@@ -313,31 +368,47 @@ void USB_LP_CAN_RX0_IRQHandler()
 
 void board_init()
 {
+	int i;
+	
 	/* RCC --------------------------------------------------------*/
 	
 	// Enable XTAL oscillator
 	RCC->CR |= RCC_CR_HSEON;
 	while ((RCC->CR & RCC_CR_HSERDY) == 0) {}
 	
+#if (SYSCLK == 72000000)
+	// Set PLL at 72MHz = 9 * XTAL
+	RCC->CFGR |= RCC_CFGR_PLLMUL9 | RCC_CFGR_PLLSRC_HSE_PREDIV;
+#else
 	// Set PLL at 48MHz = 6 * XTAL
 	RCC->CFGR |= RCC_CFGR_PLLMUL6 | RCC_CFGR_PLLSRC_HSE_PREDIV;
+#endif
 	RCC->CR |= RCC_CR_PLLON;
 	while ((RCC->CR & RCC_CR_PLLRDY) == 0) {}
 	
 	// Select PLL as system clock
+#if (SYSCLK == 72000000)
+	FLASH->ACR |= 2 << FLASH_ACR_LATENCY_Pos; // Inrease Flash latency!
+#else
 	FLASH->ACR |= 1 << FLASH_ACR_LATENCY_Pos; // Inrease Flash latency!
+#endif
 	RCC->CFGR |= RCC_CFGR_SW_PLL;
 	while ((RCC->CFGR & RCC_CFGR_SWS_PLL) == 0) {}
-	SystemCoreClock = 48000000;
+	SystemCoreClock = SYSCLK;
 	
-	// Set APB1 at 24MHz and USB at 48MHz
+#if (SYSCLK == 72000000)
+	// Set APB1 at 36MHz and USB at 48MHz (PLL / 1.5)
+	RCC->CFGR |= RCC_CFGR_PPRE1_DIV2;
+#else
+	// Set APB1 at 24MHz and USB at 48MHz (PLL / 1)
 	RCC->CFGR |= RCC_CFGR_PPRE1_DIV2 | RCC_CFGR_USBPRE;
-		
+#endif
+	
 	// Select system clock as UART2/3/4/5 clock and as I2C1/2 clock
 	RCC->CFGR3 |= RCC_CFGR3_USART2SW_SYSCLK | RCC_CFGR3_USART3SW_SYSCLK | RCC_CFGR3_UART4SW_SYSCLK | RCC_CFGR3_UART5SW_SYSCLK | RCC_CFGR3_I2C1SW_SYSCLK | RCC_CFGR3_I2C2SW_SYSCLK;;
 	
 	// Configure SysTick to generate interrupt every ms
-	SysTick_Config(48000);
+	SysTick_Config(SystemCoreClock / 1000);
 	
 	/* Clock enable --------------------------------------------------*/
 	
@@ -460,79 +531,80 @@ void board_init()
 	/* Timers --------------------------------------------------------------------------*/
 	
 #if (ESC == DSHOT)
-	// DMA driven timer for DShot600, 24Mhz, 0:15, 1:30, T:40
+	// DMA driven timer for DShot600, 0:37.5%, 1:75%
+	dshot_init(TIMER_CLOCK / DSHOT_RATE);
 	TIM2->PSC = 0;
-	TIM2->ARR = 80;
+	TIM2->ARR = TIMER_CLOCK / DSHOT_RATE;
 	TIM2->DIER = TIM_DIER_CC2DE | TIM_DIER_CC3DE;
 	TIM2->CCER = TIM_CCER_CC2E | TIM_CCER_CC3E;
 	TIM2->CCMR1 = (6 << TIM_CCMR1_OC2M_Pos) | TIM_CCMR1_OC2PE;
 	TIM2->CCMR2 = (6 << TIM_CCMR2_OC3M_Pos) | TIM_CCMR2_OC3PE;
 	
 	TIM3->PSC = 0;
-	TIM3->ARR = 80;
+	TIM3->ARR = TIMER_CLOCK / DSHOT_RATE;
 	TIM3->DIER = TIM_DIER_CC3DE | TIM_DIER_CC4DE;
 	TIM3->CCER = TIM_CCER_CC3E | TIM_CCER_CC4E;
 	TIM3->CCMR2 = (6 << TIM_CCMR2_OC3M_Pos) | (6 << TIM_CCMR2_OC4M_Pos) | TIM_CCMR2_OC3PE | TIM_CCMR2_OC4PE;
 #else	
 	// One-pulse mode for OneShot125
 	TIM2->CR1 = TIM_CR1_OPM;
-	TIM2->PSC = 3-1;
-	TIM2->ARR = SERVO_MAX*2 + 1;
+	TIM2->PSC = 0;
+	TIM2->ARR = ONESHOT_COUNT(SERVO_MAX*2 + 1, TIMER_CLOCK);
 	TIM2->CCER = TIM_CCER_CC2E | TIM_CCER_CC3E;
 	TIM2->CCMR1 = (7 << TIM_CCMR1_OC2M_Pos);
 	TIM2->CCMR2 = (7 << TIM_CCMR2_OC3M_Pos);
 	
 	TIM3->CR1 = TIM_CR1_OPM;
-	TIM3->PSC = 3-1;
-	TIM3->ARR = SERVO_MAX*2 + 1;;
+	TIM3->PSC = 0;
+	TIM3->ARR = ONESHOT_COUNT(SERVO_MAX*2 + 1, TIMER_CLOCK);
 	TIM3->CCER = TIM_CCER_CC3E | TIM_CCER_CC4E;
 	TIM3->CCMR2 = (7 << TIM_CCMR2_OC3M_Pos) | (7 << TIM_CCMR2_OC4M_Pos);
 #endif
 
 	// Beeper
-	TIM4->PSC = 48000-1; // 1ms
-	TIM4->ARR = BEEPER_PERIOD;
+	TIM4->PSC = TIMER_PSC_100US(TIMER_CLOCK);
+	TIM4->ARR = BEEPER_PERIOD*10; // ms
 	TIM4->DIER = TIM_DIER_UIE;
 	TIM4->CR1 = TIM_CR1_CEN;
 	
 	// Receiver timeout
-	TIM6->PSC = 48000-1; // 1ms
-	TIM6->ARR = TIMEOUT_RADIO;
+	TIM6->PSC = TIMER_PSC_100US(TIMER_CLOCK);
+	TIM6->ARR = TIMEOUT_RADIO*10; // ms
 	TIM6->DIER = TIM_DIER_UIE;
 	TIM6->CR1 = TIM_CR1_CEN;
 	
 	// Processing time
-	TIM7->PSC = 48-1; // 1us
+	TIM7->PSC = TIMER_PSC_US(TIMER_CLOCK);
 	TIM7->ARR = 65535;
 	TIM7->CR1 = TIM_CR1_CEN;
 	
 	// MPU timeout
-	TIM15->PSC = 48-1; // 1us
+	TIM15->PSC = TIMER_PSC_US(TIMER_CLOCK);
 	TIM15->ARR = TIMEOUT_SENSOR;
 	TIM15->DIER = TIM_DIER_UIE;
 	TIM15->CR1 = TIM_CR1_CEN;
 	
 	// VBAT
-	TIM16->PSC = 48000-1; // 1ms
-	TIM16->ARR = VBAT_PERIOD;
+	TIM16->PSC = TIMER_PSC_100US(TIMER_CLOCK);
+	TIM16->ARR = VBAT_PERIOD*10; // ms
 	TIM16->DIER = TIM_DIER_UIE;
 	TIM16->CR1 = TIM_CR1_CEN;
 	
 	/* UART ---------------------------------------------------*/
 	
 #if (RADIO_TYPE == 2)
-	USART2->BRR = 480; // 48MHz/100000bps
+	USART2->BRR = SystemCoreClock / 100000; // 100000bps
 	USART2->CR1 = USART_CR1_UE | USART_CR1_M0 | USART_CR1_PCE;
 	USART2->CR2 = (2 << USART_CR2_STOP_Pos) | USART_CR2_RXINV;
 #else
-	USART2->BRR = 417; // 48MHz/115200bps
+	USART2->BRR = SystemCoreClock / 115200; // 115200bps
 	USART2->CR1 = USART_CR1_UE;
 #endif
 	USART2->CR3 = USART_CR3_EIE;
 	
 	/* SPI ----------------------------------------------------*/
 	
-	SPI2->CR1 = SPI_CR1_MSTR | (4 << SPI_CR1_BR_Pos) | SPI_CR1_CPOL | SPI_CR1_CPHA; // SPI clock = clock APB1/32 = 24MHz/32 = 700 kHz
+	SPI2->CR1 = SPI_CR1_MSTR | (spi_br(APB1_CLOCK, MPU_SPI_CLOCK_REG) << SPI_CR1_BR_Pos) | SPI_CR1_CPOL | SPI_CR1_CPHA; // SPI clock < 1MHz, APB1/32 = 750 kHz at 48MHz
 	SPI2->CR2 = SPI_CR2_SSOE | SPI_CR2_TXDMAEN | SPI_CR2_RXDMAEN | SPI_CR2_FRXTH | SPI_CR2_ERRIE;
 	
 	/* ADC -----------------------------------------------------*/
@@ -563,29 +635,11 @@ void board_init()
 	EXTI->RTSR |= EXTI_RTSR_TR15;
 	//EXTI->IMR = EXTI_IMR_MR15; // To be enabled after MPU init
 	
-	NVIC_EnableIRQ(EXTI15_10_IRQn);
-	NVIC_EnableIRQ(USART2_IRQn);
-	NVIC_EnableIRQ(SPI2_IRQn);
-	NVIC_EnableIRQ(DMA1_Channel4_IRQn);
-	NVIC_EnableIRQ(DMA1_Channel5_IRQn);
-	NVIC_EnableIRQ(DMA1_Channel6_IRQn);
-	NVIC_EnableIRQ(TIM4_IRQn);
-	NVIC_EnableIRQ(TIM6_DAC_IRQn);
-	NVIC_EnableIRQ(TIM1_BRK_TIM15_IRQn);
-	NVIC_EnableIRQ(TIM1_UP_TIM16_IRQn);
-	NVIC_EnableIRQ(USB_LP_CAN_RX0_IRQn);
-	
-	NVIC_SetPriority(EXTI15_10_IRQn,0);
-	NVIC_SetPriority(USART2_IRQn,0);
-	NVIC_SetPriority(SPI2_IRQn,0);
-	NVIC_SetPriority(DMA1_Channel4_IRQn,0);
-	NVIC_SetPriority(DMA1_Channel5_IRQn,0);
-	NVIC_SetPriority(DMA1_Channel6_IRQn,0);
-	NVIC_SetPriority(TIM4_IRQn,0);
-	NVIC_SetPriority(TIM6_DAC_IRQn,0);
-	NVIC_SetPriority(TIM1_BRK_TIM15_IRQn,0);
-	NVIC_SetPriority(TIM1_UP_TIM16_IRQn,0);
-	NVIC_SetPriority(USB_LP_CAN_RX0_IRQn,16);
+	NVIC_SetPriorityGrouping(IRQ_PRIORITY_GROUP);
+	for (i=0; i<NB_IRQ; i++) {
+		NVIC_SetPriority(irq_priority[i].irq, NVIC_EncodePriority(IRQ_PRIORITY_GROUP, irq_priority[i].preempt, irq_priority[i].sub));
+		NVIC_EnableIRQ(irq_priority[i].irq);
+	}
 
 	/* Host init -------------------------------------------*/
 	
@@ -5,17 +5,69 @@
 #include "sensor.h"
 #include "radio.h"
 #include "reg.h"
+#include "fc_sched.h"
+#include "pid.h"
+#include "mixer.h"
+#include "telemetry.h"
+#include "blackbox.h"
+#include "latency.h"
 
 /* Private defines ------------------------------------*/
 
 #define I_MAX 300.0f
 #define PID_MAX 600.0f
 #define RECOVERY_TIME 3000 // ms
+#define TPA_SCALE_MIN 0.1f
+#define RADIO_PERIOD_MIN 3000 // us, frame periods outside are not measured (lost frames)
+#define RADIO_PERIOD_MAX 20000 // us
+#define RADIO_PERIOD_ALPHA 0.1f // Filter of the measured frame period, against the jitter of the scheduler
+#define VBAT_SCALE_MIN 0.75f
+#define VBAT_SCALE_MAX 1.5f
+#if (AIRFRAME == TRI)
+	#define SERVO_OUTPUT 0 // Tail servo on the first output
+	#define MOTOR_OUTPUT 1
+	#define OUTPUT_OFF(i) (((i) == SERVO_OUTPUT) ? (uint32_t)REG_MIXER__SERVO_CENTER : 0) // Servo centred when disarmed
+#else
+	#define MOTOR_OUTPUT 0
+	#define OUTPUT_OFF(i) 0
+#endif
+
+#if (MOTOR_OUTPUT + MIXER_NB_MOTOR(AIRFRAME) > NB_OUTPUT)
+	#error "Not enough motor outputs on this board for AIRFRAME"
+#endif
+#if (AIRFRAME == TRI) && (ESC != ONESHOT)
+	#error "The tricopter servo needs ONESHOT outputs"
+#endif
+#if (AIRFRAME == TRI) && !defined(SERVO_DIVIDER)
+	#error "The tricopter servo needs its own timer on this board (SERVO_DIVIDER)"
+#endif
 
 /* Private macros ------------------------------------------*/
 
+// Protect data shared with the control task when it runs in the sensor interrupt
+#if (CONTROL_LOOP == SENSOR_ISR)
+	#define ENTER_CRITICAL() __disable_irq()
+	#define EXIT_CRITICAL() __enable_irq()
+#else
+	#define ENTER_CRITICAL()
+	#define EXIT_CRITICAL()
+#endif
+
 /* Private types --------------------------------------*/
 
+/* Private functions ------------------------------------------------*/
+
+void pid_load(void);
+void gain_scale_update(void);
+_Bool task_sensor(void);
+_Bool task_timeout_sensor(void);
+_Bool task_timeout_radio(void);
+_Bool task_radio(void);
+_Bool task_vbat(void);
+_Bool task_host(void);
+void blackbox_record(void);
+_Bool task_blackbox(void);
+
 /* Global variables --------------------------------------*/
 
 sensor_raw_t sensor_raw;
@@ -26,10 +78,12 @@ volatile uint8_t radio_error_count;
 volatile uint8_t rf_error_count;
 
 volatile _Bool flag_sensor;
+volatile _Bool flag_control;
 volatile _Bool flag_radio;
 volatile _Bool flag_vbat;
 volatile _Bool flag_rf;
 volatile _Bool flag_host;
+volatile _Bool flag_blackbox;
 volatile _Bool flag_sensor_host_read;
 volatile _Bool flag_rf_host_read;
 volatile _Bool flag_timeout_sensor;
@@ -37,6 +91,7 @@ volatile _Bool flag_timeout_radio;
 volatile _Bool flag_armed;
 volatile _Bool flag_acro;
 volatile _Bool flag_rf_rxtx_done;
+volatile _Bool flag_pid_update;
 volatile _Bool flag_rf_host_read;
 
 volatile _Bool flag_beep_user;
@@ -50,75 +105,101 @@ host_buffer_rx_t host_buffer_rx;
 uint16_t timer_sensor[2];
 uint16_t time_sensor;
 uint16_t time_process;
+uint16_t timer_sensor_z;
+uint16_t sensor_period_min;
+uint16_t sensor_period_max;
+uint32_t sensor_time; // us, time of the last sensor sample (telemetry time base)
+
+uint16_t sensor_sample_count;
+FAST_DATA struct sensor_s sensor;
+FAST_DATA struct angle_s angle;
+
+uint16_t radio_frame_count;
+struct radio_raw_s radio_raw;
+FAST_DATA struct radio_s radio;
+struct radio_s radio_rx;
+FAST_DATA float radio_pitch_smooth;
+FAST_DATA float radio_roll_smooth;
+
+FAST_DATA struct pid_s pid;
+FAST_DATA float setpoint[NB_AXIS];
+FAST_DATA float measure[NB_AXIS];
+float tpa_scale;
+float vbat_scale;
+
+float stick_z[NB_AXIS];
+uint16_t radio_time_z; // get_timer_process of the previous frame
+_Bool radio_time_valid; // radio_time_z is the previous frame
+float radio_period; // us between frames, measured (IBUS 7ms, SUMD 10ms, SBUS 9 to 14ms)
+FAST_DATA float ff_step[NB_AXIS];
+FAST_DATA uint8_t ff_count;
+
+FAST_DATA float motor[MIXER_MAX_MOTOR];
+FAST_DATA int32_t motor_clip[NB_OUTPUT];
+FAST_DATA uint32_t motor_raw[NB_OUTPUT];
+
+uint16_t vbat_sample_count;
+
+_Bool flag_acro_z;
+uint16_t sensor_sample_count1;
+
+struct telemetry_s telemetry_sensor;
+struct telemetry_s telemetry_radio;
+struct telemetry_s telemetry_vbat;
+
+// Sorted by priority, the control task must be the first one
+// With CONTROL_LOOP == SENSOR_ISR, the control task runs in the sensor interrupt instead
+task_t task[] =
+{
+	// run, release flag, deadline (us), budget (us), ready, release
+#if (CONTROL_LOOP == MAIN_LOOP)
+	{task_sensor,         &flag_sensor,         SENSOR_PERIOD,    500, 0, 0},
+#endif
+	{task_timeout_sensor, &flag_timeout_sensor, SENSOR_PERIOD,    50,  0, 0},
+	{task_timeout_radio,  &flag_timeout_radio,  SENSOR_PERIOD,    50,  0, 0},
+	{task_radio,          &flag_radio,          RADIO_PERIOD,     300, 0, 0},
+	{task_vbat,           &flag_vbat,           VBAT_PERIOD*1000, 100, 0, 0},
+	{task_host,           &flag_host,           HOST_DEADLINE,    200, 0, 0},
+#if (BLACKBOX_SIZE > 0)
+	{task_blackbox,       &flag_blackbox,       HOST_DEADLINE,    100, 0, 0}
+#endif
+};
+
+#define NB_TASK (sizeof(task) / sizeof(task_t))
 
 /* Functions ------------------------------------------------*/
 
 /* MAIN ----------------------------------------------------------------
 -----------------------------------------------------------------------*/
 
+// The SIL build (sil.c) calls fc_init and fc_run itself
+#ifndef SIL
 int main(void)
 {
-	int i;
-	
-	uint16_t sensor_sample_count;
-	struct sensor_s sensor;
-	struct angle_s angle;
-	
-	uint16_t radio_frame_count;
-	struct radio_raw_s radio_raw;
-	struct radio_s radio;
-	float radio_pitch_smooth;
-	float radio_roll_smooth;
-	
-	float error_pitch;
-	float error_roll;
-	float error_yaw;
-	float error_pitch_z;
-	float error_roll_z;
-	float error_yaw_z;
-	
-	float p_pitch;
-	float i_pitch;
-	float d_pitch;
-	float p_roll;
-	float i_roll;
-	float d_roll;
-	
-	float pitch_p_term;
-	float pitch_i_term;
-	float pitch_d_term;
-	float roll_p_term;
-	float roll_i_term;
-	float roll_d_term;
-	float yaw_p_term;
-	float yaw_i_term;
-	float yaw_d_term;
-	
-	float pitch;
-	float roll;
-	float yaw;
-	
-	float motor[4];
-	int32_t motor_clip[4];
-	uint32_t motor_raw[4];
-	
-	uint16_t vbat_sample_count;
-	
-	int32_t t1;
-	int32_t t2;
-	_Bool flag_acro_z;
-	_Bool error;
-	uint16_t sensor_sample_count1;
-	
-	host_buffer_tx_t host_buffer_tx;
+	fc_init();
 	
+	while (1)
+	{
+		// Wait for interrupts if no task can run
+		if (!fc_run())
+			__wfi();
+	}
+}
+#endif
+
+/* Initialisation -----------------------------------------------------------------------*/
+
+void fc_init(void)
+{
 	/* Variable initialisation -----------------------------------------------------*/
 	
 	flag_sensor = 0;
+	flag_control = 0;
 	flag_radio = 0;
 	flag_vbat = 0;
 	flag_rf = 0;
 	flag_host = 0;
+	flag_blackbox = 0;
 	flag_sensor_host_read = 0;
 	flag_rf_host_read = 0;
 	flag_timeout_sensor = 0;
@@ -126,7 +207,7 @@ int main(void)
 	flag_armed = 0;
 	flag_acro = 1;
 	flag_acro_z = 0;
-
+	
 	flag_beep_user = 0;
 	flag_beep_radio = 0;
 	flag_beep_sensor = 0;
@@ -143,9 +224,13 @@ int main(void)
 	radio_pitch_smooth = 0;
 	radio_roll_smooth = 0;
 	
-	pitch_i_term = 0;
-	roll_i_term = 0;
-	yaw_i_term = 0;
+	pid_init(&pid, I_MAX, PID_MAX);
+	flag_pid_update = 1;
+	tpa_scale = 1.0f;
+	vbat_scale = 1.0f;
+	ff_count = 0;
+	radio_time_valid = 0;
+	radio_period = (float)RADIO_PERIOD;
 	
 	vbat_sample_count = 0;
 	
@@ -153,293 +238,528 @@ int main(void)
 	
 	sensor_sample_count1 = 0;
 	
+	sched_missed = 0;
+	sched_overrun = 0;
+	
+	timer_sensor_z = 0;
+	sensor_period_min = 0;
+	sensor_period_max = 0;
+	sensor_time = 0;
+	
 	/* Setup -----------------------------------------------------*/
 	
 	board_init(); // BOARD_DEPENDENT
+	CLOCK_TICKS_START(); // Benchmarks and latency trace
 	SysTick->CTRL &= ~SysTick_CTRL_TICKINT_Msk; // Disable Systick interrupt, not needed anymore (but can still use COUNTFLAG)
 	reg_init();
+#if (BLACKBOX_SIZE > 0)
+	blackbox_init();
+#endif
+	flag_control = 1; // Registers are valid, the control task can run
+}
+
+/* Loop ----------------------------------------------------------------------------*/
+
+// Run one slice of the most urgent task, return 0 if no task can run
+_Bool fc_run(void)
+{
+	int32_t t1;
+	_Bool busy;
 	
-	/* Loop ----------------------------------------------------------------------------
-	-----------------------------------------------------------------------------------*/
+	// Processing time
+	t1 = (int32_t)get_timer_process();
 	
-	while (1)
+	busy = sched_run(task, NB_TASK);
+	
+#if (CONTROL_LOOP == MAIN_LOOP)
+	// Record processing time
+	t1 = (int32_t)get_timer_process() - t1;
+	if (t1 < 0)
+		t1 += 0xFFFF;
+	if ((REG_CTRL__TIME_MAXHOLD == 0) || (((uint16_t)t1 > time_process) && REG_CTRL__TIME_MAXHOLD))
+		time_process = (uint16_t)t1;
+#endif
+	
+	return busy;
+}
+
+/* Sensor sample ready, called by the sensor DMA interrupt -----------------------------*/
+
+FAST_CODE void sensor_ready(void)
+{
+	uint16_t period;
+#if (CONTROL_LOOP == SENSOR_ISR)
+	int32_t t1;
+#endif
+	
+	// Sample period seen by the interrupt, its spread is the period jitter of the sensor path
+	period = timer_sensor[0] - timer_sensor_z;
+	timer_sensor_z = timer_sensor[0];
+	sensor_time += period;
+	if ((REG_CTRL__TIME_MAXHOLD == 0) || (period < sensor_period_min))
+		sensor_period_min = period;
+	if ((REG_CTRL__TIME_MAXHOLD == 0) || (period > sensor_period_max))
+		sensor_period_max = period;
+	
+#if (CONTROL_LOOP == SENSOR_ISR)
+	// Registers are not valid yet
+	if (!flag_control)
+		return;
+	
+	// Run PID and mixer right away, the main loop tasks are preempted
+	t1 = (int32_t)get_timer_process();
+	task_sensor();
+	
+	// Record processing time
+	t1 = (int32_t)get_timer_process() - t1;
+	if (t1 < 0)
+		t1 += 0xFFFF;
+	if ((REG_CTRL__TIME_MAXHOLD == 0) || (((uint16_t)t1 > time_process) && REG_CTRL__TIME_MAXHOLD))
+		time_process = (uint16_t)t1;
+#else
+	flag_sensor = 1; // Raise flag for sample ready
+#endif
+}
+
+/* Process sensors -----------------------------------------------------------------------*/
+
+FAST_CODE _Bool task_sensor(void)
+{
+	int i;
+	int32_t t2;
+#if (AIRFRAME == TRI)
+	int32_t servo;
+#endif
+	uint8_t i_reset;
+	
+	latency_stamp(LATENCY_PROCESS);
+	
+	sensor_sample_count++;
+	flag_beep_sensor = 0; // Disable beeping
+	
+	// Record sensor transaction time
+	t2 = (int32_t)timer_sensor[1] - (int32_t)timer_sensor[0];
+	if (t2 < 0)
+		t2 += 0xFFFF;
+	if ((REG_CTRL__TIME_MAXHOLD == 0) || (((uint16_t)t2 > time_sensor) && REG_CTRL__TIME_MAXHOLD))
+		time_sensor = (uint16_t)t2;
+	
+	// Recovery time before activating yaw agnle transfer
+	if (flag_acro != flag_acro_z)
+		sensor_sample_count1 = 0;
+	else if (sensor_sample_count1 < RECOVERY_TIME)
+		sensor_sample_count1++;
+	
+	// Procees sensor data
+	STAGE_BEGIN(STAGE_SENSOR);
+	mpu_process_samples(&sensor_raw, &sensor);
+	STAGE_END(STAGE_SENSOR);
+	
+	// Offset calibration, cancelled when armed
+	if (flag_armed)
+		mpu_cal_stop();
+	else
+		mpu_cal_step(&sensor_raw);
+	
+	// Learn the gyro temperature drift while disarmed
+	if (!flag_armed && REG_GYRO_TC__LEARN)
+		gyro_drift_learn(&sensor_raw, &sensor);
+	
+	// Estimate angle
+	STAGE_BEGIN(STAGE_ANGLE);
+	angle_estimate(&sensor, &angle, (sensor_sample_count1 == RECOVERY_TIME));
+	STAGE_END(STAGE_ANGLE);
+	
+	// Smooth pitch and roll commands in angle mode
+	if (!flag_acro) {
+		radio_pitch_smooth += filter_alpha_radio * radio.pitch - filter_alpha_radio * radio_pitch_smooth;
+		radio_roll_smooth  += filter_alpha_radio * radio.roll  - filter_alpha_radio * radio_roll_smooth;
+	}
+	
+	// Setpoint and measure
+	if (flag_acro) {
+		setpoint[PITCH] = radio.pitch * (float)REG_RATE__PITCH_ROLL;
+		setpoint[ROLL] = radio.roll * (float)REG_RATE__PITCH_ROLL;
+		measure[PITCH] = sensor.gyro_x;
+		measure[ROLL] = sensor.gyro_y;
+	}
+	else {
+		setpoint[PITCH] = radio_pitch_smooth * (float)REG_RATE__ANGLE;
+		setpoint[ROLL] = radio_roll_smooth * (float)REG_RATE__ANGLE;
+		measure[PITCH] = angle.pitch;
+		measure[ROLL] = angle.roll;
+	}
+	setpoint[YAW] = radio.yaw * (float)REG_RATE__YAW;
+	measure[YAW] = sensor.gyro_z;
+	
+	// Stick feedforward, interpolated between radio frames
+	if (ff_count > 0) {
+		ff_count--;
+		for (i=0; i<NB_AXIS; i++)
+			pid.ff[i] += ff_step[i];
+	}
+	
+	// Switch PID coefficients for acro, or new registers
+	if ((flag_acro != flag_acro_z) || flag_pid_update) {
+		flag_pid_update = 0;
+		pid_load();
+	}
+	
+	// P,I and D, reset I when disarmed (and pitch/roll I when switching mode)
+	if (!flag_armed && (REG_CTRL__ARM_TEST == 0))
+		i_reset = (1 << PITCH) | (1 << ROLL) | (1 << YAW);
+	else if (flag_acro != flag_acro_z)
+		i_reset = (1 << PITCH) | (1 << ROLL);
+	else
+		i_reset = 0;
+	STAGE_BEGIN(STAGE_PID);
+	pid_update(&pid, setpoint, measure, i_reset);
+	STAGE_END(STAGE_PID);
+	
+	flag_acro_z = flag_acro;
+	
+	// Desactivate throttle when arm test
+	if (REG_CTRL__ARM_TEST > 0)
+		radio.throttle = 0;
+	
+	// Motor mixer, report the saturated axes to the PID
+	STAGE_BEGIN(STAGE_MIXER);
+	mixer_run(&mixer_table[AIRFRAME], pid.out, radio.throttle * (float)REG_MOTOR__RANGE,
+		(float)REG_MOTOR__START - (float)REG_MOTOR__ARMED, (float)MOTOR_MAX - (float)REG_MOTOR__ARMED,
+		REG_MIXER__AIRMODE, motor, &pid.sat_high, &pid.sat_low);
+	STAGE_END(STAGE_MIXER);
+	
+	// Offset motor value
+	for (i=0; i<MIXER_NB_MOTOR(AIRFRAME); i++)
+		motor_clip[MOTOR_OUTPUT + i] = (int32_t)motor[i] + (int32_t)REG_MOTOR__ARMED;
+	
+#if (AIRFRAME == TRI)
+	// Tail servo
+	servo = (int32_t)(mixer_table[TRI].servo[YAW] * pid.out[YAW]) + (int32_t)REG_MIXER__SERVO_CENTER;
+	if (servo < 0)
+		servo = 0;
+	else if (servo > (int32_t)SERVO_MAX)
+		servo = (int32_t)SERVO_MAX;
+	motor_clip[SERVO_OUTPUT] = servo;
+#endif
+	
+	// Motor command
+	for (i=0; i<NB_OUTPUT; i++) {
+		if (REG_MOTOR_TEST__SELECT & (1 << i))
+			motor_raw[i] = (uint32_t)REG_MOTOR_TEST__VALUE;
+		else if (flag_armed || (REG_CTRL__ARM_TEST > 0))
+			motor_raw[i] = (uint32_t)motor_clip[i];
+		else
+			motor_raw[i] = OUTPUT_OFF(i);
+	}
+	latency_stamp(LATENCY_MOTOR);
+	STAGE_BEGIN(STAGE_MOTOR);
+	set_motors(motor_raw);
+	STAGE_END(STAGE_MOTOR);
+	
+#if (BLACKBOX_SIZE > 0)
+	// Flight log while armed, the flash is programmed in idle time by task_blackbox
+	if (flag_armed && REG_BLACKBOX__ENABLE)
+		blackbox_start(SENSOR_PERIOD << REG_BLACKBOX__RATE);
+	else
+		blackbox_stop();
+	if ((sensor_sample_count & ((1 << REG_BLACKBOX__RATE) - 1)) == 0)
+		blackbox_record();
+	if (blackbox_pending())
+		flag_blackbox = 1;
+#endif
+	
+	// Send data to host
+	if (REG_DEBUG) {
+		telemetry_start(&telemetry_sensor, sensor_time);
+		if (telemetry_due(TELEMETRY_SENSOR_RAW, sensor_sample_count))
+			telemetry_add(&telemetry_sensor, TELEMETRY_SENSOR_RAW, &sensor_raw.bytes[1], sizeof(sensor_raw)-2);
+		if (telemetry_due(TELEMETRY_SENSOR, sensor_sample_count))
+			telemetry_add(&telemetry_sensor, TELEMETRY_SENSOR, &sensor, sizeof(sensor));
+		if (telemetry_due(TELEMETRY_ANGLE, sensor_sample_count))
+			telemetry_add(&telemetry_sensor, TELEMETRY_ANGLE, &angle, sizeof(angle));
+		if (telemetry_due(TELEMETRY_PID, sensor_sample_count))
+			telemetry_add(&telemetry_sensor, TELEMETRY_PID, pid.out, sizeof(pid.out));
+		if (telemetry_due(TELEMETRY_MOTOR, sensor_sample_count))
+			telemetry_add(&telemetry_sensor, TELEMETRY_MOTOR, motor_raw, sizeof(motor_raw));
+		telemetry_send(&telemetry_sensor);
+	}
+	
+	// Toggle LED at rate of sensor flag
+	if ((sensor_sample_count & 0x01FF) == 0)
+		toggle_led_sensor();
+	
+	return 0;
+}
+
+/* Blackbox record, quantised to integers ------------------------------------*/
+
+FAST_CODE void blackbox_record(void)
+{
+	int i;
+	int32_t field[BLACKBOX_NB_FIELD];
+	
+	field[0] = (int32_t)(sensor.gyro_x * BLACKBOX_SCALE);
+	field[1] = (int32_t)(sensor.gyro_y * BLACKBOX_SCALE);
+	field[2] = (int32_t)(sensor.gyro_z * BLACKBOX_SCALE);
+	for (i=0; i<NB_AXIS; i++) {
+		field[3 + i] = (int32_t)(setpoint[i] * BLACKBOX_SCALE);
+		field[6 + i] = (int32_t)(pid.p_term[i] * BLACKBOX_SCALE);
+		field[9 + i] = (int32_t)(pid.i_term[i] * BLACKBOX_SCALE);
+		field[12 + i] = (int32_t)(pid.d_term[i] * BLACKBOX_SCALE);
+	}
+	for (i=0; i<NB_OUTPUT; i++)
+		field[15 + i] = (int32_t)motor_raw[i];
+	field[15 + NB_OUTPUT] = (int32_t)(REG_VBAT * 1000.0f);
+	
+	blackbox_log(sensor_time, field);
+}
+
+/* PID coefficients and flavours from registers ---------------------------------*/
+
+void pid_load(void)
+{
+	if (flag_acro) {
+		pid.kp[PITCH] = REG_P_PITCH;
+		pid.ki[PITCH] = REG_I_PITCH;
+		pid.kd[PITCH] = REG_D_PITCH;
+		pid.kp[ROLL]  = REG_P_ROLL;
+		pid.ki[ROLL]  = REG_I_ROLL;
+		pid.kd[ROLL]  = REG_D_ROLL;
+	}
+	else {
+		pid.kp[PITCH] = REG_P_PITCH_ANGLE;
+		pid.ki[PITCH] = REG_I_PITCH_ANGLE;
+		pid.kd[PITCH] = REG_D_PITCH_ANGLE;
+		pid.kp[ROLL]  = REG_P_ROLL_ANGLE;
+		pid.ki[ROLL]  = REG_I_ROLL_ANGLE;
+		pid.kd[ROLL]  = REG_D_ROLL_ANGLE;
+	}
+	pid.kp[YAW] = REG_P_YAW;
+	pid.ki[YAW] = REG_I_YAW;
+	pid.kd[YAW] = REG_D_YAW;
+	
+	pid.flags = 0;
+	if (REG_PID__D_ON_MEASURE)
+		pid.flags |= PID_D_ON_MEASURE;
+	if (REG_PID__D_TIME_CONSTANT > 0)
+		pid.flags |= PID_D_FILTER;
+	if (REG_PID__SETPOINT_WEIGHT != 100)
+		pid.flags |= PID_SETPOINT_WEIGHT;
+	if (REG_PID__FEEDFORWARD)
+		pid.flags |= PID_FEEDFORWARD;
+	if (REG_PID__ANTI_WINDUP)
+		pid.flags |= PID_ANTI_WINDUP;
+	pid.weight = (float)REG_PID__SETPOINT_WEIGHT / 100.0f;
+	pid.d_alpha = (float)SENSOR_PERIOD / (float)(SENSOR_PERIOD + REG_PID__D_TIME_CONSTANT);
+}
+
+// PID gain scale, called at radio/VBAT rate
+// Pitch and roll are attenuated above the TPA breakpoint, all axes are compensated for the VBAT drop
+void gain_scale_update(void)
+{
+	pid.scale[PITCH] = tpa_scale * vbat_scale;
+	pid.scale[ROLL] = tpa_scale * vbat_scale;
+	pid.scale[YAW] = vbat_scale;
+}
+
+/* Handle timeout -----------------------------------------------------------------------*/
+
+_Bool task_timeout_sensor(void)
+{
+	int i;
+	
+	// The sensor interrupt must not update the motors at the same time
+	ENTER_CRITICAL();
+	for (i=0; i<NB_OUTPUT; i++)
+		motor_raw[i] = OUTPUT_OFF(i);
+	set_motors(motor_raw);
+	EXIT_CRITICAL();
+	flag_beep_sensor = 1;
+	
+	return 0;
+}
+
+_Bool task_timeout_radio(void)
+{
+	int i;
+	
+	flag_armed = 0;
+	flag_beep_radio = 1;
+	
+	// Stop the feedforward, measure the frame period again from the next frames
+	radio_time_valid = 0;
+	ENTER_CRITICAL();
+	ff_count = 0;
+	for (i=0; i<NB_AXIS; i++)
+		pid.ff[i] = 0;
+	EXIT_CRITICAL();
+	
+	return 0;
+}
+
+/* Process radio commands -----------------------------------------------------*/
+
+_Bool task_radio(void)
+{
+	int i;
+	_Bool error;
+	uint16_t t;
+	uint16_t dt;
+	float stick[NB_AXIS];
+	float ff_gain[NB_AXIS];
+	float ff[NB_AXIS];
+	uint8_t ff_steps;
+	
+	// Decode radio commands
+	STAGE_BEGIN(STAGE_RADIO);
+	error = radio_decode(&radio_frame, &radio_raw, &radio_rx);
+	STAGE_END(STAGE_RADIO);
+	if (error)
+		radio_error_recover();
+	else
 	{
-		// Processing time
-		t1 = (int32_t)get_timer_process();
+		reset_timeout_radio();
+		flag_beep_radio = 0; // Stop beeping
+		radio_frame_count++;
 		
-		/* Process radio commands -----------------------------------------------------*/
+		// Stick calibration, cancelled when armed
+		if (flag_armed)
+			radio_cal_stop();
+		else
+			radio_cal_step(&radio_raw);
 		
-		if (flag_radio)
-		{
-			flag_radio = 0;
-			
-			// Decode radio commands
-			error = radio_decode(&radio_frame, &radio_raw, &radio);
-			if (error)
-				radio_error_recover();
-			else
-			{
-				reset_timeout_radio();
-				flag_beep_radio = 0; // Stop beeping
-				radio_frame_count++;
-			
-				// Arm procedure
-				if (radio.aux[0] < 0.33f)
-					flag_armed = 0;
-				else if (!flag_armed && (radio.aux[0] > 0.33f) && ((radio.throttle < 0.01f)))
-					flag_armed = 1;
-				if (radio.aux[0] < 0.66f)
-					flag_acro = 1;
-				else
-					flag_acro = 0;
-				
-				// Expo and smooth
-				radio_expo(&radio, flag_acro);
-				
-				// Beep if requested
-				if (radio.aux[1] > 0.33f)
-					flag_beep_user = 1;
-				else
-					flag_beep_user = 0;
-				
-				// Send data to host
-				if ((REG_DEBUG__CASE > 0) && ((radio_frame_count & REG_DEBUG__MASK) == 0)) {
-					if (REG_DEBUG__CASE == 4)
-						host_send((uint8_t*)&radio_raw, sizeof(radio_raw));
-					else if (REG_DEBUG__CASE == 5)
-						host_send((uint8_t*)&radio, sizeof(radio));
-				}
-				
-				// Toggle LED at rate of Radio flag
-				if ((radio_frame_count & 0x3F) == 0)
-					toggle_led_radio();
-			}
-		}
+		// Arm procedure
+		if (radio_rx.aux[0] < 0.33f)
+			flag_armed = 0;
+		else if (!flag_armed && (radio_rx.aux[0] > 0.33f) && ((radio_rx.throttle < 0.01f)))
+			flag_armed = 1;
+		if (radio_rx.aux[0] < 0.66f)
+			flag_acro = 1;
+		else
+			flag_acro = 0;
 		
-		/* Process sensors -----------------------------------------------------------------------*/
+		// Expo and smooth
+		radio_expo(&radio_rx, flag_acro);
 		
-		if (flag_sensor)
-		{
-			flag_sensor = 0;
-			
-			sensor_sample_count++;
-			flag_beep_sensor = 0; // Disable beeping
-			
-			// Record sensor transaction time
-			t2 = (int32_t)timer_sensor[1] - (int32_t)timer_sensor[0];
-			if (t2 < 0)
-				t2 += 0xFFFF;
-			if ((REG_CTRL__TIME_MAXHOLD == 0) || (((uint16_t)t2 > time_sensor) && REG_CTRL__TIME_MAXHOLD))
-				time_sensor = (uint16_t)t2;
-			
-			// Recovery time before activating yaw agnle transfer
-			if (flag_acro != flag_acro_z)
-				sensor_sample_count1 = 0;
-			else if (sensor_sample_count1 < RECOVERY_TIME)
-				sensor_sample_count1++;
-			
-			// Procees sensor data
-			mpu_process_samples(&sensor_raw, &sensor);
-			
-			// Estimate angle
-			angle_estimate(&sensor, &angle, (sensor_sample_count1 == RECOVERY_TIME));
-			
-			// Smooth pitch and roll commands in angle mode
-			if (!flag_acro) {
-				radio_pitch_smooth += filter_alpha_radio * radio.pitch - filter_alpha_radio * radio_pitch_smooth;
-				radio_roll_smooth  += filter_alpha_radio * radio.roll  - filter_alpha_radio * radio_roll_smooth;
-			}
-			
-			// Previous error
-			error_pitch_z = error_pitch;
-			error_roll_z = error_roll;
-			error_yaw_z = error_yaw;
-			
-			// Current error
-			if (flag_acro) {
-				error_pitch = sensor.gyro_x - radio.pitch * (float)REG_RATE__PITCH_ROLL;
-				error_roll = sensor.gyro_y - radio.roll * (float)REG_RATE__PITCH_ROLL;
-			}
-			else {
-				error_pitch = angle.pitch - radio_pitch_smooth * (float)REG_RATE__ANGLE;
-				error_roll = angle.roll - radio_roll_smooth * (float)REG_RATE__ANGLE;
-			}
-			error_yaw = sensor.gyro_z - radio.yaw * (float)REG_RATE__YAW;
-			
-			// Switch PID coefficients for acro
-			if (flag_acro != flag_acro_z) {
-				if (flag_acro) {
-					p_pitch = REG_P_PITCH;
-					i_pitch = REG_I_PITCH;
-					d_pitch = REG_D_PITCH;
-					p_roll  = REG_P_ROLL;
-					i_roll  = REG_I_ROLL;
-					d_roll  = REG_D_ROLL;
-				}
-				else {
-					p_pitch = REG_P_PITCH_ANGLE;
-					i_pitch = REG_I_PITCH_ANGLE;
-					d_pitch = REG_D_PITCH_ANGLE;
-					p_roll  = REG_P_ROLL_ANGLE;
-					i_roll  = REG_I_ROLL_ANGLE;
-					d_roll  = REG_D_ROLL_ANGLE;
-				}
-			}
-			
-			// P,I and D
-			pitch_p_term = error_pitch * p_pitch;
-			roll_p_term = error_roll * p_roll;
-			yaw_p_term = error_yaw * REG_P_ROLL;
-			
-			if ((!flag_armed && (REG_CTRL__ARM_TEST == 0)) || (flag_acro != flag_acro_z)) {
-				pitch_i_term = 0;
-				roll_i_term = 0;
-			}
-			else {
-				pitch_i_term += error_pitch * i_pitch;
-				roll_i_term += error_roll * i_roll;
-			}
-			if (!flag_armed && (REG_CTRL__ARM_TEST == 0))
-				yaw_i_term = 0;
-			else
-				yaw_i_term += error_yaw * REG_I_YAW;
-			
-			pitch_d_term = (error_pitch - error_pitch_z) * d_pitch;
-			roll_d_term = (error_roll - error_roll_z) * d_roll;
-			yaw_d_term = (error_yaw - error_yaw_z) * REG_D_YAW;
-			
-			flag_acro_z = flag_acro;
-			
-			// Clip I
-			if      (pitch_i_term < -I_MAX) pitch_i_term = -I_MAX;
-			else if (pitch_i_term >  I_MAX) pitch_i_term =  I_MAX;
-			if      (roll_i_term  < -I_MAX) roll_i_term  = -I_MAX;
-			else if (roll_i_term  >  I_MAX) roll_i_term  =  I_MAX;
-			if      (yaw_i_term   < -I_MAX) yaw_i_term   = -I_MAX;
-			else if (yaw_i_term   >  I_MAX) yaw_i_term   =  I_MAX;
-			
-			// P+I+D
-			pitch = pitch_p_term + pitch_i_term + pitch_d_term;
-			roll = roll_p_term + roll_i_term + roll_d_term;
-			yaw = yaw_p_term + yaw_i_term + yaw_d_term;
-			
-			// Clip P+I+D
-			if      (pitch < -PID_MAX) pitch = -PID_MAX;
-			else if (pitch >  PID_MAX) pitch =  PID_MAX;
-			if      (roll  < -PID_MAX) roll  = -PID_MAX;
-			else if (roll  >  PID_MAX) roll  =  PID_MAX;
-			if      (yaw   < -PID_MAX) yaw   = -PID_MAX;
-			else if (yaw   >  PID_MAX) yaw   =  PID_MAX;
-			
-			// Desactivate throttle when arm test
-			if (REG_CTRL__ARM_TEST > 0)
-				radio.throttle = 0;
-			
-			// Motor matrix
-			motor[0] = radio.throttle * (float)REG_MOTOR__RANGE + roll + pitch - yaw;
-			motor[1] = radio.throttle * (float)REG_MOTOR__RANGE + roll - pitch + yaw;
-			motor[2] = radio.throttle * (float)REG_MOTOR__RANGE - roll - pitch - yaw;
-			motor[3] = radio.throttle * (float)REG_MOTOR__RANGE - roll + pitch + yaw;
-			
-			// Offset and clip motor value
-			for (i=0; i<4; i++) {
-				motor_clip[i] = (int32_t)motor[i] + (int32_t)REG_MOTOR__ARMED;
-				
-				if (motor_clip[i] < (int32_t)REG_MOTOR__START)
-					motor_clip[i] = (int32_t)REG_MOTOR__START;
-				else if (motor_clip[i] > (int32_t)MOTOR_MAX)
-					motor_clip[i] = (int32_t)MOTOR_MAX;
-			}
-			
-			// Motor command
-			for (i=0; i<4; i++) {
-				if (REG_MOTOR_TEST__SELECT & (1 << i))
-					motor_raw[i] = (uint32_t)REG_MOTOR_TEST__VALUE;
-				else if (flag_armed || (REG_CTRL__ARM_TEST > 0))
-					motor_raw[i] = (uint32_t)motor_clip[i];
-				else
-					motor_raw[i] = 0;
-			}
-			set_motors(motor_raw);
-			
-			// Send data to host
-			if ((REG_DEBUG__CASE > 0) && ((sensor_sample_count & REG_DEBUG__MASK) == 0)) {
-				if (REG_DEBUG__CASE == 1) 
-					host_send((uint8_t*)&sensor_raw.bytes[2], sizeof(sensor_raw)-2);
-				else if (REG_DEBUG__CASE == 2)
-					host_send((uint8_t*)&sensor, sizeof(sensor));
-				else if (REG_DEBUG__CASE == 3)
-					host_send((uint8_t*)&angle, sizeof(angle));
-				else if (REG_DEBUG__CASE == 6) {
-					host_buffer_tx.f[0] = pitch;
-					host_buffer_tx.f[1] = roll;
-					host_buffer_tx.f[2] = yaw;
-					host_send(host_buffer_tx.u8, 3*4);
-				}
-				else if (REG_DEBUG__CASE == 7)
-					host_send((uint8_t*)&motor_raw, sizeof(motor_raw));
-			}
-			
-			// Toggle LED at rate of sensor flag
-			if ((sensor_sample_count & 0x01FF) == 0)
-				toggle_led_sensor();
+		// Throttle PID attenuation, linear from 1 at the breakpoint to (1 - rate) at full throttle
+		if ((REG_GAIN_SCALE__TPA_BREAKPOINT < 100) && (radio_rx.throttle * 100.0f > (float)REG_GAIN_SCALE__TPA_BREAKPOINT)) {
+			tpa_scale = 1.0f - (float)REG_GAIN_SCALE__TPA_RATE * (radio_rx.throttle * 100.0f - (float)REG_GAIN_SCALE__TPA_BREAKPOINT) / (100.0f * (100.0f - (float)REG_GAIN_SCALE__TPA_BREAKPOINT));
+			if (tpa_scale < TPA_SCALE_MIN)
+				tpa_scale = TPA_SCALE_MIN;
 		}
+		else
+			tpa_scale = 1.0f;
+		gain_scale_update();
 		
-		/* VBAT ---------------------------------------------------------------------*/
+		// Period of the receiver frames, from RADIO_PERIOD at start-up
+		t = get_timer_process();
+		dt = t - radio_time_z;
+		if (radio_time_valid && (dt > RADIO_PERIOD_MIN) && (dt < RADIO_PERIOD_MAX))
+			radio_period += RADIO_PERIOD_ALPHA * ((float)dt - radio_period);
+		radio_time_z = t;
+		radio_time_valid = 1;
+		ff_steps = (uint8_t)(radio_period * (1.0f / (float)SENSOR_PERIOD) + 0.5f); // Sensor samples per frame
 		
-		if (flag_vbat)
-		{
-			flag_vbat = 0;
-			
-			vbat_sample_count++;
-			
-			REG_VBAT += filter_alpha_vbat * get_vbat() - filter_alpha_vbat * REG_VBAT;
-			
-			// Send VBAT to host
-			if ((REG_DEBUG__CASE == 8) && ((vbat_sample_count & REG_DEBUG__MASK) == 0))
-				host_send((uint8_t*)&REG_VBAT,4);
-			
-			// Beep if VBAT too low
-			if ((REG_VBAT < REG_VBAT_MIN) && (REG_VBAT > 8.0f))
-				flag_beep_vbat = 1;
-			else
-				flag_beep_vbat = 0;
+		// Stick feedforward: derivative of the rate setpoint (deg/s per s) over the last frame
+		// The sign is the one of the error (measure - setpoint). Pitch and roll only in acro
+		stick[PITCH] = radio_rx.pitch * (float)REG_RATE__PITCH_ROLL;
+		stick[ROLL] = radio_rx.roll * (float)REG_RATE__PITCH_ROLL;
+		stick[YAW] = radio_rx.yaw * (float)REG_RATE__YAW;
+		ff_gain[PITCH] = flag_acro ? REG_FF_PITCH : 0;
+		ff_gain[ROLL] = flag_acro ? REG_FF_ROLL : 0;
+		ff_gain[YAW] = REG_FF_YAW;
+		for (i=0; i<NB_AXIS; i++) {
+			ff[i] = -ff_gain[i] * (stick[i] - stick_z[i]) * (1000000.0f / radio_period);
+			stick_z[i] = stick[i];
 		}
 		
-		/* Host requests ------------------------------------------------------------------*/
-		
-		if (flag_host)
-		{
-			flag_host = 0;
-			reg_access(&host_buffer_rx);
-		}
+		// Publish the new commands to the control task at once, the feedforward reaches its new value in one frame
+		ENTER_CRITICAL();
+		radio = radio_rx;
+		for (i=0; i<NB_AXIS; i++)
+			ff_step[i] = (ff[i] - pid.ff[i]) / (float)ff_steps;
+		ff_count = ff_steps;
+		EXIT_CRITICAL();
 		
-		/* Handle timeout -----------------------------------------------------------------------*/
+		// Beep if requested
+		if (radio_rx.aux[1] > 0.33f)
+			flag_beep_user = 1;
+		else
+			flag_beep_user = 0;
 		
-		if (flag_timeout_sensor) {
-			flag_timeout_sensor = 0;
-			for (i=0; i<4; i++)
-				motor_raw[i] = 0;
-			set_motors(motor_raw);
-			flag_beep_sensor = 1;
-		}
-		if (flag_timeout_radio) {
-			flag_timeout_radio = 0;
-			flag_armed = 0;
-			flag_beep_radio = 1;
+		// Send data to host
+		if (REG_DEBUG) {
+			telemetry_start(&telemetry_radio, sensor_time);
+			if (telemetry_due(TELEMETRY_RADIO_RAW, radio_frame_count))
+				telemetry_add(&telemetry_radio, TELEMETRY_RADIO_RAW, &radio_raw, sizeof(radio_raw));
+			if (telemetry_due(TELEMETRY_RADIO, radio_frame_count))
+				telemetry_add(&telemetry_radio, TELEMETRY_RADIO, &radio, sizeof(radio));
+			telemetry_send(&telemetry_radio);
 		}
 		
-		/*------------------------------------------------------------------*/
-		
-		// Record processing time
-		t1 = (int32_t)get_timer_process() - t1;
-		if (t1 < 0)
-			t1 += 0xFFFF;
-		if ((REG_CTRL__TIME_MAXHOLD == 0) || (((uint16_t)t1 > time_process) && REG_CTRL__TIME_MAXHOLD))
-			time_process = (uint16_t)t1;
-		
-		// Wait for interrupts if all flags are processed
-		if (!flag_radio && !flag_sensor && !flag_vbat && !flag_host && !flag_timeout_sensor && !flag_timeout_radio)
-			__wfi();
+		// Toggle LED at rate of Radio flag
+		if ((radio_frame_count & 0x3F) == 0)
+			toggle_led_radio();
 	}
+	
+	return 0;
+}
+
+/* VBAT ---------------------------------------------------------------------*/
+
+_Bool task_vbat(void)
+{
+	vbat_sample_count++;
+	
+	REG_VBAT += filter_alpha_vbat * get_vbat() - filter_alpha_vbat * REG_VBAT;
+	
+	// Gain compensation, relative to the reference voltage (no battery below 8V)
+	if ((REG_GAIN_SCALE__VBAT_REF > 0) && (REG_VBAT > 8.0f)) {
+		vbat_scale = (float)REG_GAIN_SCALE__VBAT_REF * 0.001f / REG_VBAT;
+		if (vbat_scale < VBAT_SCALE_MIN)
+			vbat_scale = VBAT_SCALE_MIN;
+		else if (vbat_scale > VBAT_SCALE_MAX)
+			vbat_scale = VBAT_SCALE_MAX;
+	}
+	else
+		vbat_scale = 1.0f;
+	gain_scale_update();
+	
+	// Send VBAT to host
+	if (telemetry_due(TELEMETRY_VBAT, vbat_sample_count)) {
+		telemetry_start(&telemetry_vbat, sensor_time);
+		telemetry_add(&telemetry_vbat, TELEMETRY_VBAT, &REG_VBAT, 4);
+		telemetry_send(&telemetry_vbat);
+	}
+	
+	// Beep if VBAT too low
+	if ((REG_VBAT < REG_VBAT_MIN) && (REG_VBAT > 8.0f))
+		flag_beep_vbat = 1;
+	else
+		flag_beep_vbat = 0;
+	
+	return 0;
+}
+
+/* Blackbox flash ------------------------------------------------------------------*/
+
+_Bool task_blackbox(void)
+{
+	blackbox_service();
+	
+	return 0;
+}
+
+/* Host requests ------------------------------------------------------------------*/
+
+// A command that runs in slices (flash, benchmarks) holds the next one until it is done
+_Bool task_host(void)
+{
+	if (reg_job_pending())
+		return reg_job_step();
+	
+	reg_access(&host_buffer_rx);
+	
+	return reg_job_pending();
 }
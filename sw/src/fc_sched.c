@@ -0,0 +1,72 @@
+#include "fc_sched.h"
+#include "board.h" // get_timer_process
+
+/* Global variables ----------------------------------*/
+
+uint16_t sched_missed;
+uint16_t sched_overrun;
+
+/* Function definitions ----------------------------------*/
+
+// Release the tasks whose flag is raised, then run one slice of the highest priority task.
+// Lower priority tasks are only started if their budget fits before the next release of the control task
+// (unless the control task runs in the sensor interrupt).
+// Return 0 if there was nothing to run.
+_Bool sched_run(task_t * task, uint8_t nb_task)
+{
+	int i;
+	uint16_t now;
+#if (CONTROL_LOOP == MAIN_LOOP)
+	uint16_t since_control;
+#endif
+	uint16_t t;
+	_Bool more;
+	
+	now = get_timer_process();
+	
+	// Release
+	for (i=0; i<nb_task; i++) {
+		if (!task[i].ready && *task[i].flag) {
+			*task[i].flag = 0;
+			task[i].ready = 1;
+			task[i].release = now;
+		}
+	}
+	
+	// Select
+#if (CONTROL_LOOP == MAIN_LOOP)
+	since_control = now - task[0].release;
+	for (i=0; i<nb_task; i++) {
+		if (!task[i].ready)
+			continue;
+		if ((i == 0) || (since_control > task[0].deadline) || ((uint32_t)since_control + task[i].budget <= task[0].deadline))
+			break;
+	}
+#else
+	// The control task preempts from the sensor interrupt, no need to keep room for it
+	for (i=0; i<nb_task; i++) {
+		if (task[i].ready)
+			break;
+	}
+#endif
+	if (i == nb_task)
+		return 0;
+	
+	// Run one slice
+	more = task[i].run();
+	t = get_timer_process();
+	
+	if ((uint16_t)(t - now) > task[i].budget)
+		sched_overrun++;
+	
+	// The deadline of a task that runs in slices is checked per slice, from the end of the previous one
+	if (more)
+		task[i].release = t;
+	else {
+		task[i].ready = 0;
+		if ((uint16_t)(t - task[i].release) > task[i].deadline)
+			sched_missed++;
+	}
+	
+	return 1;
+}
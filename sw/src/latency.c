@@ -0,0 +1,116 @@
+#include "latency.h"
+#include "board.h" // CLOCK_TICKS, host_send
+#include "reg.h"
+#include "utils.h" // crc16
+
+/* Private defines --------------------------------------*/
+
+#define LATENCY_COMPLETE ((1 << (LATENCY_END + 1)) - 1) // Points of a complete sample
+
+/* Global variables --------------------------------------*/
+
+struct latency_s latency;
+
+FAST_DATA uint32_t latency_start; // Ticks of LATENCY_DATA_READY
+FAST_DATA uint32_t latency_time[NB_LATENCY_POINT]; // Ticks from latency_start
+FAST_DATA uint32_t latency_bin_ticks;
+FAST_DATA volatile uint8_t latency_mask; // Points stamped in the sample in progress, 0 without sample
+uint32_t latency_tx[REG_BLOCK_MAX+1]; // Read answer (words + CRC), kept until sent
+
+/* Function definitions ----------------------------------*/
+
+// Called by the interrupts and the control task of each sample, while LATENCY__ENABLE
+FAST_CODE void latency_stamp(uint8_t point)
+{
+	uint32_t t = CLOCK_TICKS();
+	uint32_t end;
+	uint32_t bin;
+	int i;
+	int w;
+	
+	// A new sample, the one in progress did not reach LATENCY_END
+	if (point == LATENCY_DATA_READY) {
+		if (latency_mask != 0)
+			latency.dropped++;
+		latency_start = t;
+		latency_time[LATENCY_DATA_READY] = 0;
+		latency_mask = REG_LATENCY__ENABLE ? 1 : 0;
+		return;
+	}
+	if (latency_mask == 0)
+		return;
+	
+	latency_time[point] = t - latency_start;
+	latency_mask |= 1 << point;
+	if (point != LATENCY_END)
+		return;
+	
+	if (latency_mask != LATENCY_COMPLETE) {
+		latency_mask = 0;
+		latency.dropped++;
+		return;
+	}
+	latency_mask = 0;
+	latency.samples++;
+	
+	// Histograms
+	for (i=1; i<=LATENCY_END; i++) {
+		bin = latency_time[i] / latency_bin_ticks;
+		if (bin >= LATENCY_NB_BIN)
+			bin = LATENCY_NB_BIN - 1;
+		latency.hist[i-1][bin]++;
+	}
+	
+	// Replace the shortest of the worst samples
+	end = latency_time[LATENCY_END];
+	w = 0;
+	for (i=1; i<LATENCY_NB_WORST; i++) {
+		if (latency.worst[i][LATENCY_END] < latency.worst[w][LATENCY_END])
+			w = i;
+	}
+	if (end > latency.worst[w][LATENCY_END]) {
+		latency.worst[w][0] = latency.samples;
+		for (i=1; i<NB_LATENCY_POINT; i++)
+			latency.worst[w][i] = latency_time[i];
+	}
+}
+
+// Clear the histograms and the worst samples, the bin width is taken from LATENCY__BIN
+void latency_reset(void)
+{
+	uint32_t * p = (uint32_t*)&latency;
+	int i;
+	
+	__disable_irq();
+	for (i=0; i<(int)LATENCY_SIZE; i++)
+		p[i] = 0;
+	latency.ticks_us = CLOCK_TICKS_US;
+	latency.bin = 1 << REG_LATENCY__BIN;
+	latency_bin_ticks = latency.bin * latency.ticks_us;
+	latency_mask = 0;
+	__enable_irq();
+}
+
+// Send up to REG_BLOCK_MAX words of struct latency_s from addr, followed by the CRC16 of the data (like reg_block_read)
+void latency_read(uint8_t addr, uint8_t count)
+{
+	uint32_t * p = (uint32_t*)&latency;
+	int i;
+	uint16_t crc;
+	
+	if (addr >= LATENCY_SIZE)
+		count = 0;
+	else if (count > LATENCY_SIZE - addr)
+		count = LATENCY_SIZE - addr;
+	if (count > REG_BLOCK_MAX)
+		count = REG_BLOCK_MAX;
+	
+	for (i=0; i<count; i++)
+		latency_tx[i] = p[addr+i];
+	
+	crc = crc16((uint8_t*)latency_tx, count*4);
+	((uint8_t*)latency_tx)[count*4] = (uint8_t)crc;
+	((uint8_t*)latency_tx)[count*4+1] = (uint8_t)(crc >> 8);
+	
+	host_send((uint8_t*)latency_tx, count*4+2);
+}
@@ -0,0 +1,115 @@
+#include "mixer.h"
+#include "board.h" // FAST_CODE
+
+/* Private macros --------------------------------------*/
+
+// Conditional moves (IT blocks), no branch
+#define MIN(a, b) (((a) < (b)) ? (a) : (b))
+#define MAX(a, b) (((a) > (b)) ? (a) : (b))
+
+/* Global variables ----------------------------------*/
+
+// Motors are listed counter-clockwise from the front right one, pitch and roll coefficients normalised to 1
+const struct mixer_s mixer_table[NB_AIRFRAME] = {
+	// QUAD_X
+	{4, {
+		{ 1.0f,  1.0f, -1.0f},
+		{-1.0f,  1.0f,  1.0f},
+		{-1.0f, -1.0f, -1.0f},
+		{ 1.0f, -1.0f,  1.0f}
+	}, {0, 0, 0}},
+	// QUAD_PLUS
+	{4, {
+		{ 1.0f,  0.0f, -1.0f},
+		{ 0.0f,  1.0f,  1.0f},
+		{-1.0f,  0.0f, -1.0f},
+		{ 0.0f, -1.0f,  1.0f}
+	}, {0, 0, 0}},
+	// HEX_X
+	{6, {
+		{ 1.0f,  0.5f, -1.0f},
+		{ 0.0f,  1.0f,  1.0f},
+		{-1.0f,  0.5f, -1.0f},
+		{-1.0f, -0.5f,  1.0f},
+		{ 0.0f, -1.0f, -1.0f},
+		{ 1.0f, -0.5f,  1.0f}
+	}, {0, 0, 0}},
+	// OCTO_X
+	{8, {
+		{ 1.0f,    0.414f, -1.0f},
+		{ 0.414f,  1.0f,    1.0f},
+		{-0.414f,  1.0f,   -1.0f},
+		{-1.0f,    0.414f,  1.0f},
+		{-1.0f,   -0.414f, -1.0f},
+		{-0.414f, -1.0f,    1.0f},
+		{ 0.414f, -1.0f,   -1.0f},
+		{ 1.0f,   -0.414f,  1.0f}
+	}, {0, 0, 0}},
+	// TRI, yaw on the tail servo
+	{3, {
+		{-1.0f,  1.0f,  0.0f},
+		{ 1.0f,  0.0f,  0.0f},
+		{-1.0f, -1.0f,  0.0f}
+	}, {0, 0, -1.0f}}
+};
+
+/* Function definitions ----------------------------------*/
+
+// Mix the PID outputs (axis) and the throttle into motor values, throttle 0 gives 0 (armed idle), clipped to [out_min, out_max]
+// If the attitude part is wider than [out_min, out_max] it is scaled down.
+// In airmode the throttle is then moved within the limits so that no motor clips (attitude authority kept at zero and
+// full throttle), otherwise each motor is clipped.
+// The axes that can not move further in one direction are flagged in sat_high/sat_low (bit per axis), for the PID anti-windup
+FAST_CODE void mixer_run(const struct mixer_s * mixer, const float axis[NB_AXIS], float throttle, float out_min, float out_max, _Bool airmode, float * motor, uint8_t * sat_high, uint8_t * sat_low)
+{
+	int i;
+	int j;
+	float x;
+	float x_min;
+	float x_max;
+	float scale;
+	uint8_t high;
+	uint8_t low;
+	_Bool saturated;
+	
+	// Attitude part
+	x_min = 0;
+	x_max = 0;
+	for (i=0; i<mixer->nb_motor; i++) {
+		x = mixer->coef[i][PITCH] * axis[PITCH] + mixer->coef[i][ROLL] * axis[ROLL] + mixer->coef[i][YAW] * axis[YAW];
+		motor[i] = x;
+		x_min = MIN(x_min, x);
+		x_max = MAX(x_max, x);
+	}
+	
+	// Desaturation
+	scale = MIN(1.0f, (out_max - out_min) / MAX(x_max - x_min, 1.0f));
+	x_min *= scale;
+	x_max *= scale;
+	if (airmode)
+		throttle = MIN(MAX(throttle, out_min - x_min), out_max - x_max);
+	saturated = !airmode || (scale < 1.0f); // In airmode, a motor on a limit is only saturated when the attitude is scaled
+	
+	// Clip and saturation flags
+	high = 0;
+	low = 0;
+	for (i=0; i<mixer->nb_motor; i++) {
+		x = throttle + scale * motor[i];
+		x = MIN(MAX(x, out_min), out_max);
+		motor[i] = x;
+		if (!saturated)
+			continue;
+		for (j=0; j<NB_AXIS; j++) {
+			if (x > out_max - 1.0f) { // Within one motor step, the scaled attitude may not reach the limit exactly
+				high |= (mixer->coef[i][j] > 0) << j;
+				low  |= (mixer->coef[i][j] < 0) << j;
+			}
+			else if (x < out_min + 1.0f) {
+				high |= (mixer->coef[i][j] < 0) << j;
+				low  |= (mixer->coef[i][j] > 0) << j;
+			}
+		}
+	}
+	*sat_high = high;
+	*sat_low = low;
+}
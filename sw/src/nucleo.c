@@ -2,10 +2,13 @@
 #include "fc.h"
 #include "radio.h"
 #include "sensor.h"
+#include "latency.h"
 
 /* Private defines ------------------------------------*/
 
 #define ADC_SCALE 0.0089f
+#define APB1_CLOCK (SystemCoreClock / 2)
+#define TIMER_CLOCK SystemCoreClock // APB1 timers (x2) and APB2 timers
 
 /* Private types --------------------------------------*/
 
@@ -14,9 +17,30 @@
 volatile uint8_t i2c1_rx_buffer[15];
 volatile uint8_t i2c1_tx_buffer[2];
 volatile uint8_t i2c1_tx_nb_bytes;
+volatile _Bool host_rx_block; // Receiving the payload of a block write
 
 /* Private macros ---------------------------------------------------*/
 
+// Sorted by class, sub-priority only orders pending interrupts of the same class
+const irq_priority_t irq_priority[] =
+{
+	// IRQ, preemption priority, sub-priority
+	{EXTI15_10_IRQn,       IRQ_PRIO_SENSOR, 1},
+	{I2C1_EV_IRQn,         IRQ_PRIO_SENSOR, 1},
+	{I2C1_ER_IRQn,         IRQ_PRIO_SENSOR, 2},
+	{DMA1_Channel3_IRQn,   IRQ_PRIO_SENSOR, 0},
+	{USART1_IRQn,          IRQ_PRIO_RADIO,  1},
+	{DMA1_Channel5_IRQn,   IRQ_PRIO_RADIO,  0},
+	{TIM1_BRK_TIM15_IRQn,  IRQ_PRIO_TIMER,  0},
+	{TIM6_DAC_IRQn,        IRQ_PRIO_TIMER,  1},
+	{TIM1_UP_TIM16_IRQn,   IRQ_PRIO_TIMER,  2},
+	{DMA1_Channel6_IRQn,   IRQ_PRIO_HOST,   0},
+	{USART2_IRQn,          IRQ_PRIO_HOST,   1},
+	{DMA1_Channel7_IRQn,   IRQ_PRIO_HOST,   1}
+};
+
+#define NB_IRQ (sizeof(irq_priority) / sizeof(irq_priority_t))
+
 /* Functions ------------------------------------------------*/
 
 void sensor_write(uint8_t addr, uint8_t data)
@@ -48,6 +72,26 @@ void rf_read(uint8_t addr, uint8_t size)
 	
 }
 
+void spi_flash_read(uint32_t addr, uint8_t * data, uint16_t size)
+{
+	
+}
+
+void spi_flash_program(uint32_t addr, uint8_t * buf, uint16_t size)
+{
+	
+}
+
+void spi_flash_erase(void)
+{
+	
+}
+
+_Bool spi_flash_busy(void)
+{
+	return 0;
+}
+
 void radio_error_recover()
 {
 	// Disable DMA UART
@@ -85,17 +129,19 @@ __forceinline void host_error_recover()
 	USART2->ICR = USART_ICR_ORECF | USART_ICR_PECF | USART_ICR_FECF | USART_ICR_NCF;
 	
 	// Enable DMA UART
-	DMA1_Channel6->CNDTR = sizeof(host_buffer_rx);
+	host_rx_block = 0;
+	DMA1_Channel6->CMAR = (uint32_t)&host_buffer_rx;
+	DMA1_Channel6->CNDTR = HOST_CMD_SIZE;
 	DMA1_Channel6->CCR |= DMA_CCR_EN;
 	USART2->CR1 |= USART_CR1_RE;
 }
 
 void set_motors(uint32_t * motor_raw)
 {
-	TIM3->CCR1 = SERVO_MAX*2 + 1 - SERVO_MIN*2 - motor_raw[0];
-	TIM3->CCR2 = SERVO_MAX*2 + 1 - SERVO_MIN*2 - motor_raw[1];
-	TIM3->CCR3 = SERVO_MAX*2 + 1 - SERVO_MIN*2 - motor_raw[2];
-	TIM3->CCR4 = SERVO_MAX*2 + 1 - SERVO_MIN*2 - motor_raw[3];
+	TIM3->CCR1 = ONESHOT_COUNT(SERVO_MAX*2 + 1 - SERVO_MIN*2 - motor_raw[0], TIMER_CLOCK);
+	TIM3->CCR2 = ONESHOT_COUNT(SERVO_MAX*2 + 1 - SERVO_MIN*2 - motor_raw[1], TIMER_CLOCK);
+	TIM3->CCR3 = ONESHOT_COUNT(SERVO_MAX*2 + 1 - SERVO_MIN*2 - motor_raw[2], TIMER_CLOCK);
+	TIM3->CCR4 = ONESHOT_COUNT(SERVO_MAX*2 + 1 - SERVO_MIN*2 - motor_raw[3], TIMER_CLOCK);
 	TIM3->CR1 |= TIM_CR1_CEN;
 }
 
@@ -153,6 +199,7 @@ uint16_t get_timer_process(void)
 void EXTI15_10_IRQHandler() 
 {
 	EXTI->PR = EXTI_PR_PIF12; // Clear pending request
+	latency_stamp(LATENCY_DATA_READY);
 	if ((REG_CTRL__SENSOR_HOST_CTRL == 0) && ((I2C1->ISR & I2C_ISR_BUSY) == 0)) {
 		sensor_read(59,14);
 		timer_sensor[0] = TIM7->CNT; // SPI transaction time
@@ -206,7 +253,8 @@ void DMA1_Channel3_IRQHandler()
 		}
 		else {
 			TIM15->CNT = 0; // Reset timeout
-			flag_sensor = 1; // Raise flag for sample ready
+			latency_stamp(LATENCY_SENSOR_DONE);
+			sensor_ready(); // Raise flag or run control task
 		}
 	}
 	
@@ -225,19 +273,33 @@ void USART2_IRQHandler()
 
 void DMA1_Channel6_IRQHandler()
 {
-	if (DMA1->ISR & DMA_ISR_TEIF6) // Check DMA transfer error
+	uint8_t count;
+	
+	if (DMA1->ISR & DMA_ISR_TEIF6) { // Check DMA transfer error
 		host_error_recover();
+		return;
+	}
+	
+	// Disable DMA UART
+	DMA1->IFCR = DMA_IFCR_CGIF6;
+	DMA1_Channel6->CCR &= ~DMA_CCR_EN;
+	USART2->CR1 &= ~USART_CR1_RE;
+	
+	// Block write: receive the payload before raising the request
+	count = host_buffer_rx.data.u8[0];
+	if (!host_rx_block && ((host_buffer_rx.instr == 10) || (host_buffer_rx.instr == 14)) && (count > 0) && (count <= REG_BLOCK_MAX)) {
+		host_rx_block = 1;
+		DMA1_Channel6->CMAR = (uint32_t)host_buffer_rx.block;
+		DMA1_Channel6->CNDTR = count * 4;
+	}
 	else {
-		// Disable DMA UART
-		DMA1->IFCR = DMA_IFCR_CGIF6;
-		DMA1_Channel6->CCR &= ~DMA_CCR_EN;
-		USART2->CR1 &= ~USART_CR1_RE;
-		
 		flag_host = 1; // Raise flag for host request
+		host_rx_block = 0;
+		DMA1_Channel6->CMAR = (uint32_t)&host_buffer_rx;
+		DMA1_Channel6->CNDTR = HOST_CMD_SIZE;
 	}
 	
 	// Enable DMA UART
-	DMA1_Channel6->CNDTR = sizeof(host_buffer_rx);
 	DMA1_Channel6->CCR |= DMA_CCR_EN;
 	USART2->CR1 |= USART_CR1_RE;
 }
@@ -328,31 +390,42 @@ void TIM1_UP_TIM16_IRQHandler()
 
 void board_init()
 {
+	int i;
+	
 	/* RCC --------------------------------------------------------*/
 	
 	// Enable XTAL oscillator
 	RCC->CR |= RCC_CR_HSEON | RCC_CR_HSEBYP;
 	while ((RCC->CR & RCC_CR_HSERDY) == 0) {}
 	
+#if (SYSCLK == 72000000)
+	// Set PLL at 72MHz = 9 * XTAL
+	RCC->CFGR |= RCC_CFGR_PLLMUL9 | RCC_CFGR_PLLSRC_HSE_PREDIV;
+#else
 	// Set PLL at 48MHz = 6 * XTAL
 	RCC->CFGR |= RCC_CFGR_PLLMUL6 | RCC_CFGR_PLLSRC_HSE_PREDIV;
+#endif
 	RCC->CR |= RCC_CR_PLLON;
 	while ((RCC->CR & RCC_CR_PLLRDY) == 0) {}
 	
 	// Select PLL as system clock
+#if (SYSCLK == 72000000)
+	FLASH->ACR |= 2 << FLASH_ACR_LATENCY_Pos; // Inrease Flash latency!
+#else
 	FLASH->ACR |= 1 << FLASH_ACR_LATENCY_Pos; // Inrease Flash latency!
+#endif
 	RCC->CFGR |= RCC_CFGR_SW_PLL;
 	while ((RCC->CFGR & RCC_CFGR_SWS_PLL) == 0) {}
-	SystemCoreClock = 48000000; // Update system clock value
+	SystemCoreClock = SYSCLK; // Update system clock value
 	
-	// Set APB1 at 24MHz
+	// Set APB1 at SYSCLK/2 (24MHz or 36MHz)
 	RCC->CFGR |= RCC_CFGR_PPRE1_DIV2;
 	
 	// Select system clock as UART1 clock and  as I2C1/2 clock
 	RCC->CFGR3 |= RCC_CFGR3_USART1SW_SYSCLK | RCC_CFGR3_I2C1SW_SYSCLK;
 	
 	// Configure SysTick to generate interrrupt every ms
-	SysTick_Config(48000); 
+	SysTick_Config(SystemCoreClock / 1000);
 	
 	/* Clock enable --------------------------------------------------*/
 	
@@ -444,54 +517,54 @@ void board_init()
 	
 	// One-pulse mode for OneShot125
 	TIM3->CR1 = TIM_CR1_OPM;
-	TIM3->PSC = 3-1;
-	TIM3->ARR = SERVO_MAX*2 + 1;
+	TIM3->PSC = 0;
+	TIM3->ARR = ONESHOT_COUNT(SERVO_MAX*2 + 1, TIMER_CLOCK);
 	TIM3->CCER = TIM_CCER_CC1E | TIM_CCER_CC2E | TIM_CCER_CC3E | TIM_CCER_CC4E;
 	TIM3->CCMR1 = (7 << TIM_CCMR1_OC1M_Pos) | (7 << TIM_CCMR1_OC2M_Pos);
 	TIM3->CCMR2 = (7 << TIM_CCMR2_OC3M_Pos) | (7 << TIM_CCMR2_OC4M_Pos);
 	
 	// Beeper
-	/*TIM4->PSC = 48000-1; // 1ms
-	TIM4->ARR = BEEPER_PERIOD;
+	/*TIM4->PSC = TIMER_PSC_100US(TIMER_CLOCK);
+	TIM4->ARR = BEEPER_PERIOD*10; // ms
 	TIM4->DIER = TIM_DIER_UIE;
 	TIM4->CR1 = TIM_CR1_CEN;*/
 	
 	// Receiver timeout
-	TIM6->PSC = 48000-1; // 1ms
-	TIM6->ARR = TIMEOUT_RADIO;
+	TIM6->PSC = TIMER_PSC_100US(TIMER_CLOCK);
+	TIM6->ARR = TIMEOUT_RADIO*10; // ms
 	TIM6->DIER = TIM_DIER_UIE;
 	//TIM6->CR1 = TIM_CR1_CEN; // To be enabled after radio init
 	
 	// Processing time
-	TIM7->PSC = 48-1; // 1us
+	TIM7->PSC = TIMER_PSC_US(TIMER_CLOCK);
 	TIM7->ARR = 65535;
 	TIM7->CR1 = TIM_CR1_CEN;
 	
 	// Sensor timeout
-	TIM15->PSC = 48-1; // 1us
+	TIM15->PSC = TIMER_PSC_US(TIMER_CLOCK);
 	TIM15->ARR = TIMEOUT_SENSOR;
 	TIM15->DIER = TIM_DIER_UIE;
 	//TIM15->CR1 = TIM_CR1_CEN; // To be enabled after sensor init
 	
 	// VBAT
-	TIM16->PSC = 48000-1; // 1ms
-	TIM16->ARR = VBAT_PERIOD;
+	TIM16->PSC = TIMER_PSC_100US(TIMER_CLOCK);
+	TIM16->ARR = VBAT_PERIOD*10; // ms
 	TIM16->DIER = TIM_DIER_UIE;
 	//TIM16->CR1 = TIM_CR1_CEN;
 	
 	/* UART ---------------------------------------------------*/
 	
 	// Host
-	USART2->BRR = 208; // 24MHz/115200bps
+	USART2->BRR = APB1_CLOCK / 115200; // 115200bps
 	USART2->CR3 = USART_CR3_DMAR | USART_CR3_DMAT | USART_CR3_EIE;
 	USART2->CR1 = USART_CR1_RE | USART_CR1_TE | USART_CR1_UE;
 	// Radio
 	#if (RADIO_TYPE == SBUS)
-		USART1->BRR = 480; // 48MHz/100000bps
+		USART1->BRR = SystemCoreClock / 100000; // 100000bps
 		USART1->CR1 = USART_CR1_UE | USART_CR1_M0 | USART_CR1_PCE;
 		USART1->CR2 = (2 << USART_CR2_STOP_Pos) | USART_CR2_RXINV;
 	#else
-		USART1->BRR = 417; // 48MHz/115200bps
+		USART1->BRR = SystemCoreClock / 115200; // 115200bps
 		USART1->CR1 = USART_CR1_UE;
 	#endif
 	USART1->CR3 = USART_CR3_EIE;
@@ -500,7 +573,7 @@ void board_init()
 	
 	I2C1->CR1 = I2C_CR1_TCIE | I2C_CR1_TXIE | I2C_CR1_RXDMAEN | I2C_CR1_ERRIE;
 	I2C1->CR2 = 104 << (1+I2C_CR2_SADD_Pos);
-	I2C1->TIMINGR = (5 << I2C_TIMINGR_PRESC_Pos) | (9 << I2C_TIMINGR_SCLL_Pos) | (3 << I2C_TIMINGR_SCLH_Pos) | (3 << I2C_TIMINGR_SDADEL_Pos) | (3 << I2C_TIMINGR_SCLDEL_Pos); // 400kHz (Fast-mode)
+	I2C1->TIMINGR = ((SystemCoreClock / 8000000 - 1) << I2C_TIMINGR_PRESC_Pos) | (9 << I2C_TIMINGR_SCLL_Pos) | (3 << I2C_TIMINGR_SCLH_Pos) | (3 << I2C_TIMINGR_SDADEL_Pos) | (3 << I2C_TIMINGR_SCLDEL_Pos); // 400kHz (Fast-mode), timings at 8MHz
 	I2C1->CR1 |= I2C_CR1_PE;
 	
 	/* ADC -----------------------------------------------------*/
@@ -531,37 +604,17 @@ void board_init()
 	EXTI->RTSR |= EXTI_RTSR_TR12;
 	//EXTI->IMR = EXTI_IMR_MR12; // To be enabled after MPU init
 	
-	NVIC_EnableIRQ(EXTI15_10_IRQn);
-	NVIC_EnableIRQ(USART1_IRQn);
-	NVIC_EnableIRQ(USART2_IRQn);
-	NVIC_EnableIRQ(I2C1_ER_IRQn);
-	NVIC_EnableIRQ(I2C1_EV_IRQn);
-	NVIC_EnableIRQ(DMA1_Channel3_IRQn);
-	NVIC_EnableIRQ(DMA1_Channel5_IRQn);
-	NVIC_EnableIRQ(DMA1_Channel6_IRQn);
-	NVIC_EnableIRQ(DMA1_Channel7_IRQn);
-	NVIC_EnableIRQ(TIM6_DAC_IRQn);
-	NVIC_EnableIRQ(TIM1_BRK_TIM15_IRQn);
-	NVIC_EnableIRQ(TIM1_UP_TIM16_IRQn);
-	
-	NVIC_SetPriority(EXTI15_10_IRQn,0);
-	NVIC_SetPriority(USART1_IRQn,0);
-	NVIC_SetPriority(USART2_IRQn,0);
-	NVIC_SetPriority(I2C1_ER_IRQn,0);
-	NVIC_SetPriority(I2C1_EV_IRQn,0);
-	NVIC_SetPriority(DMA1_Channel3_IRQn,0);
-	NVIC_SetPriority(DMA1_Channel5_IRQn,0);
-	NVIC_SetPriority(DMA1_Channel6_IRQn,0);
-	NVIC_SetPriority(DMA1_Channel7_IRQn,0);
-	NVIC_SetPriority(TIM6_DAC_IRQn,0);
-	NVIC_SetPriority(TIM1_BRK_TIM15_IRQn,0);
-	NVIC_SetPriority(TIM1_UP_TIM16_IRQn,0);
-
+	NVIC_SetPriorityGrouping(IRQ_PRIORITY_GROUP);
+	for (i=0; i<NB_IRQ; i++) {
+		NVIC_SetPriority(irq_priority[i].irq, NVIC_EncodePriority(IRQ_PRIORITY_GROUP, irq_priority[i].preempt, irq_priority[i].sub));
+		NVIC_EnableIRQ(irq_priority[i].irq);
+	}
+	
 	/* Host init -----------------------------------------------------------*/
 	
-	DMA1_Channel6->CNDTR = sizeof(host_buffer_rx);
+	DMA1_Channel6->CNDTR = HOST_CMD_SIZE;
 	DMA1_Channel6->CCR |= DMA_CCR_EN;
-
+	
 	/* Sensor init ----------------------------------------------------*/
 	
 	wait_ms(1000);
@@ -0,0 +1,105 @@
+#include "pid.h"
+#include "board.h" // FAST_CODE
+
+/* Functions ------------------------------------------------*/
+
+// Clear the configuration and the state
+void pid_init(struct pid_s * pid, float i_max, float out_max)
+{
+	int i;
+	
+	for (i=0; i<NB_AXIS; i++) {
+		pid->kp[i] = 0;
+		pid->ki[i] = 0;
+		pid->kd[i] = 0;
+		pid->ff[i] = 0;
+		pid->scale[i] = 1.0f;
+		pid->error[i] = 0;
+		pid->d_input_z[i] = 0;
+		pid->p_term[i] = 0;
+		pid->i_term[i] = 0;
+		pid->d_term[i] = 0;
+		pid->out[i] = 0;
+	}
+	pid->weight = 1.0f;
+	pid->d_alpha = 1.0f;
+	pid->i_max = i_max;
+	pid->out_max = out_max;
+	pid->flags = 0;
+	pid->sat_high = 0;
+	pid->sat_low = 0;
+}
+
+// One sample of the three axes, error = measure - setpoint
+// The I term of the axes set in i_reset (bit per axis) is cleared instead of integrated
+// The gain scale applies to P, D and to what I integrates, not to the stored I (no step when the scale changes)
+// With anti-windup, I is not integrated towards a saturated mixer output (sat_high/sat_low of the previous sample),
+// and the part of the output above out_max is taken back from I (without changing its sign)
+FAST_CODE void pid_update(struct pid_s * pid, const float setpoint[NB_AXIS], const float measure[NB_AXIS], uint8_t i_reset)
+{
+	int i;
+	float d_input;
+	float d;
+	float x;
+	_Bool anti_windup;
+	
+	anti_windup = (PID_FLAVOURS & PID_ANTI_WINDUP) && (pid->flags & PID_ANTI_WINDUP);
+	
+	for (i=0; i<NB_AXIS; i++) {
+		pid->error[i] = measure[i] - setpoint[i];
+		
+		// P
+		if ((PID_FLAVOURS & PID_SETPOINT_WEIGHT) && (pid->flags & PID_SETPOINT_WEIGHT))
+			pid->p_term[i] = (measure[i] - pid->weight * setpoint[i]) * pid->kp[i];
+		else
+			pid->p_term[i] = pid->error[i] * pid->kp[i];
+		
+		// I
+		if (i_reset & (1 << i))
+			pid->i_term[i] = 0;
+		else {
+			x = pid->scale[i] * pid->error[i] * pid->ki[i];
+			if (anti_windup && (((x > 0) && (pid->sat_high & (1 << i))) || ((x < 0) && (pid->sat_low & (1 << i)))))
+				x = 0;
+			x += pid->i_term[i];
+			if      (x < -pid->i_max) x = -pid->i_max;
+			else if (x >  pid->i_max) x =  pid->i_max;
+			pid->i_term[i] = x;
+		}
+		
+		// D
+		if ((PID_FLAVOURS & PID_D_ON_MEASURE) && (pid->flags & PID_D_ON_MEASURE))
+			d_input = measure[i];
+		else
+			d_input = pid->error[i];
+		d = (d_input - pid->d_input_z[i]) * pid->kd[i];
+		pid->d_input_z[i] = d_input;
+		if ((PID_FLAVOURS & PID_D_FILTER) && (pid->flags & PID_D_FILTER))
+			pid->d_term[i] += pid->d_alpha * d - pid->d_alpha * pid->d_term[i];
+		else
+			pid->d_term[i] = d;
+		
+		// P+I+D(+FF)
+		x = pid->scale[i] * (pid->p_term[i] + pid->d_term[i]) + pid->i_term[i];
+		if ((PID_FLAVOURS & PID_FEEDFORWARD) && (pid->flags & PID_FEEDFORWARD))
+			x += pid->ff[i];
+		// I is not scaled in the output, the excess is taken back from it as is
+		if (x < -pid->out_max) {
+			if (anti_windup && (pid->i_term[i] < 0)) {
+				pid->i_term[i] -= x + pid->out_max;
+				if (pid->i_term[i] > 0)
+					pid->i_term[i] = 0;
+			}
+			x = -pid->out_max;
+		}
+		else if (x > pid->out_max) {
+			if (anti_windup && (pid->i_term[i] > 0)) {
+				pid->i_term[i] -= x - pid->out_max;
+				if (pid->i_term[i] < 0)
+					pid->i_term[i] = 0;
+			}
+			x = pid->out_max;
+		}
+		pid->out[i] = x;
+	}
+}
@@ -5,6 +5,11 @@
 #include "board.h" // rf_write
 #include "fc.h" // flag
 
+/* Private defines --------------------------------------*/
+
+#define RADIO_CAL_IDLE_FRAMES 100
+#define RADIO_CAL_RANGE_FRAMES 1000
+
 /* Private macros --------------------------------------*/
 
 #define RF_WRITE(addr,data) rf_data_w[0] = data; rf_write(addr, rf_data_w, 1); wait_ms(1);
@@ -12,6 +17,7 @@
 /* Global variables -----------------------*/
 
 uint8_t rf_data_w[6];
+struct radio_cal_s radio_cal;
 
 /* Functions -----------------------*/
 
@@ -68,100 +74,91 @@ _Bool radio_decode(radio_frame_t * radio_frame, struct radio_raw_s * radio_raw,
 		return 1;
 }
 
-void radio_cal_idle(radio_frame_t * radio_frame)
+// Idle (100 frames) or range (1000 frames, sticks moved in circle) calibration, one frame per call of radio_cal_step
+void radio_cal_start(uint8_t mode)
 {
-	uint16_t radio_sample_count = 0;
-	struct radio_raw_s radio_raw1;
-	struct radio_s radio1;
-	
-	float aileron_idle = 0;
-	float elevator_idle = 0;
-	float rudder_idle = 0;
-	
-	while (radio_sample_count < 100)
-	{
-		if (flag_radio)
-		{
-			flag_radio = 0;
-			
-			radio_decode(radio_frame, &radio_raw1, &radio1);
-			
-			aileron_idle += (float)radio_raw1.aileron;
-			elevator_idle += (float)radio_raw1.elevator;
-			rudder_idle += (float)radio_raw1.rudder;
-			
-			if ((radio_sample_count & 0x03) == 0)
-				toggle_led_sensor();
-			
-			radio_sample_count++;
-		}
-		__wfi();
-	}
-	
-	REG_AILERON &= ~REG_AILERON__IDLE_Msk;
-	REG_AILERON |= ((uint32_t)(aileron_idle / 100.0f) << REG_AILERON__IDLE_Pos) & REG_AILERON__IDLE_Msk;
-	REG_ELEVATOR &= ~REG_ELEVATOR__IDLE_Msk;
-	REG_ELEVATOR |= ((uint32_t)(elevator_idle / 100.0f) << REG_ELEVATOR__IDLE_Pos) & REG_ELEVATOR__IDLE_Msk;
-	REG_RUDDER &= ~REG_RUDDER__IDLE_Msk;
-	REG_RUDDER |= ((uint32_t)(rudder_idle / 100.0f) << REG_RUDDER__IDLE_Pos) & REG_RUDDER__IDLE_Msk;
+	radio_cal.mode = mode;
+	radio_cal.count = 0;
+	if (mode == RADIO_CAL_IDLE)
+		radio_cal.progress_idle = 0;
+	else
+		radio_cal.progress_range = 0;
+	radio_cal.aileron_idle = 0;
+	radio_cal.elevator_idle = 0;
+	radio_cal.rudder_idle = 0;
+	radio_cal.throttle_min = 0xFFFF;
+	radio_cal.throttle_max = 0;
+	radio_cal.aileron_min = 0xFFFF;
+	radio_cal.aileron_max = 0;
+	radio_cal.elevator_min = 0xFFFF;
+	radio_cal.elevator_max = 0;
+	radio_cal.rudder_min = 0xFFFF;
+	radio_cal.rudder_max = 0;
 }
 
-void radio_cal_range(radio_frame_t * radio_frame)
+void radio_cal_stop(void)
 {
-	uint16_t radio_sample_count = 0;
-	struct radio_raw_s radio_raw1;
-	struct radio_s radio1;
+	radio_cal.mode = RADIO_CAL_OFF;
+}
+
+void radio_cal_step(struct radio_raw_s * radio_raw)
+{
+	if (radio_cal.mode == RADIO_CAL_OFF)
+		return;
 	
-	uint16_t throttle_min = 0xFFFF;
-	uint16_t throttle_max = 0;
-	uint16_t aileron_min = 0xFFFF;
-	uint16_t aileron_max = 0;
-	uint16_t elevator_min = 0xFFFF;
-	uint16_t elevator_max = 0;
-	uint16_t rudder_min = 0xFFFF;
-	uint16_t rudder_max = 0;
+	if ((radio_cal.count & 0x03) == 0)
+		toggle_led_sensor();
+	radio_cal.count++;
 	
-	while (radio_sample_count < 1000)
-	{
-		if (flag_radio)
-		{
-			flag_radio = 0;
-			
-			radio_decode(radio_frame, &radio_raw1, &radio1);
-			
-			if (radio_raw1.throttle > throttle_max)
-				throttle_max = radio_raw1.throttle;
-			if (radio_raw1.throttle < throttle_min)
-				throttle_min = radio_raw1.throttle;
-			if (radio_raw1.aileron > aileron_max)
-				aileron_max = radio_raw1.aileron;
-			if (radio_raw1.aileron < aileron_min)
-				aileron_min = radio_raw1.aileron;
-			if (radio_raw1.elevator > elevator_max)
-				elevator_max = radio_raw1.elevator;
-			if (radio_raw1.elevator < elevator_min)
-				elevator_min = radio_raw1.elevator;
-			if (radio_raw1.rudder > rudder_max)
-				rudder_max = radio_raw1.rudder;
-			if (radio_raw1.rudder < rudder_min)
-				rudder_min = radio_raw1.rudder;
-			
-			if ((radio_sample_count & 0x03) == 0)
-				toggle_led_sensor();
-			
-			radio_sample_count++;
-		}
-		__wfi();
+	if (radio_cal.mode == RADIO_CAL_IDLE) {
+		radio_cal.aileron_idle += (float)radio_raw->aileron;
+		radio_cal.elevator_idle += (float)radio_raw->elevator;
+		radio_cal.rudder_idle += (float)radio_raw->rudder;
+		
+		radio_cal.progress_idle = (uint8_t)(radio_cal.count * 100 / RADIO_CAL_IDLE_FRAMES);
+		if (radio_cal.count < RADIO_CAL_IDLE_FRAMES)
+			return;
+		
+		REG_AILERON &= ~REG_AILERON__IDLE_Msk;
+		REG_AILERON |= ((uint32_t)(radio_cal.aileron_idle / (float)RADIO_CAL_IDLE_FRAMES) << REG_AILERON__IDLE_Pos) & REG_AILERON__IDLE_Msk;
+		REG_ELEVATOR &= ~REG_ELEVATOR__IDLE_Msk;
+		REG_ELEVATOR |= ((uint32_t)(radio_cal.elevator_idle / (float)RADIO_CAL_IDLE_FRAMES) << REG_ELEVATOR__IDLE_Pos) & REG_ELEVATOR__IDLE_Msk;
+		REG_RUDDER &= ~REG_RUDDER__IDLE_Msk;
+		REG_RUDDER |= ((uint32_t)(radio_cal.rudder_idle / (float)RADIO_CAL_IDLE_FRAMES) << REG_RUDDER__IDLE_Pos) & REG_RUDDER__IDLE_Msk;
+	}
+	else {
+		if (radio_raw->throttle > radio_cal.throttle_max)
+			radio_cal.throttle_max = radio_raw->throttle;
+		if (radio_raw->throttle < radio_cal.throttle_min)
+			radio_cal.throttle_min = radio_raw->throttle;
+		if (radio_raw->aileron > radio_cal.aileron_max)
+			radio_cal.aileron_max = radio_raw->aileron;
+		if (radio_raw->aileron < radio_cal.aileron_min)
+			radio_cal.aileron_min = radio_raw->aileron;
+		if (radio_raw->elevator > radio_cal.elevator_max)
+			radio_cal.elevator_max = radio_raw->elevator;
+		if (radio_raw->elevator < radio_cal.elevator_min)
+			radio_cal.elevator_min = radio_raw->elevator;
+		if (radio_raw->rudder > radio_cal.rudder_max)
+			radio_cal.rudder_max = radio_raw->rudder;
+		if (radio_raw->rudder < radio_cal.rudder_min)
+			radio_cal.rudder_min = radio_raw->rudder;
+		
+		radio_cal.progress_range = (uint8_t)(radio_cal.count * 100 / RADIO_CAL_RANGE_FRAMES);
+		if (radio_cal.count < RADIO_CAL_RANGE_FRAMES)
+			return;
+		
+		REG_THROTTLE = (((uint32_t)radio_cal.throttle_min << REG_THROTTLE__IDLE_Pos) & REG_THROTTLE__IDLE_Msk) | (((uint32_t)(radio_cal.throttle_max - radio_cal.throttle_min) << REG_THROTTLE__RANGE_Pos) & REG_THROTTLE__RANGE_Msk);
+		
+		REG_AILERON &= ~REG_AILERON__RANGE_Msk;
+		REG_AILERON |= ((uint32_t)((radio_cal.aileron_max - radio_cal.aileron_min)>>1) << REG_AILERON__RANGE_Pos) & REG_AILERON__RANGE_Msk;
+		REG_ELEVATOR &= ~REG_ELEVATOR__RANGE_Msk;
+		REG_ELEVATOR |= ((uint32_t)((radio_cal.elevator_max - radio_cal.elevator_min)>>1) << REG_ELEVATOR__RANGE_Pos) & REG_ELEVATOR__RANGE_Msk;
+		REG_RUDDER &= ~REG_RUDDER__RANGE_Msk;
+		REG_RUDDER |= ((uint32_t)((radio_cal.rudder_max - radio_cal.rudder_min)>>1) << REG_RUDDER__RANGE_Pos) & REG_RUDDER__RANGE_Msk;
 	}
 	
-	REG_THROTTLE = (((uint32_t)throttle_min << REG_THROTTLE__IDLE_Pos) & REG_THROTTLE__IDLE_Msk) | (((uint32_t)(throttle_max - throttle_min) << REG_THROTTLE__RANGE_Pos) & REG_THROTTLE__RANGE_Msk);
-	
-	REG_AILERON &= ~REG_AILERON__RANGE_Msk;
-	REG_AILERON |= ((uint32_t)((aileron_max - aileron_min)>>1) << REG_AILERON__RANGE_Pos) & REG_AILERON__RANGE_Msk;
-	REG_ELEVATOR &= ~REG_ELEVATOR__RANGE_Msk;
-	REG_ELEVATOR |= ((uint32_t)((elevator_max - elevator_min)>>1) << REG_ELEVATOR__RANGE_Pos) & REG_ELEVATOR__RANGE_Msk;
-	REG_RUDDER &= ~REG_RUDDER__RANGE_Msk;
-	REG_RUDDER |= ((uint32_t)((rudder_max - rudder_min)>>1) << REG_RUDDER__RANGE_Pos) & REG_RUDDER__RANGE_Msk;
+	radio_cal.mode = RADIO_CAL_OFF;
 }
 
 void radio_expo(struct radio_s * radio, _Bool acro_mode)
@@ -1,17 +1,63 @@
 #include "reg.h"
 #include "fc.h" // flags, sensor_raw, radio_raw
 #include "board.h" // CMSIS
-#include "sensor.h" // mpu_cal()
+#include "sensor.h" // mpu_cal_start()
 #include "radio.h" // default idle/range
+#include "fc_sched.h" // scheduler statistics
+#include "utils.h" // crc16
+#include "blackbox.h"
+#include "bench.h"
+#include "latency.h"
 
-uint32_t reg[NB_REG];
-float regf[NB_REG];
-reg_properties_t reg_properties[NB_REG] = 
+/* Private defines --------------------------------------*/
+
+// Update hooks, one bit per group of dependent values
+#define REG_HOOK_CTRL 0x01
+#define REG_HOOK_EXPO 0x02
+#define REG_HOOK_FILTER 0x04
+#define REG_HOOK_PID 0x08
+#define REG_HOOK_BLACKBOX 0x10
+#define REG_HOOK_BENCH 0x20
+#define REG_HOOK_LATENCY 0x40
+#define REG_HOOK_ALL 0x7F
+
+// Host commands that run in slices of task_host (reg_job_step), the next command waits for their end
+#define REG_JOB_NONE 0
+#define REG_JOB_ERASE 1 // Flash erase started, wait for its end
+#define REG_JOB_PROGRAM 2 // Program reg_job_data to the flash, one register per slice
+#define REG_JOB_BENCH 3 // Benchmarks, one round per slice
+
+/* Private macros --------------------------------------*/
+
+// Address of a register from its REG_ define
+#define REG_ADDR(r) ((reg_t*)&(r) - reg)
+
+/* Private functions --------------------------------------*/
+
+void reg_hook_ctrl(void);
+void reg_hook_expo(void);
+void reg_hook_filter(void);
+void reg_hook_blackbox(void);
+void reg_hook_bench(void);
+void reg_hook_latency(void);
+void reg_flash_unlock(void);
+void reg_flash_erase(void);
+void reg_flash_program(uint8_t addr, uint32_t data);
+_Bool reg_flash_busy(void);
+void reg_flash_end(void);
+void reg_job_program(uint8_t addr, uint8_t count, _Bool answer);
+void reg_block_read(reg_t * src, uint8_t addr, uint8_t count);
+void reg_block_write(host_buffer_rx_t * host_buffer_rx, _Bool flash);
+
+/* Global variables --------------------------------------*/
+
+reg_t reg[NB_REG];
+const reg_properties_t reg_properties[NB_REG] = 
 {
-	{1, 1, 0, 29}, // VERSION
+	{1, 1, 0, 38}, // VERSION
 	{0, 0, 0, 0}, // CTRL
 	{0, 0, 0, 0}, // MOTOR_TEST
-	{0, 0, 0, 32512}, // DEBUG
+	{0, 0, 0, 0}, // DEBUG
 	{1, 0, 0, 0}, // ERROR
 	{1, 0, 0, 0}, // TIME
 	{1, 0, 1, 0}, // VBAT
@@ -44,7 +90,28 @@ reg_properties_t reg_properties[NB_REG] =
 	{1, 1, 0, 0}, // THROTTLE
 	{1, 1, 0, 0}, // AILERON
 	{1, 1, 0, 0}, // ELEVATOR
-	{1, 1, 0, 0} // RUDDER
+	{1, 1, 0, 0}, // RUDDER
+	{1, 0, 0, 0}, // SCHED
+	{1, 0, 0, 0}, // SENSOR_PERIOD
+	{0, 1, 0, 25606}, // PID
+	{0, 1, 0, 65536000}, // MIXER
+	{0, 1, 0, 100}, // GAIN_SCALE
+	{0, 1, 1, 0}, // FF_PITCH
+	{0, 1, 1, 0}, // FF_ROLL
+	{0, 1, 1, 0}, // FF_YAW
+	{0, 1, 1, 0}, // GYRO_TC_X
+	{0, 1, 1, 0}, // GYRO_TC_Y
+	{0, 1, 1, 0}, // GYRO_TC_Z
+	{1, 1, 1, 1103626240}, // GYRO_TC_TEMP
+	{0, 1, 0, 5120}, // GYRO_TC
+	{1, 0, 0, 0}, // CAL
+	{0, 0, 0, 626140501}, // DEBUG_RATE
+	{0, 1, 0, 1}, // BLACKBOX
+	{1, 0, 0, 0}, // BLACKBOX_STATUS
+	{0, 0, 0, 65}, // DEBUG_DELTA
+	{0, 0, 0, 0}, // BENCH
+	{1, 0, 1, 0}, // BENCH_RESULT
+	{0, 0, 0, 48} // LATENCY
 };
 
 #ifdef STM32F3
@@ -53,6 +120,9 @@ reg_properties_t reg_properties[NB_REG] =
 #elif defined(STM32F4)
 	uint32_t* flash_r = (uint32_t*)REG_FLASH_ADDR;
 	uint32_t* flash_w = (uint32_t*)REG_FLASH_ADDR;
+#elif defined(SIL)
+	uint32_t* flash_r = sil_flash;
+	uint32_t* flash_w = sil_flash;
 #endif
 
 float expo_scale_pitch_roll;
@@ -61,12 +131,23 @@ float filter_alpha_radio;
 float filter_alpha_accel;
 float filter_alpha_vbat;
 
+reg_t reg_none; // Read outside of the register map
+uint8_t reg_hook[NB_REG]; // Hooks (REG_HOOK_*) to call when the register is written
+uint8_t reg_dirty;
+uint32_t reg_block_tx[REG_BLOCK_MAX+1]; // Block read answer (registers + CRC), kept until sent
+uint8_t reg_block_status; // Block write answer: 0 = done, 1 = rejected
+uint8_t reg_job; // REG_JOB_*
+uint8_t reg_job_addr;
+uint8_t reg_job_count;
+uint8_t reg_job_index; // Next register to program
+_Bool reg_job_answer; // Block write, send reg_block_status at the end
+uint32_t reg_job_data[REG_BLOCK_MAX];
+
 void reg_init()
 {
 	int i;
 	
 	_Bool reg_flash_valid;
-	uint32_t reg_default;
 	
 	if (flash_r[0] == reg_properties[0].dflt)
 		reg_flash_valid = 1;
@@ -76,13 +157,9 @@ void reg_init()
 	for(i=0; i<NB_REG; i++)
 	{
 		if (reg_properties[i].flash && reg_flash_valid)
-			reg_default = flash_r[i];
-		else
-			reg_default = reg_properties[i].dflt;
-		if (reg_properties[i].is_float)
-			regf[i] = uint32_to_float(reg_default);
+			reg[i].u = flash_r[i];
 		else
-			reg[i] = reg_default;
+			reg[i].u = reg_properties[i].dflt;
 	}
 	
 	REG_VBAT = 15.0f;
@@ -94,21 +171,92 @@ void reg_init()
 		REG_RUDDER = ((RUDDER_IDLE_DEFAULT << REG_RUDDER__IDLE_Pos) & REG_RUDDER__IDLE_Msk) | ((RUDDER_RANGE_DEFAULT << REG_RUDDER__RANGE_Pos) & REG_RUDDER__RANGE_Msk);
 	}
 	
+	// Registers with an update hook, the others are read directly where they are used
+	reg_hook[REG_ADDR(REG_CTRL)] = REG_HOOK_CTRL;
+	reg_hook[REG_ADDR(REG_EXPO_PITCH_ROLL)] = REG_HOOK_EXPO;
+	reg_hook[REG_ADDR(REG_EXPO_YAW)] = REG_HOOK_EXPO;
+	reg_hook[REG_ADDR(REG_TIME_CONSTANT)] = REG_HOOK_FILTER;
+	reg_hook[REG_ADDR(REG_TIME_CONSTANT_RADIO)] = REG_HOOK_FILTER;
+	for (i=REG_ADDR(REG_P_PITCH); i<=REG_ADDR(REG_D_ROLL_ANGLE); i++)
+		reg_hook[i] = REG_HOOK_PID;
+	reg_hook[REG_ADDR(REG_PID)] = REG_HOOK_PID;
+	reg_hook[REG_ADDR(REG_BLACKBOX)] = REG_HOOK_BLACKBOX;
+	reg_hook[REG_ADDR(REG_BENCH)] = REG_HOOK_BENCH;
+	reg_hook[REG_ADDR(REG_LATENCY)] = REG_HOOK_LATENCY;
+	
 	reg_update_on_write();
 }
 
+// Update everything, after reg_init
 void reg_update_on_write(void)
 {
-	set_mpu_host(REG_CTRL__SENSOR_HOST_CTRL == 1);
+	reg_dirty = REG_HOOK_ALL;
+	reg_update_dirty();
+}
+
+// Call the hooks of the registers written since the last call
+void reg_update_dirty(void)
+{
+	uint8_t dirty;
 	
-	expo_scale_pitch_roll = EXPONENTIAL(REG_EXPO_PITCH_ROLL) - 1;
-	expo_scale_yaw = EXPONENTIAL(REG_EXPO_YAW) - 1;
+	dirty = reg_dirty;
+	reg_dirty = 0;
+	
+	if (dirty & REG_HOOK_CTRL)
+		reg_hook_ctrl();
+	if (dirty & REG_HOOK_EXPO)
+		reg_hook_expo();
+	if (dirty & REG_HOOK_FILTER)
+		reg_hook_filter();
+	if (dirty & REG_HOOK_PID)
+		flag_pid_update = 1; // Reload PID coefficients
+	if (dirty & REG_HOOK_BLACKBOX)
+		reg_hook_blackbox();
+	if (dirty & REG_HOOK_BENCH)
+		reg_hook_bench();
+	if (dirty & REG_HOOK_LATENCY)
+		reg_hook_latency();
+}
+
+void reg_hook_ctrl(void)
+{
+	set_mpu_host(REG_CTRL__SENSOR_HOST_CTRL == 1);
 	
 	if (REG_CTRL__BEEP_TEST)
 		flag_beep_host = 1;
 	else
 		flag_beep_host = 0;
 	
+	flag_acro = (REG_CTRL__ARM_TEST == 1);
+	
+	// Calibrations run in the sensor and radio tasks, only while disarmed
+	if (REG_CTRL__SENSOR_CAL) {
+		REG_CTRL &= ~REG_CTRL__SENSOR_CAL_Msk;
+		if (!flag_armed)
+			mpu_cal_start();
+	}
+	
+	if (REG_CTRL__RADIO_CAL_IDLE) {
+		REG_CTRL &= ~REG_CTRL__RADIO_CAL_IDLE_Msk;
+		if (!flag_armed)
+			radio_cal_start(RADIO_CAL_IDLE);
+	}
+	
+	if (REG_CTRL__RADIO_CAL_RANGE) {
+		REG_CTRL &= ~REG_CTRL__RADIO_CAL_RANGE_Msk;
+		if (!flag_armed)
+			radio_cal_start(RADIO_CAL_RANGE);
+	}
+}
+
+void reg_hook_expo(void)
+{
+	expo_scale_pitch_roll = EXPONENTIAL(REG_EXPO_PITCH_ROLL) - 1;
+	expo_scale_yaw = EXPONENTIAL(REG_EXPO_YAW) - 1;
+}
+
+void reg_hook_filter(void)
+{
 	if (REG_TIME_CONSTANT_RADIO == 0)
 		filter_alpha_radio = 1.0f;
 	else
@@ -122,22 +270,36 @@ void reg_update_on_write(void)
 		REG_TIME_CONSTANT |= VBAT_PERIOD << REG_TIME_CONSTANT__VBAT_Pos;
 	}
 	filter_alpha_vbat  = (float)VBAT_PERIOD / (float)REG_TIME_CONSTANT__VBAT;
-	
-	flag_acro = (REG_CTRL__ARM_TEST == 1);
-	
-	if (REG_CTRL__SENSOR_CAL) {
-		REG_CTRL &= ~REG_CTRL__SENSOR_CAL_Msk;
-		mpu_cal(&sensor_raw);
+}
+
+void reg_hook_blackbox(void)
+{
+	// Erase the log, only while disarmed
+	if (REG_BLACKBOX__ERASE) {
+		REG_BLACKBOX &= ~REG_BLACKBOX__ERASE_Msk;
+		if (!flag_armed)
+			blackbox_erase();
 	}
-	
-	if (REG_CTRL__RADIO_CAL_IDLE) {
-		REG_CTRL &= ~REG_CTRL__RADIO_CAL_IDLE_Msk;
-		radio_cal_idle(&radio_frame);
+}
+
+void reg_hook_bench(void)
+{
+	// Run the benchmarks in slices of task_host, only while disarmed
+	if (REG_BENCH__RUN) {
+		REG_BENCH &= ~REG_BENCH__RUN_Msk;
+		if (!flag_armed && (reg_job == REG_JOB_NONE)) {
+			bench_start();
+			reg_job = REG_JOB_BENCH;
+		}
 	}
-	
-	if (REG_CTRL__RADIO_CAL_RANGE) {
-		REG_CTRL &= ~REG_CTRL__RADIO_CAL_RANGE_Msk;
-		radio_cal_range(&radio_frame);
+}
+
+void reg_hook_latency(void)
+{
+	// Clear the trace, also when the bin width changes
+	if (REG_LATENCY__RESET || (latency.bin != (1U << REG_LATENCY__BIN))) {
+		REG_LATENCY &= ~REG_LATENCY__RESET_Msk;
+		latency_reset();
 	}
 }
 
@@ -145,6 +307,11 @@ void reg_update_on_read(void)
 {
 	REG_ERROR = ((uint32_t)rf_error_count << 16) | ((uint32_t)radio_error_count << 8) | (uint32_t)sensor_error_count;
 	REG_TIME = ((uint32_t)time_process << 16) | (uint32_t)time_sensor;
+	REG_SCHED = ((uint32_t)sched_overrun << 16) | (uint32_t)sched_missed;
+	REG_SENSOR_PERIOD = ((uint32_t)sensor_period_max << 16) | (uint32_t)sensor_period_min;
+	REG_CAL = ((uint32_t)radio_cal.progress_range << 16) | ((uint32_t)radio_cal.progress_idle << 8) | (uint32_t)mpu_cal.progress;
+	REG_BLACKBOX_STATUS = ((uint32_t)blackbox_dropped << 16) | (blackbox_used / BLACKBOX_PAGE_SIZE);
+	REG_BENCH_RESULT = (REG_BENCH__ITEM < NB_BENCH) ? bench[REG_BENCH__ITEM].best : 0;
 }
 
 void reg_access(host_buffer_rx_t * host_buffer_rx)
@@ -156,21 +323,19 @@ void reg_access(host_buffer_rx_t * host_buffer_rx)
 		case 0: // REG read
 		{
 			reg_update_on_read();
-			if (reg_properties[addr].is_float)
-				host_send((uint8_t*)&regf[addr], 4);
-			else
+			if (addr < NB_REG)
 				host_send((uint8_t*)&reg[addr], 4);
+			else
+				host_send((uint8_t*)&reg_none, 4); // Keep the host in sync
 			break;
 		}
 		case 1: // REG write
 		{
-			if (!reg_properties[addr].read_only)
+			if ((addr < NB_REG) && !reg_properties[addr].read_only)
 			{
-				if (reg_properties[addr].is_float)
-					regf[addr] = host_buffer_rx->data.f;
-				else
-					reg[addr] = host_buffer_rx->data.u32;
-				reg_update_on_write();
+				reg[addr].u = host_buffer_rx->data.u32; // Same bits for float registers
+				reg_dirty |= reg_hook[addr];
+				reg_update_dirty();
 			}
 			break;
 		}
@@ -187,47 +352,24 @@ void reg_access(host_buffer_rx_t * host_buffer_rx)
 		}
 		case 4: // Flash read
 		{
-			host_send((uint8_t*)&flash_r[addr], 4);
+			if (addr < NB_REG)
+				host_send((uint8_t*)&flash_r[addr], 4);
+			else
+				host_send((uint8_t*)&reg_none, 4);
 			break;
 		}
 		case 5: // Flash write
 		{
-			if (FLASH->CR & FLASH_CR_LOCK) {
-				FLASH->KEYR = 0x45670123;
-				FLASH->KEYR = 0xCDEF89AB;
+			if (addr < NB_REG) {
+				reg_job_data[0] = host_buffer_rx->data.u32;
+				reg_job_program(addr, 1, 0);
 			}
-			#ifdef STM32F3
-				FLASH->CR |= FLASH_CR_PG;
-				flash_w[addr*2] = host_buffer_rx->data.u16[0];
-				flash_w[addr*2+1] = host_buffer_rx->data.u16[1];
-				while (FLASH->SR & FLASH_SR_BSY) {}
-				FLASH->CR &= ~FLASH_CR_PG;
-			#elif defined(STM32F4)
-				FLASH->CR |= FLASH_CR_PG | (2 << FLASH_CR_PSIZE_Pos);
-				flash_w[addr] = host_buffer_rx->data.u32;
-				while (FLASH->SR & FLASH_SR_BSY) {}
-				FLASH->CR &= ~FLASH_CR_PG;
-			#endif
 			break;
 		}
 		case 6: // Flash page erase
 		{
-			if (FLASH->CR & FLASH_CR_LOCK) {
-				FLASH->KEYR = 0x45670123;
-				FLASH->KEYR = 0xCDEF89AB;
-			}
-			#ifdef STM32F3
-				FLASH->CR |= FLASH_CR_PER;
-				FLASH->AR = REG_FLASH_ADDR;
-				FLASH->CR |= FLASH_CR_STRT;
-				while (FLASH->SR & FLASH_SR_BSY) {}
-				FLASH->CR &= ~FLASH_CR_PER;
-			#elif defined(STM32F4)
-				FLASH->CR |= FLASH_CR_SER | (11 << FLASH_CR_SNB_Pos);
-				FLASH->CR |= FLASH_CR_STRT;
-				while (FLASH->SR & FLASH_SR_BSY) {}
-				FLASH->CR &= ~FLASH_CR_SER;
-			#endif
+			reg_flash_erase();
+			reg_job = REG_JOB_ERASE;
 			break;
 		}
 		case 7: // SPI read to RF
@@ -241,5 +383,207 @@ void reg_access(host_buffer_rx_t * host_buffer_rx)
 			//RF_WRITE_1(addr, host_buffer_rx->data.u8[3]);
 			break;
 		}
+		case 9: // REG block read
+		{
+			reg_update_on_read();
+			reg_block_read(reg, addr, host_buffer_rx->data.u8[0]);
+			break;
+		}
+		case 10: // REG block write
+		{
+			reg_block_write(host_buffer_rx, 0);
+			break;
+		}
+		case 11: // Blackbox dump
+		{
+			blackbox_dump(host_buffer_rx->data.u32);
+			break;
+		}
+		case 12: // Latency trace block read
+		{
+			latency_read(addr, host_buffer_rx->data.u8[0]);
+			break;
+		}
+		case 13: // Flash block read
+		{
+			reg_block_read((reg_t*)flash_r, addr, host_buffer_rx->data.u8[0]);
+			break;
+		}
+		case 14: // Flash block write
+		{
+			reg_block_write(host_buffer_rx, 1);
+			break;
+		}
 	}
 }
+
+// Run one slice of the host command in progress, return 1 if another slice is needed
+// The flash operations are started here and polled on the next slices instead of waiting on BSY. The CPU still
+// stalls on flash reads while it is busy, the control path of the F303 boards runs from the CCM RAM (FAST_CODE).
+_Bool reg_job_step(void)
+{
+	switch (reg_job)
+	{
+		case REG_JOB_ERASE:
+		{
+			if (reg_flash_busy())
+				return 1;
+			reg_flash_end();
+			break;
+		}
+		case REG_JOB_PROGRAM:
+		{
+			if (reg_flash_busy())
+				return 1;
+			if (reg_job_index < reg_job_count) {
+				reg_flash_program(reg_job_addr + reg_job_index, reg_job_data[reg_job_index]);
+				reg_job_index++;
+				return 1;
+			}
+			reg_flash_end();
+			if (reg_job_answer) {
+				reg_block_status = 0;
+				host_send(&reg_block_status, 1);
+			}
+			break;
+		}
+		case REG_JOB_BENCH:
+		{
+			if (bench_step())
+				return 1;
+			break;
+		}
+	}
+	reg_job = REG_JOB_NONE;
+	
+	return 0;
+}
+
+_Bool reg_job_pending(void)
+{
+	return reg_job != REG_JOB_NONE;
+}
+
+// Program count registers of reg_job_data from addr, a block write answers when the last one is done
+void reg_job_program(uint8_t addr, uint8_t count, _Bool answer)
+{
+	reg_job_addr = addr;
+	reg_job_count = count;
+	reg_job_index = 0;
+	reg_job_answer = answer;
+	reg_job = REG_JOB_PROGRAM;
+}
+
+void reg_flash_unlock(void)
+{
+	if (FLASH->CR & FLASH_CR_LOCK) {
+		FLASH->KEYR = 0x45670123;
+		FLASH->KEYR = 0xCDEF89AB;
+	}
+}
+
+// Start the erase of the register page (sector 11 on the F4)
+void reg_flash_erase(void)
+{
+	reg_flash_unlock();
+	#ifdef STM32F3
+		FLASH->CR |= FLASH_CR_PER;
+		FLASH->AR = REG_FLASH_ADDR;
+		FLASH->CR |= FLASH_CR_STRT;
+	#elif defined(STM32F4)
+		FLASH->CR |= FLASH_CR_SER | (11 << FLASH_CR_SNB_Pos);
+		FLASH->CR |= FLASH_CR_STRT;
+	#elif defined(SIL)
+		sil_flash_erase();
+	#endif
+}
+
+// Start the programming of a register, the F3 programs half-words (the second write stalls until the first is done)
+void reg_flash_program(uint8_t addr, uint32_t data)
+{
+	reg_flash_unlock();
+	#ifdef STM32F3
+		FLASH->CR |= FLASH_CR_PG;
+		flash_w[addr*2] = (uint16_t)data;
+		flash_w[addr*2+1] = (uint16_t)(data >> 16);
+	#elif defined(STM32F4)
+		FLASH->CR |= FLASH_CR_PG | (2 << FLASH_CR_PSIZE_Pos);
+		flash_w[addr] = data;
+	#elif defined(SIL)
+		flash_w[addr] = data;
+	#endif
+}
+
+_Bool reg_flash_busy(void)
+{
+	return (FLASH->SR & FLASH_SR_BSY) != 0;
+}
+
+void reg_flash_end(void)
+{
+	#ifdef STM32F3
+		FLASH->CR &= ~(FLASH_CR_PER | FLASH_CR_PG);
+	#elif defined(STM32F4)
+		FLASH->CR &= ~(FLASH_CR_SER | FLASH_CR_PG);
+	#endif
+}
+
+// Send up to REG_BLOCK_MAX registers from addr, followed by the CRC16 of the data (little endian)
+// The count is clipped to the register map, the host finds the actual count from the answer size
+void reg_block_read(reg_t * src, uint8_t addr, uint8_t count)
+{
+	int i;
+	uint16_t crc;
+	
+	if (addr >= NB_REG)
+		count = 0;
+	else if (count > NB_REG - addr)
+		count = NB_REG - addr;
+	if (count > REG_BLOCK_MAX)
+		count = REG_BLOCK_MAX;
+	
+	for (i=0; i<count; i++)
+		reg_block_tx[i] = src[addr+i].u;
+	
+	crc = crc16((uint8_t*)reg_block_tx, count*4);
+	((uint8_t*)reg_block_tx)[count*4] = (uint8_t)crc;
+	((uint8_t*)reg_block_tx)[count*4+1] = (uint8_t)(crc >> 8);
+	
+	host_send((uint8_t*)reg_block_tx, count*4+2);
+}
+
+// Write count registers (data.u8[0]) from addr, the payload is checked against its CRC16 (data.u16[1])
+// The whole block is rejected if it does not fit in the register map or if the CRC does not match
+// Read-only registers are skipped, the update hooks run once for the whole block
+// The flash is programmed in slices of task_host (reg_job_step), which answers at the end
+void reg_block_write(host_buffer_rx_t * host_buffer_rx, _Bool flash)
+{
+	int i;
+	uint8_t addr = host_buffer_rx->addr;
+	uint8_t count = host_buffer_rx->data.u8[0];
+	
+	if ((count == 0) || (count > REG_BLOCK_MAX) || (addr >= NB_REG) || (count > NB_REG - addr) ||
+	    (crc16((uint8_t*)host_buffer_rx->block, count*4) != host_buffer_rx->data.u16[1])) {
+		reg_block_status = 1;
+		host_send(&reg_block_status, 1);
+		return;
+	}
+	
+	if (flash) {
+		for (i=0; i<count; i++)
+			reg_job_data[i] = host_buffer_rx->block[i];
+		reg_job_program(addr, count, 1);
+		return;
+	}
+	
+	for (i=0; i<count; i++) {
+		if (!reg_properties[addr+i].read_only) {
+			reg[addr+i].u = host_buffer_rx->block[i];
+			reg_dirty |= reg_hook[addr+i];
+		}
+	}
+	reg_update_dirty();
+	
+	reg_block_status = 0;
+	host_send(&reg_block_status, 1);
+}
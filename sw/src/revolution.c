@@ -3,10 +3,23 @@
 #include "radio.h"
 #include "sensor.h"
 #include "usb.h"
+#include "latency.h"
 
 /* Private defines ------------------------------------*/
 
 #define ADC_SCALE 0.0089f
+#define APB1_CLOCK (SystemCoreClock / 4)
+#define APB2_CLOCK (SystemCoreClock / 2)
+#define TIMER_CLOCK (SystemCoreClock / 2) // APB1 timers (x2)
+
+// M25P16 blackbox flash, on SPI3 with the RF chip
+#define M25P16_SPI_CLOCK 20000000 // Max SPI clock of READ
+#define M25P16_WREN 0x06 // Write enable
+#define M25P16_RDSR 0x05 // Read status register
+#define M25P16_READ 0x03
+#define M25P16_PP 0x02 // Page program
+#define M25P16_BE 0xC7 // Bulk erase
+#define M25P16_WIP 0x01 // Write in progress
 
 /* Private types --------------------------------------*/
 
@@ -16,10 +29,13 @@ volatile uint8_t spi1_rx_buffer[16];
 volatile uint8_t spi1_tx_buffer[16];
 volatile uint8_t spi3_rx_buffer[7];
 volatile uint8_t spi3_tx_buffer[7];
+volatile _Bool flag_spi_flash_dma; // Page program in progress on SPI3
+uint8_t spi_flash_dummy; // Rx data of the page program
 volatile uint32_t motor1_dshot[17];
 volatile uint32_t motor2_dshot[17];
 volatile uint32_t motor3_dshot[17];
 volatile uint32_t motor4_dshot[17];
+uint8_t servo_frame; // Motor frames since the last servo pulse (TRI)
 
 /* Private macros ---------------------------------------------------*/
 
@@ -32,6 +48,37 @@ volatile uint32_t motor4_dshot[17];
 #define DMA_CLEAR_ALL_FLAGS_6 (DMA_HIFCR_CTCIF6 | DMA_HIFCR_CHTIF6 | DMA_HIFCR_CTEIF6 |DMA_HIFCR_CDMEIF6 |DMA_HIFCR_CFEIF6)
 #define DMA_CLEAR_ALL_FLAGS_7 (DMA_HIFCR_CTCIF7 | DMA_HIFCR_CHTIF7 | DMA_HIFCR_CTEIF7 |DMA_HIFCR_CDMEIF7 |DMA_HIFCR_CFEIF7)
 
+// Sorted by class, sub-priority only orders pending interrupts of the same class
+const irq_priority_t irq_priority[] =
+{
+	// IRQ, preemption priority, sub-priority
+	{EXTI4_IRQn,               IRQ_PRIO_SENSOR, 1},
+	{SPI1_IRQn,                IRQ_PRIO_SENSOR, 2},
+	{DMA2_Stream0_IRQn,        IRQ_PRIO_SENSOR, 0},
+	{DMA2_Stream3_IRQn,        IRQ_PRIO_SENSOR, 2},
+	{USART1_IRQn,              IRQ_PRIO_RADIO,  1},
+	{DMA2_Stream5_IRQn,        IRQ_PRIO_RADIO,  0},
+	{EXTI0_IRQn,               IRQ_PRIO_RADIO,  2},
+	{SPI3_IRQn,                IRQ_PRIO_RADIO,  3},
+	{DMA1_Stream0_IRQn,        IRQ_PRIO_RADIO,  2},
+	{DMA1_Stream7_IRQn,        IRQ_PRIO_RADIO,  3},
+	{TIM8_TRG_COM_TIM14_IRQn,  IRQ_PRIO_RADIO,  3},
+	{TIM8_BRK_TIM12_IRQn,      IRQ_PRIO_TIMER,  0},
+	{TIM6_DAC_IRQn,            IRQ_PRIO_TIMER,  1},
+	{TIM8_UP_TIM13_IRQn,       IRQ_PRIO_TIMER,  2},
+	{TIM4_IRQn,                IRQ_PRIO_TIMER,  3},
+	{OTG_FS_IRQn,              IRQ_PRIO_HOST,   0}
+};
+
+#define NB_IRQ (sizeof(irq_priority) / sizeof(irq_priority_t))
+
+/* Private functions ------------------------------------------------*/
+
+void spi_flash_select(void);
+void spi_flash_deselect(void);
+uint8_t spi_flash_byte(uint8_t data);
+void spi_flash_command(uint8_t cmd);
+
 /* Functions ------------------------------------------------*/
 
 void sensor_write(uint8_t addr, uint8_t data)
@@ -76,6 +123,103 @@ void rf_read(uint8_t addr, uint8_t size)
 	SPI3->CR1 |= SPI_CR1_SPE;
 }
 
+// The flash is selected with B3, NSS (A15, RF chip) is released during the flash transactions
+void spi_flash_select(void)
+{
+	SPI3->CR2 &= ~SPI_CR2_SSOE;
+	SPI3->CR1 &= ~SPI_CR1_BR_Msk;
+	SPI3->CR1 |= SPI_CR1_SSM | SPI_CR1_SSI | (spi_br(APB1_CLOCK, M25P16_SPI_CLOCK) << SPI_CR1_BR_Pos);
+	GPIOB->BSRR = GPIO_BSRR_BR_3;
+	SPI3->CR1 |= SPI_CR1_SPE;
+}
+
+// Back to the RF configuration
+void spi_flash_deselect(void)
+{
+	while (SPI3->SR & SPI_SR_BSY) {};
+	SPI3->CR1 &= ~SPI_CR1_SPE;
+	GPIOB->BSRR = GPIO_BSRR_BS_3;
+	SPI3->CR1 &= ~(SPI_CR1_SSM | SPI_CR1_SSI | SPI_CR1_BR_Msk);
+	SPI3->CR1 |= spi_br(APB1_CLOCK, SX1276_SPI_CLOCK) << SPI_CR1_BR_Pos;
+	SPI3->CR2 |= SPI_CR2_SSOE;
+}
+
+// Polled transfer, the DMA streams are disabled
+uint8_t spi_flash_byte(uint8_t data)
+{
+	while ((SPI3->SR & SPI_SR_TXE) == 0) {};
+	SPI3->DR = data;
+	while ((SPI3->SR & SPI_SR_RXNE) == 0) {};
+	return (uint8_t)SPI3->DR;
+}
+
+void spi_flash_command(uint8_t cmd)
+{
+	spi_flash_select();
+	spi_flash_byte(cmd);
+	spi_flash_deselect();
+}
+
+// Blocking read, waits for the end of a page program
+void spi_flash_read(uint32_t addr, uint8_t * data, uint16_t size)
+{
+	int i;
+	
+	while (spi_flash_busy()) {};
+	
+	spi_flash_select();
+	spi_flash_byte(M25P16_READ);
+	spi_flash_byte((uint8_t)(addr >> 16));
+	spi_flash_byte((uint8_t)(addr >> 8));
+	spi_flash_byte((uint8_t)addr);
+	for (i=0; i<size; i++)
+		data[i] = spi_flash_byte(0);
+	spi_flash_deselect();
+}
+
+// Program one page with DMA, buf holds SPI_FLASH_CMD_SIZE free bytes followed by the data
+void spi_flash_program(uint32_t addr, uint8_t * buf, uint16_t size)
+{
+	spi_flash_command(M25P16_WREN);
+	
+	buf[0] = M25P16_PP;
+	buf[1] = (uint8_t)(addr >> 16);
+	buf[2] = (uint8_t)(addr >> 8);
+	buf[3] = (uint8_t)addr;
+	
+	flag_spi_flash_dma = 1;
+	DMA1_Stream0->CR &= ~DMA_SxCR_MINC;
+	DMA1_Stream0->M0AR = (uint32_t)&spi_flash_dummy;
+	DMA1_Stream7->M0AR = (uint32_t)buf;
+	DMA1_Stream0->NDTR = size + SPI_FLASH_CMD_SIZE;
+	DMA1_Stream7->NDTR = size + SPI_FLASH_CMD_SIZE;
+	DMA1_Stream0->CR |= DMA_SxCR_EN;
+	DMA1_Stream7->CR |= DMA_SxCR_EN;
+	spi_flash_select();
+}
+
+// Start a bulk erase (about 20s)
+void spi_flash_erase(void)
+{
+	spi_flash_command(M25P16_WREN);
+	spi_flash_command(M25P16_BE);
+}
+
+_Bool spi_flash_busy(void)
+{
+	uint8_t status;
+	
+	if (flag_spi_flash_dma)
+		return 1;
+	
+	spi_flash_select();
+	spi_flash_byte(M25P16_RDSR);
+	status = spi_flash_byte(0);
+	spi_flash_deselect();
+	
+	return (status & M25P16_WIP);
+}
+
 void radio_error_recover()
 {
 	// Disable DMA UART
@@ -120,6 +264,15 @@ __forceinline void rf_error_recover()
 	
 	SPI3->CR1 |= SPI_CR1_MSTR; // Set master bit that could be reset after a SPI error
 	
+	// Abort a flash page program
+	if (flag_spi_flash_dma) {
+		spi_flash_deselect();
+		DMA1_Stream0->M0AR = (uint32_t)spi3_rx_buffer;
+		DMA1_Stream7->M0AR = (uint32_t)spi3_tx_buffer;
+		DMA1_Stream0->CR |= DMA_SxCR_MINC;
+		flag_spi_flash_dma = 0;
+	}
+	
 	rf_error_count++;
 }
 
@@ -151,13 +304,26 @@ void set_motors(uint32_t * motor_raw)
 		DMA1_Stream3->CR |= DMA_SxCR_EN;
 		DMA1_Stream4->CR |= DMA_SxCR_EN;
 	#else
-		TIM3->CCR4 = SERVO_MAX*2 + 1 - SERVO_MIN*2 - motor_raw[0]; // Motor 2
-		TIM5->CCR4 = SERVO_MAX*2 + 1 - SERVO_MIN*2 - motor_raw[1]; // Motor 3
-		TIM2->CCR3 = SERVO_MAX*2 + 1 - SERVO_MIN*2 - motor_raw[2]; // Motor 4
-		TIM5->CCR2 = SERVO_MAX*2 + 1 - SERVO_MIN*2 - motor_raw[3]; // Motor 5
+		#if (AIRFRAME != TRI)
+			TIM3->CCR4 = ONESHOT_COUNT(SERVO_MAX*2 + 1 - SERVO_MIN*2 - motor_raw[0], TIMER_CLOCK); // Motor 2
+		#endif
+		TIM5->CCR4 = ONESHOT_COUNT(SERVO_MAX*2 + 1 - SERVO_MIN*2 - motor_raw[1], TIMER_CLOCK); // Motor 3
+		TIM2->CCR3 = ONESHOT_COUNT(SERVO_MAX*2 + 1 - SERVO_MIN*2 - motor_raw[2], TIMER_CLOCK); // Motor 4
+		TIM5->CCR2 = ONESHOT_COUNT(SERVO_MAX*2 + 1 - SERVO_MIN*2 - motor_raw[3], TIMER_CLOCK); // Motor 5
 	#endif
 	TIM2->CR1 |= TIM_CR1_CEN;
-	TIM3->CR1 |= TIM_CR1_CEN;
+	#if (AIRFRAME == TRI)
+		// Tail servo alone on TIM3 in 0.5us ticks (1000-2000us), pulsed at the servo frame rate
+		// The compare is only written between two pulses
+		servo_frame++;
+		if (servo_frame >= SERVO_DIVIDER) {
+			servo_frame = 0;
+			TIM3->CCR4 = SERVO_MAX*2 + 1 - SERVO_MIN*2 - motor_raw[0]; // Servo 2
+			TIM3->CR1 |= TIM_CR1_CEN;
+		}
+	#else
+		TIM3->CR1 |= TIM_CR1_CEN;
+	#endif
 	TIM5->CR1 |= TIM_CR1_CEN;
 }
 
@@ -176,12 +342,12 @@ void set_mpu_host(_Bool host)
 	if (host) {
 		DMA2_Stream0->M0AR = (uint32_t)spi1_rx_buffer;
 		SPI1->CR1 &= ~SPI_CR1_BR_Msk;
-		SPI1->CR1 |= 5 << SPI_CR1_BR_Pos; // SPI clock = clock APB2/64 = 48MHz/64 = 750kHz
+		SPI1->CR1 |= spi_br(APB2_CLOCK, MPU_SPI_CLOCK_REG) << SPI_CR1_BR_Pos; // 750kHz at 96MHz
 	}
 	else {
 		DMA2_Stream0->M0AR = (uint32_t)&sensor_raw;
 		SPI1->CR1 &= ~SPI_CR1_BR_Msk;
-		SPI1->CR1 |= 1 << SPI_CR1_BR_Pos; // SPI clock = clock APB2/4 = 48MHz/4 = 12MHz
+		SPI1->CR1 |= spi_br(APB2_CLOCK, MPU_SPI_CLOCK_DATA) << SPI_CR1_BR_Pos; // 12MHz at 96MHz
 	}
 }
 
@@ -201,8 +367,8 @@ void reset_timeout_radio()
 
 void host_send(uint8_t * data, uint8_t size)
 {
-	USBD_CDC_SetTxBuffer(&USBD_device_handler, data, size);
-	USBD_CDC_TransmitPacket(&USBD_device_handler);
+	if (usb_send(data, size))
+		NVIC_SetPendingIRQ(OTG_FS_IRQn); // Start the transfer from the USB interrupt if it is idle
 }
 
 uint16_t get_timer_process(void)
@@ -226,6 +392,7 @@ void EXTI0_IRQHandler()
 void EXTI4_IRQHandler() 
 {
 	EXTI->PR = EXTI_PR_PR4; // Clear pending request
+	latency_stamp(LATENCY_DATA_READY);
 	if ((REG_CTRL__SENSOR_HOST_CTRL == 0) && ((SPI1->SR & SPI_SR_BSY) == 0)) {
 		sensor_read(59,14);
 		timer_sensor[0] = TIM7->CNT; // SPI transaction time
@@ -259,7 +426,8 @@ void DMA2_Stream0_IRQHandler()
 		}
 		else {
 			TIM12->CNT = 0; // Reset timeout
-			flag_sensor = 1; // Raise flag for sample ready
+			latency_stamp(LATENCY_SENSOR_DONE);
+			sensor_ready(); // Raise flag or run control task
 		}
 	}
 	
@@ -296,7 +464,15 @@ void DMA1_Stream0_IRQHandler()
 		while ((DMA1_Stream0->CR & DMA_SxCR_EN) && (DMA1_Stream7->CR & DMA_SxCR_EN)) {};
 		SPI3->CR1 &= ~SPI_CR1_SPE;
 	
-		if (flag_rf_host_read){
+		if (flag_spi_flash_dma) {
+			// End of a flash page program, back to the RF buffers
+			spi_flash_deselect();
+			DMA1_Stream0->M0AR = (uint32_t)spi3_rx_buffer;
+			DMA1_Stream7->M0AR = (uint32_t)spi3_tx_buffer;
+			DMA1_Stream0->CR |= DMA_SxCR_MINC;
+			flag_spi_flash_dma = 0;
+		}
+		else if (flag_rf_host_read){
 			flag_rf_host_read = 0;
 			host_send((uint8_t*)&spi3_rx_buffer[1],1);
 		}
@@ -405,6 +581,7 @@ void TIM8_TRG_COM_TIM14_IRQHandler()
 void OTG_FS_IRQHandler(void)
 {
 	HAL_PCD_IRQHandler(&PCD_handler);
+	usb_tx_service();
 }
 
 /* INIT -----------------------------------------------------------------
@@ -412,33 +589,45 @@ void OTG_FS_IRQHandler(void)
 
 void board_init()
 {
+	int i;
+	
 	/* RCC --------------------------------------------------------*/
 	
 	// Enable XTAL oscillator
 	RCC->CR |= RCC_CR_HSEON;
 	while ((RCC->CR & RCC_CR_HSERDY) == 0) {}
 	
+	RCC->PLLCFGR &= ~(RCC_PLLCFGR_PLLM_Msk | RCC_PLLCFGR_PLLN_Msk | RCC_PLLCFGR_PLLQ_Msk);
+#if (SYSCLK == 168000000)
+	// Set VCO at 336 MHz = XTAL(8MHz) * (N=336) / (M=8)
+	// PLL system = VCO / ((P=0,default)+2) = 168 MHz , PLL USB = VCO / (Q=7) = 48 MHz
+	RCC->PLLCFGR |= (8 << RCC_PLLCFGR_PLLM_Pos) | (336 << RCC_PLLCFGR_PLLN_Pos) | RCC_PLLCFGR_PLLSRC | (7 << RCC_PLLCFGR_PLLQ_Pos);
+#else
 	// Set VCO at 192 MHz = XTAL(8MHz) * (N=192) / (M=8)
 	// PLL system = VCO / ((P=0,default)+2) = 96 MHz , PLL USB = VCO / (Q=4) = 48 MHz
-	RCC->PLLCFGR &= ~(RCC_PLLCFGR_PLLM_Msk | RCC_PLLCFGR_PLLN_Msk | RCC_PLLCFGR_PLLQ_Msk);
 	RCC->PLLCFGR |= (8 << RCC_PLLCFGR_PLLM_Pos) | (192 << RCC_PLLCFGR_PLLN_Pos) | RCC_PLLCFGR_PLLSRC | (4 << RCC_PLLCFGR_PLLQ_Pos);
+#endif
 	RCC->CR |= RCC_CR_PLLON;
 	while ((RCC->CR & RCC_CR_PLLRDY) == 0) {}
 	
 	// Select PLL as system clock
+#if (SYSCLK == 168000000)
+	FLASH->ACR |= (5 << FLASH_ACR_LATENCY_Pos) | FLASH_ACR_ICEN | FLASH_ACR_DCEN | FLASH_ACR_PRFTEN; // Inrease Flash latency, enable ART cache and prefetch
+#else
 	FLASH->ACR |= (3 << FLASH_ACR_LATENCY_Pos);// | FLASH_ACR_PRFTEN; // Inrease Flash latency + Prefetch?
+#endif
 	RCC->CFGR |= RCC_CFGR_SW_PLL;
 	while ((RCC->CFGR & RCC_CFGR_SWS_PLL) == 0) {}
-	SystemCoreClock = 96000000;
+	SystemCoreClock = SYSCLK;
 	
 	// Disable internal high-speed RC
 	RCC->CR &= ~RCC_CR_HSION;
 	
-	// Set APB1 at 24 MHz (96/4) and APB2 at 48 MHz (96/2)
+	// Set APB1 at SYSCLK/4 (24 or 42 MHz) and APB2 at SYSCLK/2 (48 or 84 MHz)
 	RCC->CFGR |= RCC_CFGR_PPRE1_DIV4 | RCC_CFGR_PPRE2_DIV2;
 	
 	// Configure SysTick to generate interrupt every ms
-	SysTick_Config(96000);
+	SysTick_Config(SystemCoreClock / 1000);
 	
 	/* Clock enable --------------------------------------------------*/
 	
@@ -520,6 +709,10 @@ void board_init()
 	GPIOB->MODER |= GPIO_MODER_MODER1_1;
 	GPIOB->OSPEEDR |= GPIO_OSPEEDER_OSPEEDR1_1;
 	GPIOB->AFR[0] |= 2 << GPIO_AFRL_AFSEL1_Pos;
+	// B3 : SPI3 flash CS
+	GPIOB->MODER |= GPIO_MODER_MODER3_0;
+	GPIOB->OSPEEDR |= GPIO_OSPEEDER_OSPEEDR3_1;
+	GPIOB->BSRR = GPIO_BSRR_BS_3;
 	// B4 : Red LED, need open-drain (external pull-up)
 	GPIOB->MODER |= GPIO_MODER_MODER4_0;
 	GPIOB->OTYPER |= GPIO_OTYPER_OT_4;
@@ -605,21 +798,22 @@ void board_init()
 	/* Timers --------------------------------------------------------------------------*/
 	
 #if (ESC == DSHOT)
-	// DMA driven timer for DShot600, 12Mhz, 0:15, 1:30, T:40
+	// DMA driven timer for DShot600, 0:37.5%, 1:75%
+	dshot_init(TIMER_CLOCK / DSHOT_RATE);
 	TIM2->PSC = 0;
-	TIM2->ARR = 80;
+	TIM2->ARR = TIMER_CLOCK / DSHOT_RATE;
 	TIM2->DIER = TIM_DIER_CC3DE;
 	TIM2->CCER = TIM_CCER_CC3E;
 	TIM2->CCMR2 = (6 << TIM_CCMR2_OC3M_Pos) | TIM_CCMR2_OC3PE;
 	
 	TIM3->PSC = 0;
-	TIM3->ARR = 80;
+	TIM3->ARR = TIMER_CLOCK / DSHOT_RATE;
 	TIM3->DIER = TIM_DIER_CC4DE;
 	TIM3->CCER = TIM_CCER_CC4E;
 	TIM3->CCMR2 = (6 << TIM_CCMR2_OC4M_Pos) | TIM_CCMR2_OC4PE;
 	
 	TIM5->PSC = 0;
-	TIM5->ARR = 80;
+	TIM5->ARR = TIMER_CLOCK / DSHOT_RATE;
 	TIM5->DIER = TIM_DIER_CC2DE | TIM_DIER_CC4DE;
 	TIM5->CCER = TIM_CCER_CC2E | TIM_CCER_CC4E;
 	TIM5->CCMR1 = (6 << TIM_CCMR1_OC2M_Pos) | TIM_CCMR1_OC2PE;
@@ -627,79 +821,86 @@ void board_init()
 #else
 	// One-pulse mode for OneShot125
 	TIM2->CR1 = TIM_CR1_OPM;
-	TIM2->PSC = 3-1;
-	TIM2->ARR = SERVO_MAX*2 + 1;
+	TIM2->PSC = 0;
+	TIM2->ARR = ONESHOT_COUNT(SERVO_MAX*2 + 1, TIMER_CLOCK);
 	TIM2->CCER = TIM_CCER_CC3E;
 	TIM2->CCMR2 = 7 << TIM_CCMR2_OC3M_Pos;
 	
 	TIM3->CR1 = TIM_CR1_OPM;
-	TIM3->PSC = 3-1;
-	TIM3->ARR = SERVO_MAX*2 + 1;
+	#if (AIRFRAME == TRI)
+		// Servo pulse, 0.5us tick
+		TIM3->PSC = TIMER_CLOCK / 2000000 - 1;
+		TIM3->ARR = SERVO_MAX*2 + 1;
+		TIM3->EGR = TIM_EGR_UG; // Prescaler loaded before the first pulse
+	#else
+		TIM3->PSC = 0;
+		TIM3->ARR = ONESHOT_COUNT(SERVO_MAX*2 + 1, TIMER_CLOCK);
+	#endif
 	TIM3->CCER = TIM_CCER_CC4E;
 	TIM3->CCMR2 = 7 << TIM_CCMR2_OC4M_Pos;
 	
 	TIM5->CR1 = TIM_CR1_OPM;
-	TIM5->PSC = 3-1;
-	TIM5->ARR = SERVO_MAX*2 + 1;
+	TIM5->PSC = 0;
+	TIM5->ARR = ONESHOT_COUNT(SERVO_MAX*2 + 1, TIMER_CLOCK);
 	TIM5->CCER = TIM_CCER_CC2E | TIM_CCER_CC4E;
 	TIM5->CCMR1 = 7 << TIM_CCMR1_OC2M_Pos;
 	TIM5->CCMR2 = 7 << TIM_CCMR2_OC4M_Pos;
 #endif
 
 	// Beeper
-	TIM4->PSC = 48000-1; // 1ms
-	TIM4->ARR = BEEPER_PERIOD;
+	TIM4->PSC = TIMER_PSC_100US(TIMER_CLOCK);
+	TIM4->ARR = BEEPER_PERIOD*10; // ms
 	TIM4->DIER = TIM_DIER_UIE;
 	TIM4->CR1 = TIM_CR1_CEN;
 	
 	// Receiver timeout
-	TIM6->PSC = 48000-1; // 1ms
-	TIM6->ARR = TIMEOUT_RADIO;
+	TIM6->PSC = TIMER_PSC_100US(TIMER_CLOCK);
+	TIM6->ARR = TIMEOUT_RADIO*10; // ms
 	TIM6->DIER = TIM_DIER_UIE;
 	//TIM6->CR1 = TIM_CR1_CEN; // To be enabled after radio init
 	
 	// Processing time
-	TIM7->PSC = 48-1; // 1us
+	TIM7->PSC = TIMER_PSC_US(TIMER_CLOCK);
 	TIM7->ARR = 65535;
 	TIM7->CR1 = TIM_CR1_CEN;
 	
 	// Sensor timeout
-	TIM12->PSC = 48-1; // 1us
+	TIM12->PSC = TIMER_PSC_US(TIMER_CLOCK);
 	TIM12->ARR = TIMEOUT_SENSOR;
 	TIM12->DIER = TIM_DIER_UIE;
 	//TIM12->CR1 = TIM_CR1_CEN; // To be enabled after sensor init
 	
 	// VBAT
-	TIM13->PSC = 48000-1; // 1ms
-	TIM13->ARR = VBAT_PERIOD;
+	TIM13->PSC = TIMER_PSC_100US(TIMER_CLOCK);
+	TIM13->ARR = VBAT_PERIOD*10; // ms
 	TIM13->DIER = TIM_DIER_UIE;
 	//TIM13->CR1 = TIM_CR1_CEN;
 	
 	// RF tempo
-	TIM14->PSC = 48000-1; // 1ms
-	TIM14->ARR = 200;
+	TIM14->PSC = TIMER_PSC_100US(TIMER_CLOCK);
+	TIM14->ARR = 200*10; // ms
 	TIM14->DIER = TIM_DIER_UIE;
 	
 	/* UART ---------------------------------------------------*/
 
 #if (RADIO_TYPE == SBUS)
 	GPIOC->BSRR = GPIO_BSRR_BS_0; // Invert Rx
-	USART1->BRR = 480; // 48MHz/100000bps
+	USART1->BRR = APB2_CLOCK / 100000; // 100000bps
 	USART1->CR1 = USART_CR1_UE | USART_CR1_M | USART_CR1_PCE;
 	USART1->CR2 = (2 << USART_CR2_STOP_Pos);
 #else
 	GPIOC->BSRR = GPIO_BSRR_BR_0; // Do not invert Rx
-	USART1->BRR = 417; // 48MHz/115200bps
+	USART1->BRR = APB2_CLOCK / 115200; // 115200bps
 	USART1->CR1 = USART_CR1_UE;
 #endif
 	USART1->CR3 = USART_CR3_EIE;
 	
 	/* SPI ----------------------------------------------------*/
 	
-	SPI1->CR1 = SPI_CR1_MSTR | (5 << SPI_CR1_BR_Pos) | SPI_CR1_CPOL | SPI_CR1_CPHA; // SPI clock = clock APB2/64 = 48MHz/64 = 750 kHz
+	SPI1->CR1 = SPI_CR1_MSTR | (spi_br(APB2_CLOCK, MPU_SPI_CLOCK_REG) << SPI_CR1_BR_Pos) | SPI_CR1_CPOL | SPI_CR1_CPHA; // SPI clock < 1MHz, APB2/64 = 750 kHz at 96MHz
 	SPI1->CR2 = SPI_CR2_SSOE | SPI_CR2_TXDMAEN | SPI_CR2_RXDMAEN | SPI_CR2_ERRIE;
 
-	SPI3->CR1 = SPI_CR1_MSTR | (1 << SPI_CR1_BR_Pos); // SPI clock = clock APB1/4 = 24MHz/4 = 6 MHz
+	SPI3->CR1 = SPI_CR1_MSTR | (spi_br(APB1_CLOCK, SX1276_SPI_CLOCK) << SPI_CR1_BR_Pos); // SPI clock < 10MHz, APB1/4 = 6 MHz at 96MHz
 	SPI3->CR2 = SPI_CR2_SSOE | SPI_CR2_TXDMAEN | SPI_CR2_RXDMAEN | SPI_CR2_ERRIE;
 
 	/* ADC -----------------------------------------------------*/
@@ -717,39 +918,11 @@ void board_init()
 	EXTI->RTSR = EXTI_RTSR_TR4 | EXTI_RTSR_TR0; // Rising edge
 	//EXTI->IMR = EXTI_IMR_MR4 | EXTI_IMR_MR0; // To be enabled after sensor init
 	
-	NVIC_EnableIRQ(EXTI0_IRQn);
-	NVIC_EnableIRQ(EXTI4_IRQn);
-	NVIC_EnableIRQ(USART1_IRQn);
-	NVIC_EnableIRQ(SPI1_IRQn);
-	NVIC_EnableIRQ(SPI3_IRQn);
-	NVIC_EnableIRQ(DMA1_Stream0_IRQn);
-	NVIC_EnableIRQ(DMA1_Stream7_IRQn);
-	NVIC_EnableIRQ(DMA2_Stream0_IRQn);
-	NVIC_EnableIRQ(DMA2_Stream3_IRQn);
-	NVIC_EnableIRQ(DMA2_Stream5_IRQn);
-	NVIC_EnableIRQ(TIM4_IRQn);
-	NVIC_EnableIRQ(TIM6_DAC_IRQn);
-	NVIC_EnableIRQ(TIM8_BRK_TIM12_IRQn);
-	NVIC_EnableIRQ(TIM8_UP_TIM13_IRQn);
-	NVIC_EnableIRQ(TIM8_TRG_COM_TIM14_IRQn);
-	NVIC_EnableIRQ(OTG_FS_IRQn);
-	
-	NVIC_SetPriority(EXTI0_IRQn,0);
-	NVIC_SetPriority(EXTI4_IRQn,0);
-	NVIC_SetPriority(USART1_IRQn,0);
-	NVIC_SetPriority(SPI1_IRQn,0);
-	NVIC_SetPriority(SPI3_IRQn,0);
-	NVIC_SetPriority(DMA1_Stream0_IRQn,0);
-	NVIC_SetPriority(DMA1_Stream7_IRQn,0);
-	NVIC_SetPriority(DMA2_Stream0_IRQn,0);
-	NVIC_SetPriority(DMA2_Stream3_IRQn,0);
-	NVIC_SetPriority(DMA2_Stream5_IRQn,0);
-	NVIC_SetPriority(TIM4_IRQn,0);
-	NVIC_SetPriority(TIM6_DAC_IRQn,0);
-	NVIC_SetPriority(TIM8_BRK_TIM12_IRQn,0);
-	NVIC_SetPriority(TIM8_UP_TIM13_IRQn,0);
-	NVIC_SetPriority(TIM8_TRG_COM_TIM14_IRQn,0);
-	NVIC_SetPriority(OTG_FS_IRQn,16);
+	NVIC_SetPriorityGrouping(IRQ_PRIORITY_GROUP);
+	for (i=0; i<NB_IRQ; i++) {
+		NVIC_SetPriority(irq_priority[i].irq, NVIC_EncodePriority(IRQ_PRIORITY_GROUP, irq_priority[i].preempt, irq_priority[i].sub));
+		NVIC_EnableIRQ(irq_priority[i].irq);
+	}
 	
 	/* Host init -------------------------------------------*/
 	
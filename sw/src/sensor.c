@@ -6,8 +6,10 @@
 
 /* Private defines --------------------------------------*/
 
-#define MPU_GYRO_SCALE 0.061035f
-#define MPU_ACCEL_SCALE 0.00048828f
+#define MPU_CAL_SAMPLES 1000
+#define DRIFT_DECIMATION 64 // Samples between two updates of the drift fit
+#define DRIFT_FORGET (1.0f - 1.0f / 1024.0f) // ~1 min memory at 1kHz
+#define DRIFT_STILL 2.0f // deg/s, maximum rate to learn the drift
 
 /* Private macros --------------------------------------*/
 
@@ -15,6 +17,9 @@
 
 /* Global variables ----------------------------------*/
 
+struct drift_s drift;
+struct mpu_cal_s mpu_cal;
+
 /* Function definitions ----------------------------------*/
 
 void mpu6000_init(void)
@@ -59,10 +64,14 @@ void mpu9150_init(void)
 	SENSOR_WRITE(MPU_INT_EN, MPU_INT_EN__DATA_RDY_EN);
 }
 
-void mpu_process_samples(sensor_raw_t * sensor_raw, struct sensor_s * sensor)
+FAST_CODE void mpu_process_samples(sensor_raw_t * sensor_raw, struct sensor_s * sensor)
 {
 	int i;
 	uint8_t x;
+	float t;
+	float drift_x;
+	float drift_y;
+	float drift_z;
 	
 	for (i=1; i<15; i=i+2){
 		x = sensor_raw->bytes[i+1];
@@ -70,74 +79,145 @@ void mpu_process_samples(sensor_raw_t * sensor_raw, struct sensor_s * sensor)
 		sensor_raw->bytes[i] = x;
 	}
 	
+	// Temperature drift of the gyro bias (LSB), linear from the calibration temperature
+	sensor->temperature = (float)sensor_raw->sensor.temperature * MPU_TEMP_SCALE + MPU_TEMP_OFFSET;
+	t = sensor->temperature - REG_GYRO_TC_TEMP;
+	drift_x = REG_GYRO_TC_X * t;
+	drift_y = REG_GYRO_TC_Y * t;
+	drift_z = REG_GYRO_TC_Z * t;
+	
 	#if (SENSOR_ORIENTATION == 90)
-		sensor->gyro_y = -(float)(sensor_raw->sensor.gyro_x - (int16_t)uint32_to_int32(REG_GYRO_DC_XY__X)) * MPU_GYRO_SCALE;
-		sensor->gyro_x = -(float)(sensor_raw->sensor.gyro_y - (int16_t)uint32_to_int32(REG_GYRO_DC_XY__Y)) * MPU_GYRO_SCALE;
+		sensor->gyro_y = -((float)(sensor_raw->sensor.gyro_x - (int16_t)uint32_to_int32(REG_GYRO_DC_XY__X)) - drift_x) * MPU_GYRO_SCALE;
+		sensor->gyro_x = -((float)(sensor_raw->sensor.gyro_y - (int16_t)uint32_to_int32(REG_GYRO_DC_XY__Y)) - drift_y) * MPU_GYRO_SCALE;
 		sensor->accel_x =  (float)(sensor_raw->sensor.accel_x - (int16_t)uint32_to_int32(REG_ACCEL_DC_XY__X)) * MPU_ACCEL_SCALE;
 		sensor->accel_y = -(float)(sensor_raw->sensor.accel_y - (int16_t)uint32_to_int32(REG_ACCEL_DC_XY__Y)) * MPU_ACCEL_SCALE;
 	#elif (SENSOR_ORIENTATION == 180)
-		sensor->gyro_x =  (float)(sensor_raw->sensor.gyro_x - (int16_t)uint32_to_int32(REG_GYRO_DC_XY__X)) * MPU_GYRO_SCALE;
-		sensor->gyro_y = -(float)(sensor_raw->sensor.gyro_y - (int16_t)uint32_to_int32(REG_GYRO_DC_XY__Y)) * MPU_GYRO_SCALE;
+		sensor->gyro_x =  ((float)(sensor_raw->sensor.gyro_x - (int16_t)uint32_to_int32(REG_GYRO_DC_XY__X)) - drift_x) * MPU_GYRO_SCALE;
+		sensor->gyro_y = -((float)(sensor_raw->sensor.gyro_y - (int16_t)uint32_to_int32(REG_GYRO_DC_XY__Y)) - drift_y) * MPU_GYRO_SCALE;
 		sensor->accel_y = (float)(sensor_raw->sensor.accel_x - (int16_t)uint32_to_int32(REG_ACCEL_DC_XY__X)) * MPU_ACCEL_SCALE;
 		sensor->accel_x = (float)(sensor_raw->sensor.accel_y - (int16_t)uint32_to_int32(REG_ACCEL_DC_XY__Y)) * MPU_ACCEL_SCALE;
 	#else
-		sensor->gyro_x = -(float)(sensor_raw->sensor.gyro_x - (int16_t)uint32_to_int32(REG_GYRO_DC_XY__X)) * MPU_GYRO_SCALE;
-		sensor->gyro_y =  (float)(sensor_raw->sensor.gyro_y - (int16_t)uint32_to_int32(REG_GYRO_DC_XY__Y)) * MPU_GYRO_SCALE;
+		sensor->gyro_x = -((float)(sensor_raw->sensor.gyro_x - (int16_t)uint32_to_int32(REG_GYRO_DC_XY__X)) - drift_x) * MPU_GYRO_SCALE;
+		sensor->gyro_y =  ((float)(sensor_raw->sensor.gyro_y - (int16_t)uint32_to_int32(REG_GYRO_DC_XY__Y)) - drift_y) * MPU_GYRO_SCALE;
 		sensor->accel_y = -(float)(sensor_raw->sensor.accel_x - (int16_t)uint32_to_int32(REG_ACCEL_DC_XY__X)) * MPU_ACCEL_SCALE;
 		sensor->accel_x = -(float)(sensor_raw->sensor.accel_y - (int16_t)uint32_to_int32(REG_ACCEL_DC_XY__Y)) * MPU_ACCEL_SCALE;
 	#endif
-	sensor->gyro_z = -(float)(sensor_raw->sensor.gyro_z - (int16_t)uint32_to_int32(REG_GYRO_DC_Z)) * MPU_GYRO_SCALE;
+	sensor->gyro_z = -((float)(sensor_raw->sensor.gyro_z - (int16_t)uint32_to_int32(REG_GYRO_DC_Z)) - drift_z) * MPU_GYRO_SCALE;
 	sensor->accel_z = (float)(sensor_raw->sensor.accel_z - (int16_t)uint32_to_int32(REG_ACCEL_DC_Z)) * MPU_ACCEL_SCALE;
-	sensor->temperature = (float)sensor_raw->sensor.temperature / 340.0f + 36.53f;
 }
 
-void mpu_cal(sensor_raw_t * sensor_raw)
+// DC offset calibration, one sample per call of mpu_cal_step (already byte swapped by mpu_process_samples)
+// With CONTROL_LOOP == SENSOR_ISR, mpu_cal_step runs in the sensor interrupt: no sample before the sums are cleared
+void mpu_cal_start(void)
+{
+	__disable_irq();
+	mpu_cal.count = 0;
+	mpu_cal.progress = 0;
+	mpu_cal.gyro_x_dc = 0;
+	mpu_cal.gyro_y_dc = 0;
+	mpu_cal.gyro_z_dc = 0;
+	mpu_cal.accel_x_dc = 0;
+	mpu_cal.accel_y_dc = 0;
+	mpu_cal.accel_z_dc = 0;
+	mpu_cal.temperature = 0;
+	mpu_cal.running = 1;
+	__enable_irq();
+}
+
+void mpu_cal_stop(void)
+{
+	mpu_cal.running = 0;
+}
+
+void mpu_cal_step(sensor_raw_t * sensor_raw)
+{
+	if (!mpu_cal.running)
+		return;
+	
+	mpu_cal.gyro_x_dc += (float)sensor_raw->sensor.gyro_x;
+	mpu_cal.gyro_y_dc += (float)sensor_raw->sensor.gyro_y;
+	mpu_cal.gyro_z_dc += (float)sensor_raw->sensor.gyro_z;
+	mpu_cal.accel_x_dc += (float)sensor_raw->sensor.accel_x;
+	mpu_cal.accel_y_dc += (float)sensor_raw->sensor.accel_y;
+	mpu_cal.accel_z_dc += (float)sensor_raw->sensor.accel_z;
+	mpu_cal.temperature += (float)sensor_raw->sensor.temperature;
+	
+	if ((mpu_cal.count & 0x1F) == 0)
+		toggle_led_sensor();
+	
+	mpu_cal.count++;
+	mpu_cal.progress = (uint8_t)(mpu_cal.count * 100 / MPU_CAL_SAMPLES);
+	if (mpu_cal.count < MPU_CAL_SAMPLES)
+		return;
+	
+	REG_GYRO_DC_XY = int32_to_uint32((int32_t)(mpu_cal.gyro_x_dc / (float)MPU_CAL_SAMPLES)) + (int32_to_uint32((int32_t)(mpu_cal.gyro_y_dc / (float)MPU_CAL_SAMPLES)) << 16);
+	REG_GYRO_DC_Z = int32_to_uint32((int32_t)(mpu_cal.gyro_z_dc / (float)MPU_CAL_SAMPLES));
+	REG_ACCEL_DC_XY = int32_to_uint32((int32_t)(mpu_cal.accel_x_dc / (float)MPU_CAL_SAMPLES)) + (int32_to_uint32((int32_t)(mpu_cal.accel_y_dc / (float)MPU_CAL_SAMPLES)) << 16);
+	REG_ACCEL_DC_Z = int32_to_uint32((int32_t)(mpu_cal.accel_z_dc / (float)MPU_CAL_SAMPLES - 1.0f/MPU_ACCEL_SCALE));
+	REG_GYRO_TC_TEMP = mpu_cal.temperature / (float)MPU_CAL_SAMPLES * MPU_TEMP_SCALE + MPU_TEMP_OFFSET;
+	
+	// The drift learnt so far was relative to the previous offsets
+	gyro_drift_reset();
+	
+	mpu_cal.running = 0;
+}
+
+void gyro_drift_reset(void)
 {
-	uint16_t sensor_sample_count = 0;
 	int i;
-	uint8_t x;
 	
-	float gyro_x_dc = 0;
-	float gyro_y_dc = 0;
-	float gyro_z_dc = 0;
-	float accel_x_dc = 0;
-	float accel_y_dc = 0;
-	float accel_z_dc = 0;
-	
-	while (sensor_sample_count < 1000)
-	{
-		if (flag_sensor)
-		{
-			flag_sensor = 0;
-			
-			for (i=1; i<15; i=i+2){
-				x = sensor_raw->bytes[i+1];
-				sensor_raw->bytes[i+1] = sensor_raw->bytes[i];
-				sensor_raw->bytes[i] = x;
-			}
-			
-			gyro_x_dc += (float)sensor_raw->sensor.gyro_x;
-			gyro_y_dc += (float)sensor_raw->sensor.gyro_y;
-			gyro_z_dc += (float)sensor_raw->sensor.gyro_z;
-			accel_x_dc += (float)sensor_raw->sensor.accel_x;
-			accel_y_dc += (float)sensor_raw->sensor.accel_y;
-			accel_z_dc += (float)sensor_raw->sensor.accel_z;
-			
-			if ((sensor_sample_count & 0x1F) == 0)
-				toggle_led_sensor();
-			
-			sensor_sample_count++;
-		}
-		__wfi();
+	drift.count = 0;
+	drift.n = 0;
+	drift.sx = 0;
+	drift.sxx = 0;
+	for (i=0; i<3; i++) {
+		drift.sy[i] = 0;
+		drift.sxy[i] = 0;
+	}
+}
+
+// Online least squares fit of the gyro bias against the temperature, while the sensor is still (disarmed)
+// One point every DRIFT_DECIMATION samples, with exponential forgetting.
+// The slopes are updated once the temperature has moved by more than TEMP_SPAN (standard deviation)
+void gyro_drift_learn(sensor_raw_t * sensor_raw, struct sensor_s * sensor)
+{
+	int i;
+	float x;
+	float y[3];
+	float det;
+	float span;
+	
+	if ((fabsf(sensor->gyro_x) > DRIFT_STILL) || (fabsf(sensor->gyro_y) > DRIFT_STILL) || (fabsf(sensor->gyro_z) > DRIFT_STILL))
+		return;
+	if (++drift.count < DRIFT_DECIMATION)
+		return;
+	drift.count = 0;
+	
+	x = sensor->temperature - REG_GYRO_TC_TEMP;
+	y[0] = (float)(sensor_raw->sensor.gyro_x - (int16_t)uint32_to_int32(REG_GYRO_DC_XY__X));
+	y[1] = (float)(sensor_raw->sensor.gyro_y - (int16_t)uint32_to_int32(REG_GYRO_DC_XY__Y));
+	y[2] = (float)(sensor_raw->sensor.gyro_z - (int16_t)uint32_to_int32(REG_GYRO_DC_Z));
+	
+	drift.n = DRIFT_FORGET * drift.n + 1.0f;
+	drift.sx = DRIFT_FORGET * drift.sx + x;
+	drift.sxx = DRIFT_FORGET * drift.sxx + x * x;
+	for (i=0; i<3; i++) {
+		drift.sy[i] = DRIFT_FORGET * drift.sy[i] + y[i];
+		drift.sxy[i] = DRIFT_FORGET * drift.sxy[i] + x * y[i];
 	}
 	
-	REG_GYRO_DC_XY = int32_to_uint32((int32_t)(gyro_x_dc / 1000.0f)) + (int32_to_uint32((int32_t)(gyro_y_dc / 1000.0f)) << 16);
-	REG_GYRO_DC_Z = int32_to_uint32((int32_t)(gyro_z_dc / 1000.0f));
-	REG_ACCEL_DC_XY = int32_to_uint32((int32_t)(accel_x_dc / 1000.0f)) + (int32_to_uint32((int32_t)(accel_y_dc / 1000.0f)) << 16);
-	REG_ACCEL_DC_Z = int32_to_uint32((int32_t)(accel_z_dc / 1000.0f - 1.0f/MPU_ACCEL_SCALE));
+	// n^2 * variance of the temperature
+	det = drift.n * drift.sxx - drift.sx * drift.sx;
+	span = (float)REG_GYRO_TC__TEMP_SPAN * 0.1f * drift.n;
+	if (det < span * span)
+		return;
+	
+	REG_GYRO_TC_X = (drift.n * drift.sxy[0] - drift.sx * drift.sy[0]) / det;
+	REG_GYRO_TC_Y = (drift.n * drift.sxy[1] - drift.sx * drift.sy[1]) / det;
+	REG_GYRO_TC_Z = (drift.n * drift.sxy[2] - drift.sx * drift.sy[2]) / det;
 }
 
-void angle_estimate(struct sensor_s * sensor, struct angle_s * angle, _Bool yaw_transfer_is_on)
+FAST_CODE void angle_estimate(struct sensor_s * sensor, struct angle_s * angle, _Bool yaw_transfer_is_on)
 {
 	float vector_magnitude;
 	float angle_transfer;
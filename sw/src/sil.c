@@ -0,0 +1,508 @@
+#include <time.h> // clock_gettime
+#include <math.h> // lrintf
+#include "board.h"
+#include "fc.h"
+#include "radio.h"
+#include "sensor.h"
+#include "pid.h"
+#include "mixer.h"
+#include "bench.h"
+#include "latency.h"
+#include "sil_host.h"
+
+/* Private defines ------------------------------------*/
+
+#define SIL_SPI_TIME 20 // us, sensor transaction time reported to task_sensor
+#define SIL_TIMING_SENSOR NB_STAGE // Whole sample: sensor_ready and the tasks it releases
+#define SIL_TIMING_RADIO (NB_STAGE + 1)
+
+#if (SIL_NB_TIMING != NB_STAGE + 2) || (SIL_NB_OUTPUT != NB_OUTPUT) || (SIL_NB_BENCH != NB_BENCH)
+	#error "sil_host.h does not match fc.h, board.h or bench.h"
+#endif
+#if (AIRFRAME == TRI)
+	#error "The tail servo of the tricopter is not simulated"
+#endif
+
+/* Private functions ------------------------------------------------*/
+
+uint64_t sil_clock(void);
+void sil_timing_add(uint8_t timing, uint64_t t);
+void sil_timers(uint32_t period);
+void sil_run(uint8_t timing, uint64_t t);
+void sil_sample(uint32_t period);
+int16_t sil_mpu_lsb(float x, float scale);
+
+/* Global variables --------------------------------------*/
+
+// Globals of fc.c that are not exported
+extern struct sensor_s sensor;
+extern struct angle_s angle;
+extern struct radio_s radio;
+extern struct pid_s pid;
+extern float setpoint[NB_AXIS];
+extern uint32_t motor_raw[NB_OUTPUT];
+extern uint32_t sensor_time;
+
+SysTick_Type sil_systick;
+FLASH_TypeDef sil_flash_reg;
+uint32_t sil_flash[NB_REG]; // Config page, erased at each sil_init
+
+struct sil_timing_s sil_timing[SIL_NB_TIMING];
+const char * const sil_timing_name[SIL_NB_TIMING] =
+{
+	"radio_decode",
+	"mpu_process_samples",
+	"angle_estimate",
+	"pid_update",
+	"mixer_run",
+	"set_motors",
+	"sensor sample",
+	"radio frame"
+};
+
+void (*sil_send)(const uint8_t * data, uint8_t size);
+uint64_t sil_stage_start[NB_STAGE];
+uint32_t sil_time; // us, time of the last sensor sample
+uint32_t sil_time_radio; // Last radio frame or radio timeout
+uint32_t sil_time_vbat;
+float sil_vbat_value;
+uint32_t sil_motor_dshot[NB_OUTPUT][17];
+
+/* Board functions ------------------------------------------------*/
+
+void board_init(void)
+{
+	sil_flash_erase();
+	#if (ESC == DSHOT)
+		dshot_init(SYSCLK / DSHOT_RATE);
+	#endif
+}
+
+void host_send(uint8_t * data, uint8_t size)
+{
+	if (sil_send)
+		sil_send(data, size);
+}
+
+void sensor_write(uint8_t addr, uint8_t data)
+{
+	(void)addr;
+	(void)data;
+}
+
+void sensor_read(uint8_t addr, uint8_t size)
+{
+	(void)addr;
+	(void)size;
+}
+
+void rf_write(uint8_t addr, uint8_t * data, uint8_t size)
+{
+	(void)addr;
+	(void)data;
+	(void)size;
+}
+
+void rf_read(uint8_t addr, uint8_t size)
+{
+	(void)addr;
+	(void)size;
+}
+
+// DShot frames are encoded like on the board, the commands are read back by sil_output
+void set_motors(uint32_t * motor_raw)
+{
+	#if (ESC == DSHOT)
+		int i;
+		
+		for (i=0; i<NB_OUTPUT; i++)
+			dshot_encode(&motor_raw[i], sil_motor_dshot[i]);
+	#else
+		(void)motor_raw;
+	#endif
+}
+
+void toggle_led_sensor(void)
+{
+	
+}
+
+void toggle_led_radio(void)
+{
+	
+}
+
+void set_mpu_host(_Bool host)
+{
+	(void)host;
+}
+
+float get_vbat(void)
+{
+	return sil_vbat_value;
+}
+
+void reset_timeout_radio(void)
+{
+	sil_time_radio = sil_time;
+}
+
+// The tasks take no time on the simulated clock, the schedule does not depend on the host
+uint16_t get_timer_process(void)
+{
+	return (uint16_t)sil_time;
+}
+
+void radio_error_recover(void)
+{
+	
+}
+
+void spi_flash_read(uint32_t addr, uint8_t * data, uint16_t size)
+{
+	int i;
+	
+	(void)addr;
+	for (i=0; i<size; i++)
+		data[i] = 0xFF;
+}
+
+void spi_flash_program(uint32_t addr, uint8_t * buf, uint16_t size)
+{
+	(void)addr;
+	(void)buf;
+	(void)size;
+}
+
+void spi_flash_erase(void)
+{
+	
+}
+
+_Bool spi_flash_busy(void)
+{
+	return 0;
+}
+
+void sil_flash_erase(void)
+{
+	int i;
+	
+	for (i=0; i<NB_REG; i++)
+		sil_flash[i] = 0xFFFFFFFF;
+}
+
+/* Stage timing ------------------------------------------------*/
+
+uint64_t sil_clock(void)
+{
+	struct timespec ts;
+	
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t)ts.tv_sec * 1000000000 + (uint64_t)ts.tv_nsec;
+}
+
+void sil_timing_add(uint8_t timing, uint64_t t)
+{
+	struct sil_timing_s * s = &sil_timing[timing];
+	
+	if ((s->count == 0) || (t < s->min))
+		s->min = t;
+	if (t > s->max)
+		s->max = t;
+	s->total += t;
+	s->count++;
+}
+
+void sil_stage_begin(uint8_t stage)
+{
+	sil_stage_start[stage] = sil_clock();
+}
+
+void sil_stage_end(uint8_t stage)
+{
+	sil_timing_add(stage, sil_clock() - sil_stage_start[stage]);
+}
+
+void sil_timing_reset(void)
+{
+	int i;
+	
+	for (i=0; i<SIL_NB_TIMING; i++) {
+		sil_timing[i].count = 0;
+		sil_timing[i].total = 0;
+		sil_timing[i].min = 0;
+		sil_timing[i].max = 0;
+	}
+}
+
+uint32_t sil_clock_ticks(void)
+{
+	return (uint32_t)sil_clock();
+}
+
+/* Host interface ------------------------------------------------*/
+
+// Power on, the registers are reset to their defaults
+void sil_init(void)
+{
+	sil_time = 0;
+	sil_time_radio = 0;
+	sil_time_vbat = 0;
+	sil_vbat_value = 0;
+	sil_timing_reset();
+	
+	fc_init();
+}
+
+void sil_set_host(void (*send)(const uint8_t * data, uint8_t size))
+{
+	sil_send = send;
+}
+
+// Timer interrupts of the boards: sensor timeout, radio timeout and VBAT period
+void sil_timers(uint32_t period)
+{
+	if (period > TIMEOUT_SENSOR)
+		flag_timeout_sensor = 1;
+	
+	if (sil_time - sil_time_radio >= TIMEOUT_RADIO * 1000) {
+		sil_time_radio = sil_time;
+		flag_timeout_radio = 1;
+	}
+	
+	if (sil_time - sil_time_vbat >= VBAT_PERIOD * 1000) {
+		sil_time_vbat = sil_time;
+		flag_vbat = 1;
+	}
+}
+
+// Main loop until no task can run
+void sil_run(uint8_t timing, uint64_t t)
+{
+	while (fc_run()) {}
+	sil_timing_add(timing, sil_clock() - t);
+}
+
+// New sample in sensor_raw after the period (us), read by the SPI at the start of the period
+void sil_sample(uint32_t period)
+{
+	uint64_t t;
+	
+	sil_time += period;
+	sil_timers(period);
+	
+	timer_sensor[0] = (uint16_t)sil_time;
+	timer_sensor[1] = (uint16_t)(sil_time + SIL_SPI_TIME);
+	
+	t = sil_clock();
+	latency_stamp(LATENCY_DATA_READY);
+	latency_stamp(LATENCY_SENSOR_DONE);
+	sensor_ready();
+	sil_run(SIL_TIMING_SENSOR, t);
+}
+
+// Sample period (us) and payload of TELEMETRY_SENSOR_RAW (sensor_raw after the byte swap of mpu_process_samples),
+// the bytes are put back in the order of the sensor
+void sil_sensor(uint32_t period, const uint8_t raw[SIL_SENSOR_RAW_SIZE])
+{
+	int i;
+	
+	sensor_raw.bytes[0] = 0;
+	for (i=1; i<15; i=i+2) {
+		sensor_raw.bytes[i] = raw[i];
+		sensor_raw.bytes[i+1] = raw[i-1];
+	}
+	sensor_raw.bytes[15] = 0;
+	
+	sil_sample(period);
+}
+
+// ADC output of the MPU6000 for a measure, rounded and saturated
+int16_t sil_mpu_lsb(float x, float scale)
+{
+	float lsb = x / scale;
+	
+	if (lsb > 32767.0f)
+		return 32767;
+	if (lsb < -32768.0f)
+		return -32768;
+	return (int16_t)lrintf(lsb);
+}
+
+// Measures in the frame of struct sensor_s (deg/s, g and C), converted to the big endian registers of the MPU6000
+// for SENSOR_ORIENTATION, the inverse of mpu_process_samples without the offsets
+void sil_mpu(uint32_t period, const float gyro[3], const float accel[3], float temperature)
+{
+	int i;
+	uint8_t x;
+	struct sensor_raw_s * s = &sensor_raw.sensor;
+	
+	s->dummy = 0;
+	#if (SENSOR_ORIENTATION == 90)
+		s->gyro_x = sil_mpu_lsb(-gyro[1], MPU_GYRO_SCALE);
+		s->gyro_y = sil_mpu_lsb(-gyro[0], MPU_GYRO_SCALE);
+		s->accel_x = sil_mpu_lsb(accel[0], MPU_ACCEL_SCALE);
+		s->accel_y = sil_mpu_lsb(-accel[1], MPU_ACCEL_SCALE);
+	#elif (SENSOR_ORIENTATION == 180)
+		s->gyro_x = sil_mpu_lsb(gyro[0], MPU_GYRO_SCALE);
+		s->gyro_y = sil_mpu_lsb(-gyro[1], MPU_GYRO_SCALE);
+		s->accel_x = sil_mpu_lsb(accel[1], MPU_ACCEL_SCALE);
+		s->accel_y = sil_mpu_lsb(accel[0], MPU_ACCEL_SCALE);
+	#else
+		s->gyro_x = sil_mpu_lsb(-gyro[0], MPU_GYRO_SCALE);
+		s->gyro_y = sil_mpu_lsb(gyro[1], MPU_GYRO_SCALE);
+		s->accel_x = sil_mpu_lsb(-accel[1], MPU_ACCEL_SCALE);
+		s->accel_y = sil_mpu_lsb(-accel[0], MPU_ACCEL_SCALE);
+	#endif
+	s->gyro_z = sil_mpu_lsb(-gyro[2], MPU_GYRO_SCALE);
+	s->accel_z = sil_mpu_lsb(accel[2], MPU_ACCEL_SCALE);
+	s->temperature = sil_mpu_lsb(temperature - MPU_TEMP_OFFSET, MPU_TEMP_SCALE);
+	
+	for (i=1; i<15; i=i+2) {
+		x = sensor_raw.bytes[i+1];
+		sensor_raw.bytes[i+1] = sensor_raw.bytes[i];
+		sensor_raw.bytes[i] = x;
+	}
+	sensor_raw.bytes[15] = 0;
+	
+	sil_sample(period);
+}
+
+// Channels of TELEMETRY_RADIO_RAW (struct radio_raw_s), sent as a frame of RADIO_TYPE
+// The unused channels are centered, the checksum is not checked by radio_decode
+void sil_radio(const uint16_t raw[SIL_RADIO_NB_CHAN])
+{
+	int i;
+	uint64_t t;
+	
+#if (RADIO_TYPE == IBUS)
+	radio_frame.frame.header = 0x4020;
+	for (i=0; i<14; i++)
+		radio_frame.frame.chan[i] = 1500;
+	radio_frame.frame.chan[0] = raw[1];
+	radio_frame.frame.chan[1] = raw[2];
+	radio_frame.frame.chan[2] = raw[0];
+	radio_frame.frame.chan[3] = raw[3];
+	for (i=0; i<4; i++)
+		radio_frame.frame.chan[4 + i] = raw[4 + i];
+	radio_frame.frame.checksum = 0;
+#elif (RADIO_TYPE == SUMD)
+	radio_frame.frame.vendor_id = 0xA8;
+	radio_frame.frame.status = 0x01;
+	radio_frame.frame.nb_chan = 12;
+	for (i=0; i<12; i++)
+		radio_frame.frame.chan[i] = 12000;
+	for (i=0; i<SIL_RADIO_NB_CHAN; i++)
+		radio_frame.frame.chan[i] = raw[i];
+	radio_frame.frame.checksum = 0;
+#elif (RADIO_TYPE == SBUS)
+	for (i=0; i<(int)sizeof(radio_frame); i++)
+		radio_frame.bytes[i] = 0;
+	radio_frame.frame.header = 0x0F;
+	radio_frame.frame.chan0 = raw[1];
+	radio_frame.frame.chan1 = raw[2];
+	radio_frame.frame.chan2 = raw[0];
+	radio_frame.frame.chan3 = raw[3];
+	radio_frame.frame.chan4 = raw[4];
+	radio_frame.frame.chan5 = raw[5];
+	radio_frame.frame.chan6 = raw[6];
+	radio_frame.frame.chan7 = raw[7];
+#endif
+	
+	t = sil_clock();
+	flag_radio = 1;
+	sil_run(SIL_TIMING_RADIO, t);
+}
+
+// Normalised sticks in the order of struct radio_raw_s, the inverse of radio_decode with the stick calibration
+// Throttle and aux from 0 to 1, aileron, elevator and rudder from -1 to 1
+void sil_sticks(const float stick[SIL_RADIO_NB_CHAN])
+{
+	int i;
+	uint16_t raw[SIL_RADIO_NB_CHAN];
+	
+	raw[0] = (uint16_t)lrintf((float)REG_THROTTLE__IDLE + stick[0] * (float)REG_THROTTLE__RANGE);
+	raw[1] = (uint16_t)lrintf((float)REG_AILERON__IDLE + stick[1] * (float)REG_AILERON__RANGE);
+	raw[2] = (uint16_t)lrintf((float)REG_ELEVATOR__IDLE + stick[2] * (float)REG_ELEVATOR__RANGE);
+	raw[3] = (uint16_t)lrintf((float)REG_RUDDER__IDLE + stick[3] * (float)REG_RUDDER__RANGE);
+	for (i=0; i<4; i++)
+		raw[4 + i] = (uint16_t)lrintf((float)AUX_IDLE_DEFAULT + stick[4 + i] * (float)AUX_RANGE_DEFAULT);
+	
+	sil_radio(raw);
+}
+
+// Input of the ADC, filtered by task_vbat
+void sil_vbat(float vbat)
+{
+	sil_vbat_value = vbat;
+}
+
+uint32_t sil_reg_read(uint8_t addr)
+{
+	reg_update_on_read();
+	return (addr < NB_REG) ? reg[addr].u : 0;
+}
+
+// Through the host protocol, read-only registers are ignored and the update hooks run
+void sil_reg_write(uint8_t addr, uint32_t value)
+{
+	host_buffer_rx_t cmd;
+	
+	cmd.instr = 1;
+	cmd.addr = addr;
+	cmd.data.u32 = value;
+	reg_access(&cmd);
+}
+
+void sil_output(struct sil_output_s * output)
+{
+	int i;
+	
+	output->time = sensor_time;
+	output->armed = flag_armed;
+	output->acro = flag_acro;
+	output->gyro[0] = sensor.gyro_x;
+	output->gyro[1] = sensor.gyro_y;
+	output->gyro[2] = sensor.gyro_z;
+	output->accel[0] = sensor.accel_x;
+	output->accel[1] = sensor.accel_y;
+	output->accel[2] = sensor.accel_z;
+	output->angle[0] = angle.pitch;
+	output->angle[1] = angle.roll;
+	output->radio[0] = radio.throttle;
+	output->radio[1] = radio.pitch;
+	output->radio[2] = radio.roll;
+	output->radio[3] = radio.yaw;
+	for (i=0; i<NB_AXIS; i++) {
+		output->setpoint[i] = setpoint[i];
+		output->pid[i] = pid.out[i];
+	}
+	for (i=0; i<NB_OUTPUT; i++)
+		output->motor[i] = motor_raw[i];
+}
+
+// Motors start at the first output (no tail servo)
+void sil_airframe(struct sil_airframe_s * airframe)
+{
+	int i;
+	int j;
+	
+	for (i=0; i<SIL_NB_OUTPUT; i++) {
+		for (j=0; j<3; j++)
+			airframe->coef[i][j] = (i < mixer_table[AIRFRAME].nb_motor) ? mixer_table[AIRFRAME].coef[i][j] : 0.0f;
+	}
+	airframe->dshot = (ESC == DSHOT);
+}
+
+// Benchmarks of the control path (bench.c), the registers keep their values
+void sil_bench(struct sil_bench_s result[SIL_NB_BENCH], const char * name[SIL_NB_BENCH])
+{
+	int i;
+	
+	bench_run();
+	for (i=0; i<SIL_NB_BENCH; i++) {
+		result[i].best = bench[i].best;
+		name[i] = bench_name[i];
+	}
+}
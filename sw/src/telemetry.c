@@ -0,0 +1,142 @@
+#include "telemetry.h"
+#include "reg.h" // DEBUG registers
+#include "board.h" // host_send
+#include "utils.h" // crc16, varint_encode
+
+/* Private functions ------------------------------------------------*/
+
+uint8_t telemetry_encode(uint8_t channel, void * data, int32_t x[TELEMETRY_FIELD_MAX], uint8_t * code);
+
+/* Global variables --------------------------------------*/
+
+// Sizes and scales must match the payloads of fc.c and the host decoders
+const struct telemetry_coding_s telemetry_coding[TELEMETRY_NB_CHANNEL] =
+{
+	{TELEMETRY_INT16,  7,         {0}}, // Raw sensors
+	{TELEMETRY_FLOAT,  7,         {16.0f, 16.0f, 16.0f, 1000.0f, 1000.0f, 1000.0f, 100.0f}}, // 1/16 deg/s, mg, 0.01 C
+	{TELEMETRY_FLOAT,  4,         {100.0f, 100.0f, 100.0f, 100.0f}}, // 0.01 deg
+	{TELEMETRY_UINT16, 8,         {0}}, // Raw radio
+	{TELEMETRY_FLOAT,  8,         {1000.0f, 1000.0f, 1000.0f, 1000.0f, 1000.0f, 1000.0f, 1000.0f, 1000.0f}},
+	{TELEMETRY_FLOAT,  3,         {16.0f, 16.0f, 16.0f}},
+	{TELEMETRY_UINT32, NB_OUTPUT, {0}}, // Raw motors
+	{TELEMETRY_FLOAT,  1,         {1000.0f}} // mV
+};
+
+int32_t telemetry_z[TELEMETRY_NB_CHANNEL][TELEMETRY_FIELD_MAX]; // Last values sent
+uint8_t telemetry_count[TELEMETRY_NB_CHANNEL]; // Payloads sent
+
+/* Function definitions ----------------------------------*/
+
+// Return 1 if the channel is selected and its decimation is reached
+_Bool telemetry_due(uint8_t channel, uint16_t count)
+{
+	uint16_t mask;
+	
+	if ((REG_DEBUG & (1 << channel)) == 0)
+		return 0;
+	
+	mask = (1 << ((REG_DEBUG_RATE >> (4 * channel)) & 0x0F)) - 1;
+	return ((count & mask) == 0);
+}
+
+void telemetry_start(struct telemetry_s * telemetry, uint32_t time)
+{
+	telemetry->buf[0] = TELEMETRY_SYNC_0;
+	telemetry->buf[1] = REG_DEBUG_DELTA__ENABLE ? TELEMETRY_SYNC_1_DELTA : TELEMETRY_SYNC_1;
+	telemetry->buf[2] = 0; // Payload size
+	telemetry->buf[3] = 0; // Channels
+	telemetry->buf[4] = telemetry->seq;
+	telemetry->buf[5] = (uint8_t)time;
+	telemetry->buf[6] = (uint8_t)(time >> 8);
+	telemetry->buf[7] = (uint8_t)(time >> 16);
+	telemetry->buf[8] = (uint8_t)(time >> 24);
+	telemetry->size = TELEMETRY_HEADER_SIZE;
+}
+
+// Channels must be added by increasing number, a payload that does not fit is dropped
+void telemetry_add(struct telemetry_s * telemetry, uint8_t channel, void * data, uint8_t size)
+{
+	int i;
+	uint8_t code[1 + 5 * TELEMETRY_FIELD_MAX];
+	int32_t x[TELEMETRY_FIELD_MAX];
+	_Bool delta;
+	
+	delta = (telemetry->buf[1] == TELEMETRY_SYNC_1_DELTA);
+	if (delta) {
+		size = telemetry_encode(channel, data, x, code);
+		data = code;
+	}
+	
+	if (telemetry->size + size + 2 > TELEMETRY_SIZE_MAX)
+		return;
+	
+	for (i=0; i<size; i++)
+		telemetry->buf[telemetry->size + i] = ((uint8_t*)data)[i];
+	telemetry->size += size;
+	telemetry->buf[2] += size;
+	telemetry->buf[3] |= 1 << channel;
+	
+	// The decoder follows the values actually sent
+	if (delta) {
+		for (i=0; i<telemetry_coding[channel].nb; i++)
+			telemetry_z[channel][i] = x[i];
+		telemetry_count[channel]++;
+	}
+}
+
+// Quantise the fields of a payload in x and encode them, return the size of the code
+// A keyframe every 2^KEYFRAME payloads of the channel lets the decoder resume after a lost frame
+uint8_t telemetry_encode(uint8_t channel, void * data, int32_t x[TELEMETRY_FIELD_MAX], uint8_t * code)
+{
+	int i;
+	const struct telemetry_coding_s * coding = &telemetry_coding[channel];
+	uint8_t * p = (uint8_t*)data;
+	float f;
+	_Bool key;
+	uint8_t n;
+	
+	key = ((telemetry_count[channel] & ((1 << REG_DEBUG_DELTA__KEYFRAME) - 1)) == 0);
+	code[0] = (telemetry_count[channel] & 0x7F) | (key ? TELEMETRY_KEYFRAME : 0);
+	n = 1;
+	
+	for (i=0; i<coding->nb; i++) {
+		// Byte access, the raw payloads are not aligned
+		switch (coding->type) {
+			case TELEMETRY_INT16:
+				x[i] = (int16_t)(p[2*i] | (p[2*i+1] << 8));
+				break;
+			case TELEMETRY_UINT16:
+				x[i] = (int32_t)(p[2*i] | (p[2*i+1] << 8));
+				break;
+			case TELEMETRY_UINT32:
+				x[i] = (int32_t)(p[4*i] | (p[4*i+1] << 8) | (p[4*i+2] << 16) | ((uint32_t)p[4*i+3] << 24));
+				break;
+			default:
+				f = ((float*)data)[i] * coding->scale[i];
+				x[i] = (int32_t)(f + ((f < 0) ? -0.5f : 0.5f));
+				break;
+		}
+		
+		if (key)
+			n += varint_encode(&code[n], zigzag_encode(x[i]));
+		else
+			n += varint_encode(&code[n], zigzag_encode(x[i] - telemetry_z[channel][i]));
+	}
+	
+	return n;
+}
+
+// Send the frame if it has any payload
+void telemetry_send(struct telemetry_s * telemetry)
+{
+	uint16_t crc;
+	
+	if (telemetry->buf[3] == 0)
+		return;
+	
+	crc = crc16(&telemetry->buf[2], telemetry->size - 2);
+	telemetry->buf[telemetry->size] = (uint8_t)crc;
+	telemetry->buf[telemetry->size + 1] = (uint8_t)(crc >> 8);
+	host_send(telemetry->buf, telemetry->size + 2);
+	telemetry->seq++;
+}
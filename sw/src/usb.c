@@ -1,8 +1,21 @@
 #include "fc.h"
 #include "usbd_cdc_if.h"
 #include "usbd_desc.h"
+#include "usb.h"
+
+/* Global variables --------------------------------------*/
 
 USBD_HandleTypeDef USBD_device_handler;
+uint16_t usb_tx_dropped; // Messages that did not fit in the ring
+
+// Transmit ring: written by usb_send (thread mode and the control task in the sensor interrupt), read by the USB interrupt
+uint8_t usb_tx_ring[USB_TX_RING_SIZE];
+volatile uint16_t usb_tx_head; // Next byte to write, only moved by usb_send
+volatile uint16_t usb_tx_tail; // Next byte to send, only moved by the USB interrupt
+uint16_t usb_tx_size; // Size of the packet in flight
+_Bool usb_tx_busy;
+
+/* Function definitions ----------------------------------*/
 
 void usb_init(void)
 {
@@ -17,3 +30,69 @@ void usb_init(void)
 	USBD_Start(&USBD_device_handler);
 }
 
+// Queue a message for the host, the whole message is dropped if the ring is full
+// The data is copied, the caller may reuse its buffer at once
+// The copy runs with the interrupts masked: a producer in an interrupt (SENSOR_ISR telemetry) must not preempt another
+// one between the read and the update of usb_tx_head. It is at most 255 bytes (host_send), a few us.
+_Bool usb_send(uint8_t * data, uint16_t size)
+{
+	uint32_t primask = __get_PRIMASK(); // May be called with the interrupts already masked
+	uint16_t head;
+	uint16_t i;
+	
+	__disable_irq();
+	head = usb_tx_head;
+	if (size > ((usb_tx_tail - head - 1) & (USB_TX_RING_SIZE - 1))) {
+		usb_tx_dropped++;
+		__set_PRIMASK(primask);
+		return 0;
+	}
+	
+	for (i=0; i<size; i++)
+		usb_tx_ring[(head + i) & (USB_TX_RING_SIZE - 1)] = data[i];
+	
+	usb_tx_head = (head + size) & (USB_TX_RING_SIZE - 1); // Publish
+	__set_PRIMASK(primask);
+	
+	return 1;
+}
+
+// Free the packet that was sent and start the next one, with as much queued data as fits in a packet
+// Runs in the USB interrupt only: from the IN complete callback and when usb_send pends the interrupt
+void usb_tx_service(void)
+{
+	USBD_CDC_HandleTypeDef * hcdc = (USBD_CDC_HandleTypeDef*)USBD_device_handler.pClassData;
+	uint16_t size;
+	
+	if ((hcdc == NULL) || hcdc->TxState)
+		return;
+	
+	if (usb_tx_busy) {
+		usb_tx_busy = 0;
+		usb_tx_tail = (usb_tx_tail + usb_tx_size) & (USB_TX_RING_SIZE - 1);
+	}
+	
+	size = (usb_tx_head - usb_tx_tail) & (USB_TX_RING_SIZE - 1);
+	if (size == 0) {
+		// A transfer that ends on a full packet needs a zero length packet
+		if (usb_tx_size != CDC_DATA_FS_MAX_PACKET_SIZE)
+			return;
+	}
+	if (size > CDC_DATA_FS_MAX_PACKET_SIZE)
+		size = CDC_DATA_FS_MAX_PACKET_SIZE;
+	if (size > USB_TX_RING_SIZE - usb_tx_tail) // No wrap inside a packet
+		size = USB_TX_RING_SIZE - usb_tx_tail;
+	
+	usb_tx_size = size;
+	usb_tx_busy = 1;
+	USBD_CDC_SetTxBuffer(&USBD_device_handler, &usb_tx_ring[usb_tx_tail], size);
+	USBD_CDC_TransmitPacket(&USBD_device_handler);
+}
+
+// Flush the ring when the USB is (re)configured
+void usb_tx_reset(void)
+{
+	usb_tx_busy = 0;
+	usb_tx_size = 0;
+	usb_tx_tail = usb_tx_head;
+}
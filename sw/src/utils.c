@@ -1,7 +1,10 @@
 #include "utils.h"
 #include "fc.h"
+#include "board.h" // FAST_CODE
 
 volatile uint32_t tick;
+uint32_t dshot_bit0;
+uint32_t dshot_bit1;
 
 /*--- System timer ---*/
 void SysTick_Handler()
@@ -46,23 +49,41 @@ int32_t uint32_to_int32(uint32_t x)
 	return i2u.i;
 }
 
-void dshot_encode(volatile uint32_t* val, volatile uint32_t buf[17])
+// Duty cycle of DShot bits from the timer period (bit time): 0 = 37.5%, 1 = 75%
+void dshot_init(uint32_t timer_period)
+{
+	dshot_bit0 = (timer_period * 3) / 8;
+	dshot_bit1 = (timer_period * 3) / 4;
+}
+
+FAST_CODE void dshot_encode(volatile uint32_t* val, volatile uint32_t buf[17])
 {
 	int i;
 	uint8_t bit[11];
 	for (i=0; i<11; i++)
 	{
-		buf[i] = (*val & (1 << (10-i))) ? 60 : 30;
+		buf[i] = (*val & (1 << (10-i))) ? dshot_bit1 : dshot_bit0;
 		bit[i] = (*val & (1 << i)) ? 1 : 0;
 	}
-	buf[11] = 30;
-	buf[12] = (bit[10]^bit[6]^bit[2]) ? 60 : 30;
-	buf[13] = (bit[ 9]^bit[5]^bit[1]) ? 60 : 30;
-	buf[14] = (bit[ 8]^bit[4]^bit[0]) ? 60 : 30;
-	buf[15] = (bit[ 7]^bit[3])        ? 60 : 30;
+	buf[11] = dshot_bit0;
+	buf[12] = (bit[10]^bit[6]^bit[2]) ? dshot_bit1 : dshot_bit0;
+	buf[13] = (bit[ 9]^bit[5]^bit[1]) ? dshot_bit1 : dshot_bit0;
+	buf[14] = (bit[ 8]^bit[4]^bit[0]) ? dshot_bit1 : dshot_bit0;
+	buf[15] = (bit[ 7]^bit[3])        ? dshot_bit1 : dshot_bit0;
 	buf[16] = 0;
 }
 
+// SPI baud rate control: smallest divider (2^(BR+1)) keeping the SPI clock under f_max
+uint32_t spi_br(uint32_t clock, uint32_t f_max)
+{
+	uint32_t br = 0;
+	
+	while ((br < 7) && ((clock >> (br + 1)) > f_max))
+		br++;
+	
+	return br;
+}
+
 float expo(float lin)
 {
 	float x;
@@ -99,3 +120,43 @@ float sinus(float angle)
 	//x = x * angle * angle; y += x *  2.755731922e-6f;
 	return y;
 }
+
+// CRC-16/CCITT (polynomial 0x1021, initial value 0xFFFF)
+uint16_t crc16(uint8_t * data, uint32_t size)
+{
+	uint16_t crc = 0xFFFF;
+	int i;
+	
+	while (size--) {
+		crc ^= (uint16_t)(*data++) << 8;
+		for (i=0; i<8; i++) {
+			if (crc & 0x8000)
+				crc = (crc << 1) ^ 0x1021;
+			else
+				crc = crc << 1;
+		}
+	}
+	
+	return crc;
+}
+
+// Signed to unsigned, small magnitudes give small numbers: 0, -1, 1, -2 -> 0, 1, 2, 3
+uint32_t zigzag_encode(int32_t x)
+{
+	return ((uint32_t)x << 1) ^ (uint32_t)(x >> 31);
+}
+
+// LEB128: 7 bits per byte from the least significant, bit 7 set if more bytes follow
+// Return the number of bytes (5 max)
+uint8_t varint_encode(uint8_t * buf, uint32_t x)
+{
+	uint8_t n = 0;
+	
+	while (x >= 0x80) {
+		buf[n++] = (uint8_t)x | 0x80;
+		x >>= 7;
+	}
+	buf[n++] = (uint8_t)x;
+	
+	return n;
+}
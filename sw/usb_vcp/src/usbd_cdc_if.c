@@ -74,13 +74,15 @@ static int8_t USBD_CDC_IF_Init     (void);
 static int8_t USBD_CDC_IF_DeInit   (void);
 static int8_t USBD_CDC_IF_Control  (uint8_t cmd, uint8_t* pbuf, uint16_t length);
 static int8_t USBD_CDC_IF_Receive  (uint8_t* pbuf, uint32_t *Len);
+static int8_t USBD_CDC_IF_TransmitCplt (uint8_t* pbuf, uint32_t *Len, uint8_t epnum);
 
 USBD_CDC_ItfTypeDef USBD_CDC_IF_fops = 
 {
 	USBD_CDC_IF_Init,
 	USBD_CDC_IF_DeInit,
 	USBD_CDC_IF_Control,
-	USBD_CDC_IF_Receive
+	USBD_CDC_IF_Receive,
+	USBD_CDC_IF_TransmitCplt
 };
 
 USBD_CDC_LineCodingTypeDef linecoding =
@@ -103,6 +105,7 @@ static int8_t USBD_CDC_IF_Init(void)
 {
 	USBD_CDC_SetRxBuffer(&USBD_device_handler, (uint8_t *)&host_buffer_rx);
 	USBD_CDC_ReceivePacket(&USBD_device_handler);
+	usb_tx_reset();
 	return (0);
 }
 
@@ -213,6 +216,20 @@ static int8_t USBD_CDC_IF_Receive (uint8_t* Buf, uint32_t *Len)
 	return (0);
 }
 
+/**
+  * @brief  USBD_CDC_IF_TransmitCplt
+  *         Data transmitted over USB IN endpoint, send the next queued packet
+  * @param  Buf: Buffer of data that was sent
+  * @param  Len: Number of data sent (in bytes)
+  * @param  epnum: IN endpoint number
+  * @retval Result of the operation: USBD_OK if all operations are OK else USBD_FAIL
+  */
+static int8_t USBD_CDC_IF_TransmitCplt (uint8_t* Buf, uint32_t *Len, uint8_t epnum)
+{
+	usb_tx_service();
+	return (0);
+}
+
 /**
   * @}
   */ 